@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+#include <exception>
+#include <iostream>
+#include "BatchReconstructor.h"
+#include "Graphics/ImageManager.h"
+#include "Platform/FailureHandling/Exception.h"
+#include "Platform/ParametersManager.h"
+#include "SurfaceReconstruction/Image/Image.h"
+#include "SurfaceReconstruction/Scene/CapturedScene.h"
+#include "SurfaceReconstruction/Scene/SyntheticScene.h"
+#include "Utilities/RandomManager.h"
+
+using namespace FailureHandling;
+using namespace Graphics;
+using namespace Platform;
+using namespace std;
+using namespace SurfaceReconstruction;
+using namespace Utilities;
+
+Scene::Stage BatchReconstructor::getStage(const string &name)
+{
+	if ("tree" == name)
+		return Scene::STAGE_TREE;
+	if ("occupancy" == name)
+		return Scene::STAGE_OCCUPANCY;
+	if ("crust" == name)
+		return Scene::STAGE_CRUST;
+	if ("fssf" == name)
+		return Scene::STAGE_REFINEMENT;
+
+	return Scene::STAGE_COUNT;
+}
+
+void BatchReconstructor::printUsage()
+{
+	cerr << "Required arguments:\n";
+	cerr << "<path/program config file> <path>InputData.txt/InputDataSynthetic.txt/<pathToPreviousRunRootFolder> [options]\n";
+	cerr << "Options:\n";
+	cerr << "-start <stage>: discard loaded intermediate results of <stage> and later stages and compute them again (a result passed via -fssf is kept as refinement start)\n";
+	cerr << "-stop <stage>: stop after <stage>\n";
+	cerr << "-fssf <result>: relative name of FSSF reconstruction result of a previous run as new start (name without path to results folder)\n";
+	cerr << "Stages in processing order: tree, occupancy, crust, fssf\n";
+	cerr << flush;
+}
+
+BatchReconstructor::BatchReconstructor(const vector<string> &arguments) :
+	mScene(NULL), mFirstStage(Scene::STAGE_TREE), mLastStage(Scene::STAGE_REFINEMENT), mDiscardLoadedStages(false), mValidArguments(false)
+{
+	mValidArguments = parseArguments(arguments);
+	if (!mValidArguments)
+		printUsage();
+}
+
+BatchReconstructor::~BatchReconstructor()
+{
+	// free scene data
+	delete mScene;
+
+	// free resources
+	Image::freeMemory();
+
+	// free managers
+	if (ImageManager::exists())
+		delete ImageManager::getSingletonPointer();
+	if (RandomManager::exists())
+		delete RandomManager::getSingletonPointer();
+	if (ParametersManager::exists())
+		delete ParametersManager::getSingletonPointer();
+}
+
+BatchReconstructor::ExitCode BatchReconstructor::run()
+{
+	if (!mValidArguments)
+		return EXIT_CODE_INVALID_ARGUMENTS;
+
+	try
+	{
+		// program parameters & managers
+		ParametersManager *parametersManager = new ParametersManager();
+		parametersManager->loadFromFile(mConfigFile);
+		new ImageManager();
+		new RandomManager();
+
+		// load input data or previous results
+		createScene();
+		if (mDiscardLoadedStages)
+			mScene->discardStages(mFirstStage, !mFSSFResult.empty());
+		mScene->setLastStage(mLastStage);
+
+		// process the stages
+		if (!mScene->reconstruct())
+		{
+			cerr << "Batch reconstruction failed." << endl;
+			return EXIT_CODE_RECONSTRUCTION_FAILED;
+		}
+	}
+	catch (Exception &exception)
+	{
+		cerr << exception;
+		return EXIT_CODE_EXCEPTION;
+	}
+	catch (std::exception &exception)
+	{
+		cerr << "Batch reconstruction aborted: " << exception.what() << endl;
+		return EXIT_CODE_EXCEPTION;
+	}
+
+	cout << "Batch reconstruction finished." << endl;
+	return EXIT_CODE_SUCCESS;
+}
+
+void BatchReconstructor::createScene()
+{
+	// no renderer
+	const vector<IReconstructorObserver *> observers;
+
+	// create scene from MVE, synthetic or previous run data?
+	if (string::npos != mInput.find("InputData.txt"))
+		mScene = new CapturedScene(mInput, observers);
+	else if (string::npos != mInput.find("InputDataSynthetic.txt"))
+		mScene = new SyntheticScene(mInput, observers);
+	else
+		mScene = new Scene(mInput, mFSSFResult, observers);
+}
+
+bool BatchReconstructor::parseArguments(const vector<string> &arguments)
+{
+	// required arguments
+	const uint32 argumentCount = (uint32) arguments.size();
+	if (argumentCount < 2)
+	{
+		cerr << "Invalid argument count!\n";
+		return false;
+	}
+
+	mConfigFile = arguments[0];
+	mInput = arguments[1];
+
+	// options with a single value each
+	for (uint32 argumentIdx = 2; argumentIdx < argumentCount; argumentIdx += 2)
+	{
+		const string &option = arguments[argumentIdx];
+		if (argumentIdx + 1 >= argumentCount)
+		{
+			cerr << "Missing value for option " << option << "!\n";
+			return false;
+		}
+
+		const string &value = arguments[argumentIdx + 1];
+		if ("-fssf" == option)
+		{
+			mFSSFResult = value;
+			continue;
+		}
+
+		const Scene::Stage stage = getStage(value);
+		if (Scene::STAGE_COUNT == stage)
+		{
+			cerr << "Unknown stage " << value << "!\n";
+			return false;
+		}
+
+		if ("-start" == option)
+		{
+			mFirstStage = stage;
+			mDiscardLoadedStages = true;
+		}
+		else if ("-stop" == option)
+		{
+			mLastStage = stage;
+		}
+		else
+		{
+			cerr << "Unknown option " << option << "!\n";
+			return false;
+		}
+	}
+
+	// valid stage range?
+	if (mFirstStage > mLastStage)
+	{
+		cerr << "The start stage must not be behind the stop stage!\n";
+		return false;
+	}
+
+	return true;
+}
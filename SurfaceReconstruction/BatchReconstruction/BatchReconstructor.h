@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+#ifndef _BATCH_RECONSTRUCTOR_H_
+#define _BATCH_RECONSTRUCTOR_H_
+
+#include <cassert>
+#include <string>
+#include <vector>
+#include "SurfaceReconstruction/Scene/Scene.h"
+
+/// Runs Scene::reconstruct() without window or OpenGL context, e.g., for batch processing on compute servers.
+class BatchReconstructor
+{
+public:
+	/// Process exit codes of the batch executable.
+	enum ExitCode
+	{
+		EXIT_CODE_SUCCESS,					/// All requested stages were completed.
+		EXIT_CODE_INVALID_ARGUMENTS,		/// The command line arguments are invalid.
+		EXIT_CODE_RECONSTRUCTION_FAILED,	/// Reconstruction stopped early, e.g., because of missing input data.
+		EXIT_CODE_EXCEPTION					/// An exception aborted scene loading or reconstruction.
+	};
+
+public:
+	/** Returns the stage with the entered command line name or Scene::STAGE_COUNT if there is no such stage.
+	@param name Set this to tree, occupancy, crust or fssf. */
+	static SurfaceReconstruction::Scene::Stage getStage(const std::string &name);
+
+	/** Prints the supported command line arguments to cerr. */
+	static void printUsage();
+
+public:
+	/** Parses the command line arguments.
+	@param arguments Set this to the command line arguments without program name. */
+	explicit BatchReconstructor(const std::vector<std::string> &arguments);
+
+	/** Frees the scene and all managers. */
+	~BatchReconstructor();
+
+	/** Loads the parameters and the scene and reconstructs it from the first to the last chosen stage.
+	@return Returns the exit code for the process. */
+	ExitCode run();
+
+private:
+	/** Copy constructor is forbidden. Don't use it. */
+	inline BatchReconstructor(const BatchReconstructor &other);
+
+	/** Assignment operator is forbidden. Don't use it.*/
+	inline BatchReconstructor &operator =(const BatchReconstructor &rhs);
+
+	/** Creates the scene from MVE data, a synthetic scene description or intermediate results of a previous run like TSR does. */
+	void createScene();
+
+	/** Sets the members according to arguments and returns false if they are invalid. */
+	bool parseArguments(const std::vector<std::string> &arguments);
+
+private:
+	std::string mConfigFile;					/// Program parameters file, e.g., Data/App.cfg.
+	std::string mInput;							/// InputData.txt, InputDataSynthetic.txt or root folder of a previous run.
+	std::string mFSSFResult;					/// Optional FSSF result of a previous run used as new refinement start.
+
+	SurfaceReconstruction::Scene *mScene;
+	SurfaceReconstruction::Scene::Stage mFirstStage;	/// Loaded results of this and later stages are discarded if mDiscardLoadedStages is set.
+	SurfaceReconstruction::Scene::Stage mLastStage;		/// Reconstruction stops after this stage.
+	bool mDiscardLoadedStages;							/// Is set if a start stage was passed. Otherwise all loaded results are reused.
+	bool mValidArguments;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///   inline function definitions   ////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline BatchReconstructor::BatchReconstructor(const BatchReconstructor &other)
+{
+	assert(false);
+}
+
+inline BatchReconstructor &BatchReconstructor::operator =(const BatchReconstructor &rhs)
+{
+	assert(false);
+	return *this;
+}
+
+#endif // _BATCH_RECONSTRUCTOR_H_
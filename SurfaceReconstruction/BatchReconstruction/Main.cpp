@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+#include <string>
+#include <vector>
+#include "BatchReconstructor.h"
+#include "Platform/ResourceManagement/MemoryManager.h"
+
+using namespace std;
+
+#ifdef MEMORY_MANAGEMENT
+	const uint32 ResourceManagement::DEFAULT_POOL_BUCKET_NUMBER = 5;
+	const uint16 ResourceManagement::DEFAULT_POOL_BUCKET_CAPACITIES[DEFAULT_POOL_BUCKET_NUMBER] = { 1024, 1024, 1024, 1024, 1024 };
+	const uint16 ResourceManagement::DEFAULT_POOL_BUCKET_GRANULARITIES[DEFAULT_POOL_BUCKET_NUMBER] = { 16, 32, 64, 128, 256 };
+#endif /// MEMORY_MANAGEMENT
+
+int main(int argc, char *argv[])
+{
+	#ifdef _WINDOWS
+		#ifdef _DEBUG
+			_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
+		#endif // _DEBUG
+	#endif // _WINDOWS
+
+	// reconstruct without window
+	int exitCode = 0;
+	{
+		vector<string> arguments;
+		for (int argumentIdx = 1; argumentIdx < argc; ++argumentIdx)
+			arguments.push_back(argv[argumentIdx]);
+
+		BatchReconstructor reconstructor(arguments);
+		exitCode = reconstructor.run();
+	}
+
+	#ifdef MEMORY_MANAGEMENT
+		ResourceManagement::MemoryManager::shutDown();
+	#endif /// MEMORY_MANAGEMENT
+
+	return exitCode;
+}
@@ -0,0 +1,359 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <omp.h>
+#include "Benchmark.h"
+#include "Graphics/ImageManager.h"
+#include "Platform/FailureHandling/Exception.h"
+#include "Platform/FailureHandling/FileException.h"
+#include "Platform/ParametersManager.h"
+#include "Platform/Storage/Directory.h"
+#include "SurfaceReconstruction/Geometry/FlexibleMesh.h"
+#include "SurfaceReconstruction/Geometry/RayTracer.h"
+#include "SurfaceReconstruction/Geometry/StaticMesh.h"
+#include "SurfaceReconstruction/Image/Image.h"
+#include "SurfaceReconstruction/Refinement/FSSFRefiner.h"
+#include "SurfaceReconstruction/Refinement/MeshDijkstra.h"
+#include "SurfaceReconstruction/Refinement/MeshDijkstraParameters.h"
+#include "SurfaceReconstruction/Scene/Samples.h"
+#include "SurfaceReconstruction/Scene/StageProfiler.h"
+#include "SurfaceReconstruction/Scene/SyntheticScene.h"
+#include "Utilities/RandomManager.h"
+
+using namespace FailureHandling;
+using namespace Graphics;
+using namespace Math;
+using namespace Platform;
+using namespace std;
+using namespace Storage;
+using namespace SurfaceReconstruction;
+using namespace Utilities;
+
+const Benchmark::InputSize Benchmark::INPUT_SIZES[Benchmark::INPUT_SIZE_COUNT] =
+{
+	{ "Small", 50, 90, 60 },
+	{ "Medium", 200, 180, 120 },
+	{ "Large", 800, 360, 240 }
+};
+
+const uint32 Benchmark::DIJKSTRA_SEARCH_COUNT = 100000;
+const uint32 Benchmark::RAY_TRACING_SCENE_BUILD_COUNT = 5;
+
+Benchmark::Benchmark(const vector<string> &arguments) :
+	mProfiler(NULL), mInputSizeCount(INPUT_SIZE_COUNT), mValidArguments(false)
+{
+	mValidArguments = parseArguments(arguments);
+	if (mValidArguments)
+		return;
+
+	cerr << "Required arguments:\n";
+	cerr << "<path/program config file> <ground truth mesh> <benchmark folder> [optional: largest input size: small, medium or large]\n";
+	cerr << flush;
+}
+
+Benchmark::~Benchmark()
+{
+	// free resources
+	Image::freeMemory();
+	delete mProfiler;
+	mProfiler = NULL;
+
+	// free managers
+	if (ImageManager::exists())
+		delete ImageManager::getSingletonPointer();
+	if (RandomManager::exists())
+		delete RandomManager::getSingletonPointer();
+	if (ParametersManager::exists())
+		delete ParametersManager::getSingletonPointer();
+}
+
+int Benchmark::run()
+{
+	if (!mValidArguments)
+		return 1;
+
+	try
+	{
+		// program parameters & managers
+		ParametersManager *parametersManager = new ParametersManager();
+		parametersManager->loadFromFile(mConfigFile);
+		new ImageManager();
+		new RandomManager();
+
+		// the benchmark owns the profiler so that scenes do not write their own reports
+		if (!Directory::createDirectory(mFolder))
+		{
+			cerr << "Could not create benchmark folder " << mFolder << "!" << endl;
+			return 1;
+		}
+		mProfiler = new StageProfiler();
+
+		bool success = true;
+		for (uint32 sizeIdx = 0; sizeIdx < mInputSizeCount; ++sizeIdx)
+			success &= benchmarkSize((InputSizeType) sizeIdx);
+		success &= validateFusedVertexUpdate();
+
+		// write report
+		const Path beginning = Path::appendChild(mFolder, Path("Benchmark"));
+		mProfiler->saveReport(beginning);
+		cout << "Saved benchmark report " << Path::extendLeafName(beginning, "Profile.json") << "." << endl;
+
+		return (success ? 0 : 2);
+	}
+	catch (Exception &exception)
+	{
+		cerr << exception;
+	}
+	catch (std::exception &exception)
+	{
+		cerr << "Benchmark aborted: " << exception.what() << endl;
+	}
+
+	return 3;
+}
+
+bool Benchmark::benchmarkSize(const InputSizeType sizeType) const
+{
+	const InputSize &size = INPUT_SIZES[sizeType];
+	cout << "Starting benchmark for input size " << size.mName << "." << endl;
+	StageProfiler::Scope sizeScope(size.mName, "views");
+	sizeScope.addItems(size.mViewCount);
+
+	// deterministic synthetic input (SyntheticScene reseeds the random manager with RANDOM_SEED)
+	const Path descriptionFile = createSceneDescription(sizeType, size.mName, "uint32 FSSFStatistics::maxIterationCount = 1;\n");
+	const vector<IReconstructorObserver *> observers;
+	SyntheticScene *scene = NULL;
+	{
+		StageProfiler::Scope profilerScope("SampleGeneration", "samples");
+		scene = new SyntheticScene(descriptionFile, observers);
+		profilerScope.addItems(scene->getSamples().getCount());
+	}
+
+	// all stages with a single FSSF iteration
+	bool success = scene->reconstruct();
+	const FlexibleMesh *mesh = scene->getMostRefinedReconstruction();
+	if (!success || !mesh || 0 == mesh->getTriangleCount())
+	{
+		cerr << "Could not reconstruct benchmark scene " << size.mName << "." << endl;
+		delete scene;
+		return false;
+	}
+
+	// isolated stages on the reconstructed mesh
+	{
+		StageProfiler::Scope profilerScope("Isolated", "triangles");
+		profilerScope.addItems(mesh->getTriangleCount());
+
+		benchmarkRayTracingSceneBuild(*mesh);
+		benchmarkDijkstra(*mesh);
+		benchmarkMeshIO(*mesh, scene->getResultsFolder());
+	}
+
+	delete scene;
+	return true;
+}
+
+bool Benchmark::validateFusedVertexUpdate() const
+{
+	cout << "Validating the fused FSSF vertex update." << endl;
+	StageProfiler::Scope validationScope("FusedVertexUpdateValidation", "runs");
+
+	// same synthetic input & iterations with all pairs and with pair subsets
+	const char *folderNames[2] = { "FusedValidation", "FusedValidationSubsets" };
+	const char *pairSubsets[2] = { "false", "true" };
+	const vector<IReconstructorObserver *> observers;
+	bool success = true;
+
+	for (uint32 runIdx = 0; runIdx < 2; ++runIdx)
+	{
+		string extraParameters = "uint32 FSSFStatistics::maxIterationCount = 2;\n";
+		extraParameters += "bool FSSF::validateFusedVertexUpdate = true;\n";
+		extraParameters += "bool FSSF::stochasticPairSubsets = ";
+		extraParameters += pairSubsets[runIdx];
+		extraParameters += ";\n";
+
+		const Path descriptionFile = createSceneDescription(INPUT_SIZE_SMALL, folderNames[runIdx], extraParameters);
+		SyntheticScene *scene = new SyntheticScene(descriptionFile, observers);
+		validationScope.addItems(1);
+
+		// compared in each iteration by FSSFRefiner::validateFusedVertexUpdate
+		const bool reconstructed = scene->reconstruct();
+		const FSSFRefiner *refiner = scene->getFSSFRefiner();
+		if (!reconstructed || !refiner)
+		{
+			cerr << "Could not reconstruct fused vertex update validation scene " << folderNames[runIdx] << "." << endl;
+			success = false;
+		}
+		else if (refiner->getFusedVertexUpdateMismatchCount() > 0)
+		{
+			cerr << "Fused vertex update differs from the separate passes for " << refiner->getFusedVertexUpdateMismatchCount();
+			cerr << " vertices in " << folderNames[runIdx] << "!" << endl;
+			success = false;
+		}
+
+		delete scene;
+	}
+
+	return success;
+}
+
+Path Benchmark::createSceneDescription(const InputSizeType sizeType, const string &folderName, const string &extraParameters) const
+{
+	// own folder for each scene
+	const InputSize &size = INPUT_SIZES[sizeType];
+	const Path sceneFolder = Path::appendChild(mFolder, Path(folderName));
+	if (!Directory::createDirectory(sceneFolder))
+		throw FileException("Could not create benchmark scene folder.", sceneFolder);
+
+	const Path fileName = Path::appendChild(sceneFolder, Path("InputDataSynthetic.txt"));
+	ofstream file(fileName.getString().c_str());
+	if (!file.is_open())
+		throw FileException("Could not create synthetic scene description for benchmarking.", fileName);
+
+	// like Data/ExampleInputDataDescriptions/InputDataSynthetic.txt but with fixed sizes
+	file << "string sceneFolder = " << sceneFolder.getString() << ";\n";
+	file << "string relativeCamerasFileName = Cameras.txt;\n";
+	file << "uint32 viewCount = " << size.mViewCount << ";\n";
+	file << "uint32 imageWidth = " << size.mImageWidth << ";\n";
+	file << "uint32 imageHeight = " << size.mImageHeight << ";\n";
+	file << "Real minimumFocalLength = 2.0;\n";
+	file << "Real maximumFocalLength = 6.0;\n";
+	file << "Real minimumDepth = 8.0;\n";
+	file << "Real relativeSceneBorderX = 10.0;\n";
+	file << "Real relativeSceneBorderY = 3.0;\n";
+	file << "Real relativeSceneBorderZ = 1.5;\n";
+	file << "Real viewBalance = 3.0;\n";
+	file << "Real relativeNoiseMean = 0.0;\n";
+	file << "Real relativeNoiseStandardDeviation = 0.01;\n";
+	file << "string groundTruthFile = " << mGroundTruthFile.getString() << ";\n";
+
+	// the description is loaded into the ParametersManager as well, e.g., a single refinement iteration
+	file << extraParameters;
+
+	if (!file.good())
+		throw FileException("Could not write synthetic scene description for benchmarking.", fileName);
+	return fileName;
+}
+
+void Benchmark::benchmarkRayTracingSceneBuild(const FlexibleMesh &mesh) const
+{
+	// each build is recorded by RayTracer::createStaticScene
+	RayTracer rayTracer;
+	for (uint32 buildIdx = 0; buildIdx < RAY_TRACING_SCENE_BUILD_COUNT; ++buildIdx)
+		rayTracer.createStaticScene(mesh.getPositions(), mesh.getVertexCount(), mesh.getIndices(), mesh.getIndexCount(), true);
+}
+
+void Benchmark::benchmarkDijkstra(const FlexibleMesh &mesh) const
+{
+	// search data like in FSSFRefiner::kernelInterpolation
+	const uint32 vertexCount = mesh.getVertexCount();
+	vector<Vector3> triangleNormals(mesh.getTriangleCount());
+	vector<uint32> vertexNeighbors;
+	vector<uint32> vertexNeighborsOffsets;
+
+	mesh.computeNormalsOfTriangles(triangleNormals.data());
+	mesh.getVertexNeighbors(vertexNeighbors, vertexNeighborsOffsets);
+
+	vector<MeshDijkstra::Step> steps;
+	MeshDijkstra::computeSteps(steps, mesh, triangleNormals.data(), vertexNeighbors.data(), vertexNeighborsOffsets.data());
+
+	const MeshDijkstraParameters params;
+	const uint32 maxNumThreads = omp_get_max_threads();
+	MeshDijkstra *dijkstras = new MeshDijkstra[maxNumThreads];
+
+	// evenly distributed start vertices with kernel ranges like projected samples of the vertex scales
+	StageProfiler::Scope profilerScope("MeshDijkstra", "expansions");
+	const Vector3 *normals = mesh.getNormals();
+	const Vector3 *positions = mesh.getPositions();
+	const Real *scales = mesh.getScales();
+	const int64 searchCount = DIJKSTRA_SEARCH_COUNT;
+
+	#pragma omp parallel for schedule(dynamic, 64)
+	for (int64 searchIdx = 0; searchIdx < searchCount; ++searchIdx)
+	{
+		const uint32 vertexIdx = (uint32) ((searchIdx * vertexCount) / searchCount);
+		const Real range = scales[vertexIdx] * params.getBandwidthFactor();
+		if (range <= 0.0f)
+			continue;
+
+		MeshDijkstra &dijkstra = dijkstras[omp_get_thread_num()];
+		dijkstra.findVertices(&mesh, triangleNormals.data(), vertexNeighbors.data(), vertexNeighborsOffsets.data(),
+			normals[vertexIdx], positions[vertexIdx], normals + vertexIdx, &vertexIdx, 1,
+			range, params.getMaxAngleDifference(), params.getAngularCostsFactor(), steps.data());
+	}
+
+	// throughput
+	for (uint32 threadIdx = 0; threadIdx < maxNumThreads; ++threadIdx)
+		profilerScope.addItems(dijkstras[threadIdx].getExpansionCount());
+	delete [] dijkstras;
+}
+
+void Benchmark::benchmarkMeshIO(const FlexibleMesh &mesh, const Path &folder) const
+{
+	const Path beginning = Path::appendChild(folder, Path("BenchmarkMesh"));
+	const uint32 triangleCount = mesh.getTriangleCount();
+
+	// saving
+	{
+		StageProfiler::Scope profilerScope("MeshSavingPly", "triangles");
+		profilerScope.addItems(triangleCount);
+		mesh.saveToFile(beginning, true, false);
+	}
+	{
+		StageProfiler::Scope profilerScope("MeshSavingInternal", "triangles");
+		profilerScope.addItems(triangleCount);
+		mesh.saveToFile(beginning, false, true);
+	}
+
+	// loading
+	{
+		StageProfiler::Scope profilerScope("MeshLoadingPly", "triangles");
+		profilerScope.addItems(triangleCount);
+		StaticMesh loadedMesh(Path::extendLeafName(beginning, ".ply"));
+	}
+	{
+		StageProfiler::Scope profilerScope("MeshLoadingInternal", "triangles");
+		profilerScope.addItems(triangleCount);
+		StaticMesh loadedMesh(Path::extendLeafName(beginning, ".Mesh"));
+	}
+}
+
+bool Benchmark::parseArguments(const vector<string> &arguments)
+{
+	const uint32 argumentCount = (uint32) arguments.size();
+	if (3 != argumentCount && 4 != argumentCount)
+	{
+		cerr << "Invalid argument count!\n";
+		return false;
+	}
+
+	mConfigFile = arguments[0];
+	mGroundTruthFile = arguments[1];
+	mFolder = arguments[2];
+	if (3 == argumentCount)
+		return true;
+
+	// largest input size
+	const string &largestSize = arguments[3];
+	if ("small" == largestSize)
+		mInputSizeCount = INPUT_SIZE_SMALL + 1;
+	else if ("medium" == largestSize)
+		mInputSizeCount = INPUT_SIZE_MEDIUM + 1;
+	else if ("large" == largestSize)
+		mInputSizeCount = INPUT_SIZE_LARGE + 1;
+	else
+	{
+		cerr << "Unknown input size " << largestSize << "!\n";
+		return false;
+	}
+
+	return true;
+}
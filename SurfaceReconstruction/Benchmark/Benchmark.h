@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+#include <cassert>
+#include <string>
+#include <vector>
+#include "Platform/DataTypes.h"
+#include "Platform/Storage/Path.h"
+
+namespace SurfaceReconstruction
+{
+	class FlexibleMesh;
+	class StageProfiler;
+}
+
+/** Measures the performance of all reconstruction stages reproducibly without window.
+	For each input size, a synthetic scene is created from a ground truth mesh with fixed seed (see SyntheticScene::RANDOM_SEED)
+	and reconstructed with a single FSSF iteration. Afterwards, Embree scene building, MeshDijkstra searches and mesh I/O are timed in isolation on the result.
+	All measurements are written as StageProfiler report to <benchmark folder>/BenchmarkProfile.json and BenchmarkProfile.csv.
+	Finally, the small scene is refined with FSSF::validateFusedVertexUpdate with and without stochastic pair subsets
+	and the benchmark fails if the fused vertex update and the separate passes do not give bitwise identical vertex data. */
+class Benchmark
+{
+public:
+	/// Synthetic input configuration.
+	struct InputSize
+	{
+	public:
+		const char *mName;
+		uint32 mViewCount;
+		uint32 mImageWidth;
+		uint32 mImageHeight;
+	};
+
+	enum InputSizeType
+	{
+		INPUT_SIZE_SMALL,
+		INPUT_SIZE_MEDIUM,
+		INPUT_SIZE_LARGE,
+		INPUT_SIZE_COUNT
+	};
+
+public:
+	/** Parses the command line arguments.
+	@param arguments Set this to the command line arguments without program name. */
+	explicit Benchmark(const std::vector<std::string> &arguments);
+
+	/** Frees the profiler and all managers. */
+	~Benchmark();
+
+	/** Runs the benchmark for all chosen input sizes and saves the report.
+	@return Returns 0 on success and a non-zero process exit code otherwise. */
+	int run();
+
+private:
+	/** Copy constructor is forbidden. Don't use it. */
+	inline Benchmark(const Benchmark &other);
+
+	/** Assignment operator is forbidden. Don't use it.*/
+	inline Benchmark &operator =(const Benchmark &rhs);
+
+	/** Times MeshDijkstra searches around evenly distributed start vertices of mesh in parallel like FSSF does. */
+	void benchmarkDijkstra(const SurfaceReconstruction::FlexibleMesh &mesh) const;
+
+	/** Times building the Embree scene of mesh. */
+	void benchmarkRayTracingSceneBuild(const SurfaceReconstruction::FlexibleMesh &mesh) const;
+
+	/** Times saving and loading of mesh in the ply and the internal format. */
+	void benchmarkMeshIO(const SurfaceReconstruction::FlexibleMesh &mesh, const Storage::Path &folder) const;
+
+	/** Creates, reconstructs and benchmarks the synthetic scene of input size sizeType.
+	@return Returns false if the scene could not be reconstructed. */
+	bool benchmarkSize(const InputSizeType sizeType) const;
+
+	/** Creates the synthetic scene description file for input size sizeType in its own sub folder of the benchmark folder.
+	@param folderName Set this to the name of the scene sub folder.
+	@param extraParameters Set this to program parameters which are appended to the description, e.g., to override App.cfg values.
+	@return Returns the description file name. */
+	Storage::Path createSceneDescription(const InputSizeType sizeType, const std::string &folderName, const std::string &extraParameters) const;
+
+	/** Reconstructs the small synthetic scene with FSSF::validateFusedVertexUpdate without and with stochastic pair subsets.
+	@return Returns false if a scene could not be reconstructed or if the fused vertex update gave different vertex data than the separate passes. */
+	bool validateFusedVertexUpdate() const;
+
+	/** Sets the members according to arguments and returns false if they are invalid. */
+	bool parseArguments(const std::vector<std::string> &arguments);
+
+public:
+	static const InputSize INPUT_SIZES[INPUT_SIZE_COUNT];	/// Benchmark input sizes from small to large.
+	static const uint32 DIJKSTRA_SEARCH_COUNT;				/// Number of MeshDijkstra searches for the isolated Dijkstra benchmark.
+	static const uint32 RAY_TRACING_SCENE_BUILD_COUNT;		/// Number of repeated Embree scene builds for the isolated scene build benchmark.
+
+private:
+	Storage::Path mConfigFile;			/// Program parameters file, e.g., Data/App.cfg.
+	Storage::Path mGroundTruthFile;		/// Mesh which is sampled to get the synthetic inputs.
+	Storage::Path mFolder;				/// Receives the synthetic scenes and the report.
+	SurfaceReconstruction::StageProfiler *mProfiler;
+	uint32 mInputSizeCount;				/// Only the first mInputSizeCount entries of INPUT_SIZES are benchmarked.
+	bool mValidArguments;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///   inline function definitions   ////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline Benchmark::Benchmark(const Benchmark &other)
+{
+	assert(false);
+}
+
+inline Benchmark &Benchmark::operator =(const Benchmark &rhs)
+{
+	assert(false);
+	return *this;
+}
+
+#endif // _BENCHMARK_H_
@@ -7,6 +7,7 @@
  * of the BSD 3-Clause license. See the License.txt file for details.
  */
 
+#include <algorithm>
 #include "Math/MathHelper.h"
 #include "SurfaceReconstruction/Geometry/Edge.h"
 #include "SurfaceReconstruction/Geometry/FlexibleMesh.h"
@@ -20,6 +21,8 @@ using namespace std;
 using namespace Storage;
 using namespace SurfaceReconstruction;
 
+const uint32 FlexibleMesh::MORTON_CELLS_PER_AXIS = 0x1 << 10;
+
 void FlexibleMesh::computeOffsetsForFiltering(uint32 *vertexOffsets, uint32 *edgeOffsets, uint32 *triangleOffsets,
 	const uint32 vertexCount, const uint32 edgeCount, const uint32 triangleCount,
 	const vector<uint32> *verticesToEdges, const Edge *edges, const uint32 *indices,
@@ -2018,6 +2021,182 @@ void FlexibleMesh::onNewElements(const uint32 oldVertexCount, const uint32 oldEd
 		mObservers[observerIdx]->onNewElements(oldVertexCount, vertexCount, oldEdgeCount, edgeCount, oldTriangleCount, triangleCount);
 }
 
+void FlexibleMesh::reorderSpatially()
+{
+	const uint32 vertexCount = getVertexCount();
+	const uint32 edgeCount = getEdgeCount();
+	const uint32 triangleCount = getTriangleCount();
+	if (0 == vertexCount)
+		return;
+
+	// edge conflicts store indices and only exist during topology changes
+	assert(mEdgeConflicts.empty());
+	if (!mEdgeConflicts.empty())
+		return;
+
+	cout << "Reordering mesh elements spatially." << endl;
+
+	// grid for Morton codes
+	Vector3 AABB[2];
+	computeAABB(AABB[0], AABB[1]);
+	const Vector3 extent = AABB[1] - AABB[0];
+	Real maxExtent = (extent.x > extent.y ? extent.x : extent.y);
+	maxExtent = (extent.z > maxExtent ? extent.z : maxExtent);
+	const Real invCellSize = (maxExtent > 0.0f ? MORTON_CELLS_PER_AXIS / maxExtent : 0.0f);
+
+	// vertex order: Morton codes of positions, ties keep the old order
+	vector<uint32> vertexOrder(vertexCount);
+	vector<uint32> newVertexIndices(vertexCount);
+	{
+		vector<uint64> keys(vertexCount);
+
+		#pragma omp parallel for
+		for (int64 i = 0; i < vertexCount; ++i)
+		{
+			const uint32 vertexIdx = (uint32) i;
+			keys[vertexIdx] = (((uint64) getMortonCode(mPositions[vertexIdx], AABB[0], invCellSize)) << 32) | vertexIdx;
+		}
+
+		getOrder(vertexOrder.data(), newVertexIndices.data(), keys);
+	}
+
+	// edge order: smallest new vertex index
+	vector<uint32> edgeOrder(edgeCount);
+	vector<uint32> newEdgeIndices(edgeCount);
+	{
+		vector<uint64> keys(edgeCount);
+
+		#pragma omp parallel for
+		for (int64 i = 0; i < edgeCount; ++i)
+		{
+			const uint32 edgeIdx = (uint32) i;
+			const uint32 *vertices = mEdges[edgeIdx].getVertexIndices();
+			const uint32 firstVertex = min(newVertexIndices[vertices[0]], newVertexIndices[vertices[1]]);
+			keys[edgeIdx] = (((uint64) firstVertex) << 32) | edgeIdx;
+		}
+
+		getOrder(edgeOrder.data(), newEdgeIndices.data(), keys);
+	}
+
+	// triangle order: smallest new vertex index
+	vector<uint32> triangleOrder(triangleCount);
+	vector<uint32> newTriangleIndices(triangleCount);
+	{
+		vector<uint64> keys(triangleCount);
+
+		#pragma omp parallel for
+		for (int64 i = 0; i < triangleCount; ++i)
+		{
+			const uint32 triangleIdx = (uint32) i;
+			const uint32 *triangle = getTriangle(triangleIdx);
+			const uint32 firstVertex = min(newVertexIndices[triangle[0]], min(newVertexIndices[triangle[1]], newVertexIndices[triangle[2]]));
+			keys[triangleIdx] = (((uint64) firstVertex) << 32) | triangleIdx;
+		}
+
+		getOrder(triangleOrder.data(), newTriangleIndices.data(), keys);
+	}
+
+	// vertex data & links to edges
+	{
+		vector<vector<uint32>> verticesToEdges(vertexCount);
+
+		#pragma omp parallel for
+		for (int64 i = 0; i < vertexCount; ++i)
+		{
+			const uint32 newVertexIdx = (uint32) i;
+			vector<uint32> &edges = verticesToEdges[newVertexIdx];
+			edges.swap(mVerticesToEdges[vertexOrder[newVertexIdx]]);
+
+			const uint32 localEdgeCount = (uint32) edges.size();
+			for (uint32 localEdgeIdx = 0; localEdgeIdx < localEdgeCount; ++localEdgeIdx)
+				edges[localEdgeIdx] = newEdgeIndices[edges[localEdgeIdx]];
+		}
+
+		mVerticesToEdges.swap(verticesToEdges);
+	}
+
+	FlexibleMesh::reorderData<Vector3>(mColors, vertexOrder.data());
+	FlexibleMesh::reorderData<Vector3>(mNormals, vertexOrder.data());
+	FlexibleMesh::reorderData<Vector3>(mPositions, vertexOrder.data());
+	FlexibleMesh::reorderData<Real>(mScales, vertexOrder.data());
+
+	// edges & their links to vertices and triangles
+	FlexibleMesh::reorderData<Edge>(mEdges, edgeOrder.data());
+
+	#pragma omp parallel for
+	for (int64 edgeIdx = 0; edgeIdx < edgeCount; ++edgeIdx)
+	{
+		Edge &edge = mEdges[edgeIdx];
+		const uint32 *oldVertices = edge.getVertexIndices();
+		const uint32 *oldTriangles = edge.getTriangleIndices();
+		const uint32 newTriangles[2] =
+		{
+			(Triangle::INVALID_IDX == oldTriangles[0] ? Triangle::INVALID_IDX : newTriangleIndices[oldTriangles[0]]),
+			(Triangle::INVALID_IDX == oldTriangles[1] ? Triangle::INVALID_IDX : newTriangleIndices[oldTriangles[1]])
+		};
+
+		edge.setVertices(newVertexIndices[oldVertices[0]], newVertexIndices[oldVertices[1]]);
+		edge.setTriangles(newTriangles[0], newTriangles[1]);
+	}
+
+	// triangles with their corner order
+	{
+		vector<uint32> newIndices(mIndices.size());
+
+		#pragma omp parallel for
+		for (int64 i = 0; i < triangleCount; ++i)
+		{
+			const uint32 newTriangleIdx = (uint32) i;
+			const uint32 *oldTriangle = getTriangle(triangleOrder[newTriangleIdx]);
+			for (uint32 cornerIdx = 0; cornerIdx < 3; ++cornerIdx)
+				newIndices[3 * newTriangleIdx + cornerIdx] = newVertexIndices[oldTriangle[cornerIdx]];
+		}
+
+		mIndices.swap(newIndices);
+	}
+
+	// update observers
+	const uint32 observerCount = getObserverCount();
+	for (uint32 observerIdx = 0; observerIdx < observerCount; ++observerIdx)
+		mObservers[observerIdx]->onReorderData(vertexOrder.data(), vertexCount, edgeOrder.data(), edgeCount, triangleOrder.data(), triangleCount);
+}
+
+void FlexibleMesh::getOrder(uint32 *order, uint32 *inverseOrder, vector<uint64> &keys)
+{
+	sort(keys.begin(), keys.end());
+
+	const int64 count = keys.size();
+	#pragma omp parallel for
+	for (int64 newIdx = 0; newIdx < count; ++newIdx)
+	{
+		const uint32 oldIdx = (uint32) (keys[newIdx] & 0xffffffff);
+		order[newIdx] = oldIdx;
+		inverseOrder[oldIdx] = (uint32) newIdx;
+	}
+}
+
+uint32 FlexibleMesh::getMortonCode(const Vector3 &position, const Vector3 &AABBMin, const Real invCellSize)
+{
+	// grid cell coordinates
+	uint32 coords[3];
+	const Vector3 offset = (position - AABBMin) * invCellSize;
+	const Real offsets[3] = { offset.x, offset.y, offset.z };
+
+	for (uint32 dim = 0; dim < 3; ++dim)
+	{
+		const int64 cellCoord = (int64) offsets[dim];
+		coords[dim] = (uint32) (cellCoord < 0 ? 0 : (cellCoord >= MORTON_CELLS_PER_AXIS ? MORTON_CELLS_PER_AXIS - 1 : cellCoord));
+	}
+
+	// interleave coordinate bits
+	uint32 code = 0;
+	for (uint32 bitIdx = 0; (0x1u << bitIdx) < MORTON_CELLS_PER_AXIS; ++bitIdx)
+		for (uint32 dim = 0; dim < 3; ++dim)
+			code |= ((coords[dim] >> bitIdx) & 0x1) << (3 * bitIdx + dim);
+
+	return code;
+}
+
 void FlexibleMesh::reserve(const uint32 newVertexCount, const uint32 newEdgeCount, const uint32 newIndexCount)
 {
 	// vertices
@@ -62,6 +62,12 @@ namespace SurfaceReconstruction
 		static void filterData(T *targetbuffer, const T *sourceBuffer,
 			const uint32 *offsets, const uint32 sourceCount, const uint32 elementsPerBlock);
 
+		/** Renumbers the elements of buffer according to order so that the new element i is the old element order[i].
+		@param buffer Set this to data with one entry per element. Its size must be equal to the size of order.
+		@param order Maps new to old element indices, see reorderSpatially. */
+		template <class T>
+		static void reorderData(std::vector<T> &buffer, const uint32 *order);
+
 		static void filterTriangles(uint32 *targetIndices, const uint32 *sourceIndices, const uint32 *triangleOffsets, const uint32 sourceIndexCount, const uint32 *vertexOffsets);		
 
 		static void findVertexNeighbors(std::vector<uint32> *vertexNeighbors, const uint32 *indices, const uint32 indexCount);
@@ -184,6 +190,12 @@ namespace SurfaceReconstruction
 
 		FlexibleMesh &operator =(const FlexibleMesh &rhs);
 
+		/** Renumbers vertices along a Morton curve over their positions and edges & triangles by their smallest new vertex indices.
+			Afterwards, spatially close elements are close in memory which speeds up all passes over neighborhoods.
+			The geometry and connectivity do not change. Observers are informed via IFlexibleMeshObserver::onReorderData.
+			Must not be called while there are edge conflicts. */
+		void reorderSpatially();
+
 		void reserve(const uint32 vertexCount, const uint32 edgeCount, const uint32 indexCount);	
 
 		void set(const Math::Vector3 &color, const Math::Vector3 &normal, const Math::Vector3 &position, const Real scale,
@@ -206,9 +218,23 @@ namespace SurfaceReconstruction
 
 		inline void zeroScales();
 
+	public:
+		static const uint32 MORTON_CELLS_PER_AXIS;	/// reorderSpatially sorts vertices by the cells of a grid with this many cells per axis. (Must be a power of two.)
+
 	protected:
 		static void extendBorderRing(uint32 &size, std::vector<uint32> &border,
 			const uint32 edge[2], const uint32 v0Idx, const uint32 v1Idx);
+
+		/** Returns the Morton code of the MORTON_CELLS_PER_AXIS^3 grid cell which contains position.
+		@param AABBMin Set this to the minimum corner of the grid.
+		@param invCellSize Set this to the inverse grid cell side length. */
+		static uint32 getMortonCode(const Math::Vector3 &position, const Math::Vector3 &AABBMin, const Real invCellSize);
+
+		/** Sorts keys and converts them to an order and its inverse.
+		@param order Is set to the old element indices in key order. (new index -> old index)
+		@param inverseOrder Is set to the inverse of order. (old index -> new index)
+		@param keys Set this to the sort key in the upper 32 bits and the old element index in the lower 32 bits for each element. Is sorted. */
+		static void getOrder(uint32 *order, uint32 *inverseOrder, std::vector<uint64> &keys);
 		
 		static void removeDuplicatesInRings(std::vector<std::vector<uint32>> &holeBorders, const uint32 *vertexOffsets = NULL);
 
@@ -359,6 +385,19 @@ namespace SurfaceReconstruction
 		buffer.swap(newBuffer);
 	}
 
+	template <class T>
+	void FlexibleMesh::reorderData(std::vector<T> &buffer, const uint32 *order)
+	{
+		const int64 count = buffer.size();
+		std::vector<T> newBuffer(count);
+
+		#pragma omp parallel for
+		for (int64 newIdx = 0; newIdx < count; ++newIdx)
+			newBuffer[newIdx] = buffer[order[newIdx]];
+
+		buffer.swap(newBuffer);
+	}
+
 	template <class T>
 	void FlexibleMesh::filterData(T *targetBuffer, const T *sourceBuffer, const uint32 *offsets, const uint32 sourceCount)
 	{	
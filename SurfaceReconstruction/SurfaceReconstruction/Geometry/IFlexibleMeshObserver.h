@@ -23,6 +23,13 @@ namespace SurfaceReconstruction
 			const uint32 *edgeOffsets, const uint32 edgeOffsetCount,
 			const uint32 *triangleOffsets, const uint32 triangleOffsetCount) = 0;
 
+		/** Called after FlexibleMesh::reorderSpatially renumbered all elements. Each order array maps new to old indices, i.e., vertexOrder[newIdx] = oldIdx.
+			The element counts do not change. */
+		virtual void onReorderData(
+			const uint32 *vertexOrder, const uint32 vertexCount,
+			const uint32 *edgeOrder, const uint32 edgeCount,
+			const uint32 *triangleOrder, const uint32 triangleCount) = 0;
+
 		virtual void onNewElements(
 			const uint32 firstNewVertex, const uint32 newVertexCount,
 			const uint32 firstNewEdge, const uint32 newEdgeCount,
@@ -47,124 +47,125 @@ void IslesEraser::computeVerticesToIsles()
 }
 
 void IslesEraser::mergeIsles()
-{
-	// merge isles connected via edges iteratively
-	while (connectNeighbors())
-		propagateLowestIsleIDs();
-}
-
-bool IslesEraser::connectNeighbors()
 {
 	// mesh data
 	const vector<uint32> *verticesToEdges = mMesh.getVerticesToEdges();
 	const uint32 vertexCount = mMesh.getVertexCount();
 
-	// connect neighbors
-	bool connected = false;
+	// union find: merge the isles of each pair of connected vertices
 	#pragma omp parallel for
 	for (int64 i = 0; i < vertexCount; ++i)
 	{
 		// get & check vertex vertexIdx
 		const uint32 vertexIdx = (uint32) i;
-		const uint32 oldIsle = mVerticesToIsles[vertexIdx];	
 		if (INVALID_TRIANGLE_ISLAND == mVerticesToIsles[vertexIdx])
 			continue;
 
-		// get isle & edges
+		// get edges
 		const vector<uint32> &edges = verticesToEdges[vertexIdx];
 		const uint32 neighborCount = (uint32) edges.size();
 
-		// find best within own local area	
-		uint32 bestVertexToIsleID = oldIsle;
-		bool betterNeighbor = false;
-
 		for (uint32 localEdgeIdx = 0; localEdgeIdx < neighborCount; ++localEdgeIdx)
 		{
-			// get & check global neighbor index
+			// get & check global neighbor index - process each edge only once
 			const uint32 globalEdgeIdx = edges[localEdgeIdx];
 			const Edge &edge = mMesh.getEdge(globalEdgeIdx);
 			const uint32 neighborVertexIdx = edge.getOtherVertex(vertexIdx);
-			const uint32 neighborIsleID = mVerticesToIsles[neighborVertexIdx];
+			if (neighborVertexIdx < vertexIdx)
+				continue;
 
 			// don't connect them?
-			if (INVALID_TRIANGLE_ISLAND == neighborIsleID)
-				continue;
-			if (neighborIsleID >= bestVertexToIsleID)
+			if (INVALID_TRIANGLE_ISLAND == mVerticesToIsles[neighborVertexIdx])
 				continue;
 
-			bestVertexToIsleID = neighborIsleID;
-			betterNeighbor = true;
+			unite(vertexIdx, neighborVertexIdx);
 		}
-
-		// isle for connecting?
-		if (!betterNeighbor)
-			continue;
-
-		connected = true;
-		setInParallel(oldIsle, bestVertexToIsleID);
-		setInParallel(vertexIdx, bestVertexToIsleID);
 	}
 
-	return connected;
+	// flatten the trees: each vertex directly links to its isle ID = lowest vertex index of its isle
+	#pragma omp parallel for
+	for (int64 i = 0; i < vertexCount; ++i)
+	{
+		const uint32 vertexIdx = (uint32) i;
+		if (INVALID_TRIANGLE_ISLAND != mVerticesToIsles[vertexIdx])
+			mVerticesToIsles[vertexIdx] = findRoot(vertexIdx);
+	}
 }
 
-void IslesEraser::propagateLowestIsleIDs()
-{	
-	// propagate connections within groups
-	const uint32 vertexCount = mMesh.getVertexCount();
-
-	for (bool propagating = true; propagating; )
+void IslesEraser::unite(const uint32 vertexIdx0, const uint32 vertexIdx1)
+{
+	// lock free linking: always link the root with the larger index to the one with the lower index to avoid cycles
+	while (true)
 	{
-		propagating = false;
-	
-		#pragma omp parallel for
-		for (int64 i = 0; i < vertexCount; ++i)
-		{
-			// get & check vertex
-			const uint32 vertexIdx = (uint32) i;
-			const uint32 oldIsle = mVerticesToIsles[vertexIdx];
-			if (INVALID_TRIANGLE_ISLAND == oldIsle)
-				continue;
-
-			// propagate within group / "shorten links / steps" to the one with the lowest index
-			const uint32 bestVertexToIsle = setInParallel(vertexIdx, mVerticesToIsles[oldIsle]);
-			if (bestVertexToIsle < oldIsle)
-				propagating = true;
-		}
+		uint32 root0 = findRoot(vertexIdx0);
+		uint32 root1 = findRoot(vertexIdx1);
+		if (root0 == root1)
+			return;
+
+		if (root0 < root1)
+			swap(root0, root1);
+
+		// link root0 to root1 if no other thread modified root0 in the mean time
+		uint32 expected = root0;
+		if (mVerticesToIsles[root0].compare_exchange_strong(expected, root1))
+			return;
 	}
 }
 
-uint32 IslesEraser::setInParallel(const uint32 vertexIdx, const uint32 bestVertexToIsle)
+uint32 IslesEraser::findRoot(uint32 vertexIdx)
 {
-	// try to write bestVertexToIsle value until success or until some other thread wrote a better bestVertexToIsle
-	atomic<uint32> &link = mVerticesToIsles[vertexIdx];
-	uint32 current = link.load();
-	if (bestVertexToIsle >= current)
-		return current;
+	// follow the links to the isle root & shorten the path by path halving
+	while (true)
+	{
+		uint32 parent = mVerticesToIsles[vertexIdx].load();
+		if (parent == vertexIdx)
+			return vertexIdx;
 
-	while (!link.compare_exchange_weak(current, bestVertexToIsle))
-		if (bestVertexToIsle >= current)
-			return current;
+		// links only point to lower indices - replacing parent by grand parent is safe even when other threads do so
+		const uint32 grandParent = mVerticesToIsles[parent].load();
+		if (parent != grandParent)
+			mVerticesToIsles[vertexIdx].compare_exchange_weak(parent, grandParent);
 
-	return bestVertexToIsle;
+		vertexIdx = grandParent;
+	}
 }
 
 void IslesEraser::computeIsleSizes()
 {
 	const uint32 oldVertexCount = mMesh.getVertexCount();
 	mIsleSizes.clear();
+	mIsleSizes.resize(oldVertexCount, 0);
+	mIsleIDs.clear();
 
 	// count: how many vertices per isle?
-	for (uint32 vertexIdx = 0; vertexIdx < oldVertexCount; ++vertexIdx)
+	uint32 *sizes = mIsleSizes.data();
+	#pragma omp parallel for
+	for (int64 i = 0; i < oldVertexCount; ++i)
 	{
-		const uint32 isleID = mVerticesToIsles[vertexIdx];
+		const uint32 isleID = mVerticesToIsles[i];
 		if (INVALID_TRIANGLE_ISLAND == isleID)
 			continue;
 
-		auto it = mIsleSizes.insert(make_pair(isleID, 0));
-		uint32 &isleSize = it.first->second;
-		++isleSize;
+		#pragma omp atomic
+		++sizes[isleID];
 	}
+
+	// prefix sum over isle flags to get the index of each isle ID within mIsleIDs
+	vector<uint32> offsets(oldVertexCount + 1, 0);
+	#pragma omp parallel for
+	for (int64 i = 0; i < oldVertexCount; ++i)
+		offsets[i + 1] = (0 != sizes[i] ? 1 : 0);
+
+	for (uint32 i = 0; i < oldVertexCount; ++i)
+		offsets[i + 1] += offsets[i];
+
+	// gather the isle IDs
+	mIsleIDs.resize(offsets[oldVertexCount]);
+
+	#pragma omp parallel for
+	for (int64 i = 0; i < oldVertexCount; ++i)
+		if (offsets[i] != offsets[i + 1])
+			mIsleIDs[offsets[i]] = (uint32) i;
 }
 
 bool IslesEraser::hasFoundTooSmallIsle(const uint32 minIsleSize)
@@ -172,8 +173,9 @@ bool IslesEraser::hasFoundTooSmallIsle(const uint32 minIsleSize)
 	mMinIsleSize = minIsleSize;
 
 	// any isle which is too small?
-	for (map<uint32, uint32>::const_iterator isleIt = mIsleSizes.begin(); isleIt != mIsleSizes.end(); ++isleIt)
-		if (isleIt->second < mMinIsleSize)
+	const uint32 isleCount = (uint32) mIsleIDs.size();
+	for (uint32 isleIdx = 0; isleIdx < isleCount; ++isleIdx)
+		if (mIsleSizes[mIsleIDs[isleIdx]] < mMinIsleSize)
 			return true;
 
 	return false;
@@ -185,7 +187,7 @@ bool IslesEraser::isBad(const uint32 vertexIdx) const
 		return false;
 
 	const uint32 isleID = mVerticesToIsles[vertexIdx];
-	const uint32 count = mIsleSizes.find(isleID)->second;
+	const uint32 count = mIsleSizes[isleID];
 	return (count < mMinIsleSize);
 }
 
@@ -214,16 +216,19 @@ const std::vector<std::vector<uint32>> &IslesEraser::computeRingBordersOfDoomedI
 {
 	//cout << "Finding borders of isles which will be deleted." << endl;
 	assert(mTriangleOffsets);
-	assert(!mIsleSizes.empty());
+	assert(!mIsleIDs.empty());
 
 	// number of isles & mapping of  isle ID to index w.r.t. smallIslesBorders
 	vector<uint32> mapping;
 	mapping.reserve(100);
-	for (map<uint32, uint32>::const_iterator it = mIsleSizes.begin(); it != mIsleSizes.end(); ++it)
+
+	const uint32 isleCount = (uint32) mIsleIDs.size();
+	for (uint32 isleIdx = 0; isleIdx < isleCount; ++isleIdx)
 	{
-		if (it->second >= mMinIsleSize)
+		const uint32 isleID = mIsleIDs[isleIdx];
+		if (mIsleSizes[isleID] >= mMinIsleSize)
 			continue;
-		mapping.push_back(it->first);
+		mapping.push_back(isleID);
 	}
 
 	// reserve memory
@@ -350,6 +355,7 @@ IslesEraser::~IslesEraser()
 void IslesEraser::clear()
 {
 	mIslesBorders.clear();
+	mIsleIDs.clear();
 	mIsleSizes.clear();
 
 	delete [] mVerticesToIsles;
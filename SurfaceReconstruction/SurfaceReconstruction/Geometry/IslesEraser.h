@@ -34,7 +34,8 @@ namespace SurfaceReconstruction
 		
 		const std::vector<std::vector<uint32>> &computeRingBordersOfDoomedIsles();
 
-		inline const std::map<uint32, uint32> &getIsleSizes() const;
+		inline const std::vector<uint32> &getIsleIDs() const;
+		inline const std::vector<uint32> &getIsleSizes() const;
 
 		const uint32 getNewIndexCount() const;
 		const uint32 getNewVertexCount() const;
@@ -62,18 +63,17 @@ namespace SurfaceReconstruction
 		void findBorderRings();
 
 		void findIsles();
+		uint32 findRoot(uint32 vertexIdx);
 
 		inline bool ignore(const uint32 vertexIdx) const;
 
 		void gatherIsleBorders(const std::vector<uint32> &mapping);
 
 		void mergeIsles();
-		bool connectNeighbors();
 		void processDoomedTriangleForBorder(const std::vector<uint32> &mapping, const uint32 triangleIdx);
-		void propagateLowestIsleIDs();
 		void removeTwoTimesPassedEdges(const uint32 borderIdx);
-		uint32 setInParallel(const uint32 vertexIdx, const uint32 bestVertexToIsle);
 		void sortBorderRingEdges(std::vector<uint32> &ring, std::vector<uint32> &tempRing);
+		void unite(const uint32 vertexIdx0, const uint32 vertexIdx1);
 
 	public:
 		static const uint32 INVALID_TRIANGLE_ISLAND;
@@ -83,7 +83,8 @@ namespace SurfaceReconstruction
 
 	private:
 		std::vector<std::vector<uint32>> mIslesBorders;
-		std::map<uint32, uint32> mIsleSizes;
+		std::vector<uint32> mIsleIDs;	/// Sorted IDs of all isles whereas an isle ID is the lowest index of its vertices.
+		std::vector<uint32> mIsleSizes;	/// Dense vertex counts of isles: mIsleSizes[isle ID] = number of vertices of that isle, 0 for non-IDs.
 
 		std::atomic<uint32> *mVerticesToIsles;
 		uint32 *mEdgeOffsets;
@@ -107,7 +108,12 @@ namespace SurfaceReconstruction
 		assert(false);
 	}
 
-	inline const std::map<uint32, uint32> &IslesEraser::getIsleSizes() const
+	inline const std::vector<uint32> &IslesEraser::getIsleIDs() const
+	{
+		return mIsleIDs;
+	}
+
+	inline const std::vector<uint32> &IslesEraser::getIsleSizes() const
 	{
 		return mIsleSizes;	
 	}
@@ -11,6 +11,8 @@
 #include "Math/MathHelper.h"
 #include "Platform/Storage/File.h"
 #include "SurfaceReconstruction/Geometry/Mesh.h"
+#include "SurfaceReconstruction/Scene/FixedPointSum.h"
+#include "SurfaceReconstruction/Scene/MappedFile.h"
 #include "Utilities/PlyFile.h"
 
 using namespace FailureHandling;
@@ -129,6 +131,11 @@ void Mesh::computeNormalsWeightedByAngles(Vector3 *normals,
 
 	zeroNormals(normals, vertexCount);
 
+	// deterministic mode: order independent sums instead of floating point atomics
+	vector<FixedPointSum> fixedNormals;
+	if (FixedPointSum::isDeterministicModeEnabled())
+		fixedNormals.resize(3 * vertexCount);
+
 	// for each triangle: add its normal to its adjacent normal vectors
 	const int64 triangleCount = indexCount / 3;
 	
@@ -168,6 +175,11 @@ void Mesh::computeNormalsWeightedByAngles(Vector3 *normals,
 		{
 			const uint32 vertexIdx = triangle[cornerIdx];
 			const Vector3 weightedNormal = normal * angles[cornerIdx];
+			if (!fixedNormals.empty())
+			{
+				FixedPointSum::add(fixedNormals.data() + 3 * vertexIdx, weightedNormal);
+				continue;
+			}
 
 			// add triangle normal to vertex normal
 			#pragma omp atomic
@@ -179,6 +191,8 @@ void Mesh::computeNormalsWeightedByAngles(Vector3 *normals,
 		}
 	}
 
+	if (!fixedNormals.empty())
+		getFixedPointSums(normals, fixedNormals.data(), vertexCount);
 	normalizeNormals(normals, vertexCount);
 }
 
@@ -189,6 +203,11 @@ void Mesh::computeNormalsWeightedByArea(Vector3 *normals, const Vector3 *positio
 
 	zeroNormals(normals, vertexCount);
 
+	// deterministic mode: order independent sums instead of floating point atomics
+	vector<FixedPointSum> fixedNormals;
+	if (FixedPointSum::isDeterministicModeEnabled())
+		fixedNormals.resize(3 * vertexCount);
+
 	// for each triangle: add its normal to its adjacent normal vectors
 	const int64 triangleCount = indexCount / 3;
 	
@@ -208,6 +227,11 @@ void Mesh::computeNormalsWeightedByArea(Vector3 *normals, const Vector3 *positio
 		for (uint32 cornerIdx = 0; cornerIdx < 3; ++cornerIdx)
 		{
 			const uint32 vertexIdx = triangle[cornerIdx];
+			if (!fixedNormals.empty())
+			{
+				FixedPointSum::add(fixedNormals.data() + 3 * vertexIdx, normal);
+				continue;
+			}
 
 			// add triangle normal to vertex normal
 			#pragma omp atomic
@@ -219,9 +243,18 @@ void Mesh::computeNormalsWeightedByArea(Vector3 *normals, const Vector3 *positio
 		}
 	}
 
+	if (!fixedNormals.empty())
+		getFixedPointSums(normals, fixedNormals.data(), vertexCount);
 	normalizeNormals(normals, vertexCount);
 }
 
+void Mesh::getFixedPointSums(Vector3 *targets, const FixedPointSum *sums, const uint32 count)
+{
+	#pragma omp parallel for
+	for (int64 i = 0; i < count; ++i)
+		targets[i] = FixedPointSum::getVector(sums + 3 * i);
+}
+
 void Mesh::zeroNormals(Vector3 *normals, const uint32 count)
 {
 	#pragma omp parallel for
@@ -279,6 +312,30 @@ void Mesh::loadFromFile(const Path &fileName)
 
 void Mesh::loadFromMesh(const Path &fileName)
 {
+	// page aligned format?
+	if (MappedFile::isMappedFile(fileName))
+	{
+		// read vertex & index count & reserve memory
+		const MappedFile file(fileName, FILE_VERSION);
+		const uint32 *counts = file.getSection<uint32>(0, 2);
+		const uint32 vertexCount = counts[0];
+		const uint32 indexCount = counts[1];
+
+		allocateMemory(vertexCount, indexCount);
+
+		// copy vertex buffers & indices
+		const uint64 vectorBytes = sizeof(Vector3) * vertexCount;
+		file.copySection(getColors(), 1, vectorBytes);
+		file.copySection(getNormals(), 2, vectorBytes);
+		file.copySection(getPositions(), 3, vectorBytes);
+		file.copySection(getScales(), 4, sizeof(Real) * vertexCount);
+		file.copySection((uint32 *) getIndices(), 5, sizeof(uint32) * indexCount);
+
+		cout << "Loaded mesh: " << fileName << "\n";
+		cout << "Vertices: " << vertexCount << ", indices: " << indexCount << endl;
+		return;
+	}
+
 	// open file
 	File file(fileName, File::OPEN_READING, true, FILE_VERSION);
 
@@ -386,6 +443,19 @@ void Mesh::saveToFile(const Path &fileNameBeginning, const bool saveAsPly, const
 		const Path fileName = Path::extendLeafName(fileNameBeginning, ".Mesh");
 		cout << "Saving " << fileName << "\n";
 
+		// page aligned format?
+		if (MappedFile::isSavingEnabled())
+		{
+			const uint32 counts[2] = { vertexCount, indexCount };
+			const uint64 vectorBytes = sizeof(Vector3) * vertexCount;
+			const void *sections[] = { counts, getColors(), getNormals(), getPositions(), getScales(), getIndices() };
+			const uint64 byteCounts[] = { sizeof(uint32) * 2, vectorBytes, vectorBytes, vectorBytes, sizeof(Real) * vertexCount, sizeof(uint32) * indexCount };
+
+			MappedFile::save(fileName, FILE_VERSION, sections, byteCounts, 6);
+			cout << flush;
+			return;
+		}
+
 		File file(fileName, File::CREATE_WRITING, true, FILE_VERSION);
 
 		// write vertex & index count
@@ -427,6 +497,12 @@ void Mesh::computeUmbrellaSmoothingMovementField(Vector3 *movementField, Real *w
 	for (int64 vertexIdx = 0; vertexIdx < vertexCount; ++vertexIdx)
 		weightField[vertexIdx] = 0.0f;
 
+	// deterministic mode: order independent sums (movement x, y, z & weight) instead of floating point atomics
+	vector<FixedPointSum> fixedSums;
+	if (FixedPointSum::isDeterministicModeEnabled())
+		fixedSums.resize(4 * vertexCount);
+	FixedPointSum *fixedSumsData = (fixedSums.empty() ? NULL : fixedSums.data());
+
 	// for each vertex: compute sum of weighted neighbors
 	const uint32 indexCount = getIndexCount();
 	const uint32 *indices = getIndices();
@@ -436,7 +512,18 @@ void Mesh::computeUmbrellaSmoothingMovementField(Vector3 *movementField, Real *w
 	{
 		const uint32 *triangle = indices + i;
 		for (uint32 cornerIdx = 0; cornerIdx < 3; ++cornerIdx)
-			prepareUmbrellaSmoothing(movementField, weightField, triangle[cornerIdx], triangle[(cornerIdx + 1) % 3]);
+			prepareUmbrellaSmoothing(movementField, weightField, fixedSumsData, triangle[cornerIdx], triangle[(cornerIdx + 1) % 3]);
+	}
+
+	if (fixedSumsData)
+	{
+		#pragma omp parallel for
+		for (int64 vertexIdx = 0; vertexIdx < vertexCount; ++vertexIdx)
+		{
+			const FixedPointSum *sums = fixedSumsData + 4 * vertexIdx;
+			movementField[vertexIdx] = FixedPointSum::getVector(sums);
+			weightField[vertexIdx] = sums[3].getValue();
+		}
 	}
 
 	// normalize weighted sums and subtract vertex positions to get umbrella operator movements
@@ -455,7 +542,8 @@ void Mesh::computeUmbrellaSmoothingMovementField(Vector3 *movementField, Real *w
 	}
 }
 
-void Mesh::prepareUmbrellaSmoothing(Vector3 *movementField, Real *weightField, const uint32 vertexIdx0, const uint32 vertexIdx1) const
+void Mesh::prepareUmbrellaSmoothing(Vector3 *movementField, Real *weightField, FixedPointSum *fixedSums,
+	const uint32 vertexIdx0, const uint32 vertexIdx1) const
 {
 	// vertex positions
 	const Vector3 *positions = getPositions();
@@ -467,6 +555,19 @@ void Mesh::prepareUmbrellaSmoothing(Vector3 *movementField, Real *weightField, c
 	const Vector3 t0 = position1 * weight;
 	const Vector3 t1 = position0 * weight;
 
+	// deterministic mode?
+	if (fixedSums)
+	{
+		FixedPointSum *sums0 = fixedSums + 4 * vertexIdx0;
+		FixedPointSum *sums1 = fixedSums + 4 * vertexIdx1;
+
+		FixedPointSum::add(sums0, t0);
+		FixedPointSum::add(sums1, t1);
+		sums0[3].add(weight);
+		sums1[3].add(weight);
+		return;
+	}
+
 	// update summed movements & weights
 	Vector3 &movement0 = movementField[vertexIdx0];
 	Vector3 &movement1 = movementField[vertexIdx1];
@@ -19,6 +19,8 @@
 
 namespace SurfaceReconstruction
 {
+	class FixedPointSum;
+
 	/// Represents object surfaces by means of triangles.
 	class Mesh
 	{
@@ -46,6 +48,9 @@ namespace SurfaceReconstruction
 		static void zeroNormals(Math::Vector3 *normals, const uint32 count);
 		static void normalizeNormals(Math::Vector3 *normals, const uint32 count);
 
+		/** Sets targets[i] to the 3 order independent sums sums[3 * i], sums[3 * i + 1] and sums[3 * i + 2] for each i < count. */
+		static void getFixedPointSums(Math::Vector3 *targets, const FixedPointSum *sums, const uint32 count);
+
 	public:
 		virtual ~Mesh();
 
@@ -105,7 +110,11 @@ namespace SurfaceReconstruction
 		void loadFromPly(const Storage::Path &fileName);
 		void loadVertices(Utilities::PlyFile &plyFile, const Graphics::VerticesDescription &verticesFormat);
 		
-		void prepareUmbrellaSmoothing(Math::Vector3 *movementField, Real *weightField, const uint32 vertexIdx0, const uint32 vertexIdx1) const;
+		/** Adds the weighted positions of the edge (vertexIdx0, vertexIdx1) to the umbrella sums of both vertices.
+		@param fixedSums Set this to 4 order independent sums (movement x, y, z and weight) per vertex for the deterministic reductions mode.
+			If it is NULL, movementField and weightField are directly updated via floating point atomics. */
+		void prepareUmbrellaSmoothing(Math::Vector3 *movementField, Real *weightField, FixedPointSum *fixedSums,
+			const uint32 vertexIdx0, const uint32 vertexIdx1) const;
 		virtual void setIndices(const uint32 *indices, const uint32 indexCount) = 0;
 
 	private:
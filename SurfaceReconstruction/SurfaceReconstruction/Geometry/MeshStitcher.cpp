@@ -0,0 +1,659 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include "SurfaceReconstruction/Geometry/FlexibleMesh.h"
+#include "SurfaceReconstruction/Geometry/MeshStitcher.h"
+#include "SurfaceReconstruction/Geometry/Vertex.h"
+
+using namespace Math;
+using namespace std;
+using namespace SurfaceReconstruction;
+
+MeshStitcher::MeshStitcher() :
+	mTileCount(0)
+{
+
+}
+
+void MeshStitcher::addTile(const FlexibleMesh &mesh, const Vector3 coreAABB[2], const bool maxInclusive[3])
+{
+	const Vector3 *colors = mesh.getColors();
+	const Vector3 *normals = mesh.getNormals();
+	const Vector3 *positions = mesh.getPositions();
+	const Real *scales = mesh.getScales();
+	const uint32 *indices = mesh.getIndices();
+	const uint32 vertexCount = mesh.getVertexCount();
+	const uint32 triangleCount = mesh.getTriangleCount();
+
+	// new indices of tile vertices which are used by core triangles
+	vector<uint32> newIndices(vertexCount, Vertex::INVALID_IDX);
+	vector<uint8> cropped(vertexCount, 0);
+	const uint32 tileIdx = mTileCount++;
+
+	for (uint32 triangleIdx = 0; triangleIdx < triangleCount; ++triangleIdx)
+	{
+		// centroid within the core?
+		const uint32 *triangle = indices + 3 * triangleIdx;
+		const Vector3 centroid = (positions[triangle[0]] + positions[triangle[1]] + positions[triangle[2]]) * (1.0f / 3.0f);
+		const Real coordinates[3] = { centroid.x, centroid.y, centroid.z };
+		const Real mins[3] = { coreAABB[0].x, coreAABB[0].y, coreAABB[0].z };
+		const Real maxs[3] = { coreAABB[1].x, coreAABB[1].y, coreAABB[1].z };
+
+		bool inCore = true;
+		for (uint32 axis = 0; axis < 3 && inCore; ++axis)
+			inCore = (coordinates[axis] >= mins[axis] && (coordinates[axis] < maxs[axis] || (maxInclusive[axis] && coordinates[axis] == maxs[axis])));
+		if (!inCore)
+		{
+			cropped[triangle[0]] = cropped[triangle[1]] = cropped[triangle[2]] = 1;
+			continue;
+		}
+
+		// keep the triangle & its vertices
+		for (uint32 cornerIdx = 0; cornerIdx < 3; ++cornerIdx)
+		{
+			const uint32 vertexIdx = triangle[cornerIdx];
+			uint32 &newIdx = newIndices[vertexIdx];
+			if (Vertex::INVALID_IDX == newIdx)
+			{
+				newIdx = (uint32) mPositions.size();
+				mColors.push_back(colors[vertexIdx]);
+				mNormals.push_back(normals[vertexIdx]);
+				mPositions.push_back(positions[vertexIdx]);
+				mScales.push_back(scales[vertexIdx]);
+				mVertexTiles.push_back(tileIdx);
+				mCroppedVertices.push_back(0);
+			}
+
+			mIndices.push_back(newIdx);
+		}
+	}
+
+	// kept vertices at the seams
+	for (uint32 vertexIdx = 0; vertexIdx < vertexCount; ++vertexIdx)
+		if (Vertex::INVALID_IDX != newIndices[vertexIdx])
+			mCroppedVertices[newIndices[vertexIdx]] = cropped[vertexIdx];
+}
+
+FlexibleMesh *MeshStitcher::createStitchedMesh(const Real relativeWeldDistance)
+{
+	// weld border vertices of different tiles
+	vector<uint32> borderVertices;
+	vector<Real> borderEdgeLengths;
+	vector<uint32> replacements;
+
+	findBorderVertices(borderVertices, borderEdgeLengths);
+	findWeldPartners(replacements, borderVertices, borderEdgeLengths, relativeWeldDistance);
+	const uint32 rejectedWeldCount = rejectInvalidWelds(replacements);
+
+	// replace welded vertices & skip collapsed triangles
+	const uint32 oldVertexCount = (uint32) mPositions.size();
+	const uint32 oldIndexCount = (uint32) mIndices.size();
+	vector<uint32> indices;
+	vector<uint32> triangleTiles;
+	vector<uint32> vertexOffsets(oldVertexCount + 1, 1);
+	indices.reserve(oldIndexCount);
+
+	for (uint32 indexIdx = 0; indexIdx < oldIndexCount; indexIdx += 3)
+	{
+		const uint32 v0 = replacements[mIndices[indexIdx + 0]];
+		const uint32 v1 = replacements[mIndices[indexIdx + 1]];
+		const uint32 v2 = replacements[mIndices[indexIdx + 2]];
+		if (v0 == v1 || v1 == v2 || v2 == v0)
+			continue;
+
+		indices.push_back(v0);
+		indices.push_back(v1);
+		indices.push_back(v2);
+		vertexOffsets[v0] = vertexOffsets[v1] = vertexOffsets[v2] = 0;
+		triangleTiles.push_back(mVertexTiles[mIndices[indexIdx]]);
+	}
+
+	// close what welding left open (zipping only connects used vertices)
+	const uint32 zippingTriangleCount = zipSeamGaps(indices, triangleTiles);
+
+	// vertexOffsets: exclusive prefix sum over unused vertices
+	uint32 unusedCount = 0;
+	for (uint32 vertexIdx = 0; vertexIdx <= oldVertexCount; ++vertexIdx)
+	{
+		const uint32 unused = vertexOffsets[vertexIdx];
+		vertexOffsets[vertexIdx] = unusedCount;
+		unusedCount += unused;
+	}
+
+	// create the stitched mesh from all used vertices
+	const uint32 newVertexCount = oldVertexCount - vertexOffsets[oldVertexCount];
+	const uint32 newIndexCount = (uint32) indices.size();
+	FlexibleMesh *mesh = new FlexibleMesh(newVertexCount, newIndexCount);
+
+	for (uint32 vertexIdx = 0; vertexIdx < oldVertexCount; ++vertexIdx)
+	{
+		if (vertexOffsets[vertexIdx] != vertexOffsets[vertexIdx + 1])
+			continue;
+
+		const uint32 newIdx = vertexIdx - vertexOffsets[vertexIdx];
+		mesh->set(mColors[vertexIdx], mNormals[vertexIdx], mPositions[vertexIdx], mScales[vertexIdx], newIdx);
+	}
+
+	for (uint32 indexIdx = 0; indexIdx < newIndexCount; ++indexIdx)
+		indices[indexIdx] -= vertexOffsets[indices[indexIdx]];
+	mesh->setIndices(indices.data(), newIndexCount);
+
+	cout << "Stitched " << mTileCount << " tile meshes: " << newVertexCount << " vertices, " << newIndexCount / 3 << " triangles, ";
+	cout << oldVertexCount - newVertexCount << " welded or unused seam vertices, " << rejectedWeldCount << " rejected welds, ";
+	cout << zippingTriangleCount << " zipping triangles." << endl;
+	return mesh;
+}
+
+void MeshStitcher::findBorderVertices(vector<uint32> &borderVertices, vector<Real> &borderEdgeLengths) const
+{
+	// all edges as sorted vertex pairs
+	const uint32 indexCount = (uint32) mIndices.size();
+	vector<uint64> edges(indexCount);
+
+	#pragma omp parallel for
+	for (int64 i = 0; i < indexCount; ++i)
+	{
+		const uint32 indexIdx = (uint32) i;
+		const uint32 v0 = mIndices[indexIdx];
+		const uint32 v1 = mIndices[indexIdx - (indexIdx % 3) + ((indexIdx + 1) % 3)];
+		edges[indexIdx] = getEdgeKey(v0, v1);
+	}
+	sort(edges.begin(), edges.end());
+
+	// border edges are only used by a single triangle
+	const uint32 vertexCount = (uint32) mPositions.size();
+	vector<Real> lengthSums(vertexCount, 0.0f);
+	vector<uint32> borderEdgeCounts(vertexCount, 0);
+
+	for (uint32 edgeIdx = 0; edgeIdx < indexCount; )
+	{
+		uint32 end = edgeIdx + 1;
+		while (end < indexCount && edges[end] == edges[edgeIdx])
+			++end;
+
+		if (end - edgeIdx == 1)
+		{
+			const uint32 v0 = (uint32) (edges[edgeIdx] >> 32);
+			const uint32 v1 = (uint32) (edges[edgeIdx] & 0xFFFFFFFF);
+			const Real length = (mPositions[v0] - mPositions[v1]).getLength();
+
+			lengthSums[v0] += length;
+			lengthSums[v1] += length;
+			++borderEdgeCounts[v0];
+			++borderEdgeCounts[v1];
+		}
+
+		edgeIdx = end;
+	}
+
+	// border vertices with their average border edge length
+	borderVertices.clear();
+	borderEdgeLengths.clear();
+	for (uint32 vertexIdx = 0; vertexIdx < vertexCount; ++vertexIdx)
+	{
+		if (0 == borderEdgeCounts[vertexIdx])
+			continue;
+
+		borderVertices.push_back(vertexIdx);
+		borderEdgeLengths.push_back(lengthSums[vertexIdx] / borderEdgeCounts[vertexIdx]);
+	}
+}
+
+void MeshStitcher::findWeldPartners(vector<uint32> &replacements, const vector<uint32> &borderVertices,
+	const vector<Real> &borderEdgeLengths, const Real relativeWeldDistance) const
+{
+	// no welding by default
+	const uint32 vertexCount = (uint32) mPositions.size();
+	replacements.resize(vertexCount);
+	for (uint32 vertexIdx = 0; vertexIdx < vertexCount; ++vertexIdx)
+		replacements[vertexIdx] = vertexIdx;
+
+	const uint32 borderVertexCount = (uint32) borderVertices.size();
+	if (0 == borderVertexCount)
+		return;
+
+	// grid with cells of the maximum weld distance
+	Real cellSize = 0.0f;
+	Vector3 gridMin(REAL_MAX, REAL_MAX, REAL_MAX);
+	for (uint32 borderIdx = 0; borderIdx < borderVertexCount; ++borderIdx)
+	{
+		cellSize = (borderEdgeLengths[borderIdx] > cellSize ? borderEdgeLengths[borderIdx] : cellSize);
+		gridMin = gridMin.minimum(mPositions[borderVertices[borderIdx]]);
+	}
+	cellSize *= relativeWeldDistance;
+	if (cellSize <= 0.0f)
+		return;
+	const Real invCellSize = 1.0f / cellSize;
+
+	// sort border vertices by grid cell
+	vector<pair<uint64, uint32>> cells(borderVertexCount);
+	const uint64 COORD_MASK = (0x1ull << 21) - 1;
+	#pragma omp parallel for
+	for (int64 borderIdx = 0; borderIdx < borderVertexCount; ++borderIdx)
+	{
+		const Vector3 cell = (mPositions[borderVertices[borderIdx]] - gridMin) * invCellSize;
+		const uint64 key = ((((uint64) cell.x) & COORD_MASK) << 42) | ((((uint64) cell.y) & COORD_MASK) << 21) | (((uint64) cell.z) & COORD_MASK);
+		cells[borderIdx] = make_pair(key, (uint32) borderIdx);
+	}
+	sort(cells.begin(), cells.end());
+
+	// find the closest border vertex of another tile for each border vertex
+	vector<uint32> partners(borderVertexCount, Vertex::INVALID_IDX);
+	#pragma omp parallel for schedule(dynamic, 1024)
+	for (int64 i = 0; i < borderVertexCount; ++i)
+	{
+		const uint32 borderIdx = (uint32) i;
+		const uint32 vertexIdx = borderVertices[borderIdx];
+		const Vector3 &position = mPositions[vertexIdx];
+		const Vector3 cell = (position - gridMin) * invCellSize;
+		const int64 coords[3] = { (int64) cell.x, (int64) cell.y, (int64) cell.z };
+		Real bestDistance = REAL_MAX;
+
+		// check the 27 surrounding cells
+		for (int64 x = coords[0] - 1; x <= coords[0] + 1; ++x)
+		for (int64 y = coords[1] - 1; y <= coords[1] + 1; ++y)
+		for (int64 z = coords[2] - 1; z <= coords[2] + 1; ++z)
+		{
+			if (x < 0 || y < 0 || z < 0)
+				continue;
+
+			const uint64 key = ((((uint64) x) & COORD_MASK) << 42) | ((((uint64) y) & COORD_MASK) << 21) | (((uint64) z) & COORD_MASK);
+			vector<pair<uint64, uint32>>::const_iterator it = lower_bound(cells.begin(), cells.end(), make_pair(key, (uint32) 0));
+			for (; it != cells.end() && it->first == key; ++it)
+			{
+				// only weld vertices of different tiles
+				const uint32 otherBorderIdx = it->second;
+				const uint32 otherVertexIdx = borderVertices[otherBorderIdx];
+				if (mVertexTiles[otherVertexIdx] == mVertexTiles[vertexIdx])
+					continue;
+
+				// close enough?
+				const Real maxDistance = 0.5f * relativeWeldDistance * (borderEdgeLengths[borderIdx] + borderEdgeLengths[otherBorderIdx]);
+				const Real distance = (mPositions[otherVertexIdx] - position).getLength();
+				if (distance >= maxDistance || distance >= bestDistance)
+					continue;
+
+				bestDistance = distance;
+				partners[borderIdx] = otherBorderIdx;
+			}
+		}
+	}
+
+	// one-to-one welds of mutually closest vertices: the vertex of the later tile is replaced
+	// -> there are no weld chains and no triangle gets two of its vertices welded to the same vertex
+	for (uint32 borderIdx = 0; borderIdx < borderVertexCount; ++borderIdx)
+	{
+		const uint32 partner = partners[borderIdx];
+		if (Vertex::INVALID_IDX == partner || partners[partner] != borderIdx)
+			continue;
+
+		const uint32 vertexIdx = borderVertices[borderIdx];
+		const uint32 partnerVertexIdx = borderVertices[partner];
+		if (mVertexTiles[vertexIdx] > mVertexTiles[partnerVertexIdx])
+			replacements[vertexIdx] = partnerVertexIdx;
+	}
+}
+
+uint32 MeshStitcher::rejectInvalidWelds(vector<uint32> &replacements) const
+{
+	// only triangles at welded vertices or their partners can become invalid
+	const uint32 vertexCount = (uint32) mPositions.size();
+	const uint32 triangleCount = (uint32) (mIndices.size() / 3);
+	vector<uint8> seamVertices(vertexCount, 0);
+	vector<uint32> seamTriangles;
+
+	for (uint32 vertexIdx = 0; vertexIdx < vertexCount; ++vertexIdx)
+		if (replacements[vertexIdx] != vertexIdx)
+			seamVertices[vertexIdx] = seamVertices[replacements[vertexIdx]] = 1;
+
+	for (uint32 triangleIdx = 0; triangleIdx < triangleCount; ++triangleIdx)
+	{
+		const uint32 *triangle = mIndices.data() + 3 * triangleIdx;
+		if (seamVertices[triangle[0]] || seamVertices[triangle[1]] || seamVertices[triangle[2]])
+			seamTriangles.push_back(triangleIdx);
+	}
+
+	// undo welds of invalid triangles until there are none
+	const uint32 seamTriangleCount = (uint32) seamTriangles.size();
+	vector<pair<uint64, uint32>> edges;
+	vector<pair<pair<uint64, uint32>, uint32>> triangles;
+	vector<uint32> invalidTriangles;
+	uint32 rejectedCount = 0;
+
+	while (true)
+	{
+		// welded seam triangles: half edges as (edge key, 3 * triangle + corner) & sorted vertex triples
+		edges.clear();
+		triangles.clear();
+		invalidTriangles.clear();
+
+		for (uint32 seamIdx = 0; seamIdx < seamTriangleCount; ++seamIdx)
+		{
+			const uint32 triangleIdx = seamTriangles[seamIdx];
+			const uint32 *triangle = mIndices.data() + 3 * triangleIdx;
+			uint32 v[3] = { replacements[triangle[0]], replacements[triangle[1]], replacements[triangle[2]] };
+			if (v[0] == v[1] || v[1] == v[2] || v[2] == v[0])
+				continue;
+
+			for (uint32 cornerIdx = 0; cornerIdx < 3; ++cornerIdx)
+				edges.push_back(make_pair(getEdgeKey(v[cornerIdx], v[(cornerIdx + 1) % 3]), 3 * triangleIdx + cornerIdx));
+
+			sort(v, v + 3);
+			triangles.push_back(make_pair(make_pair((((uint64) v[0]) << 32) | v[1], v[2]), triangleIdx));
+		}
+		sort(edges.begin(), edges.end());
+		sort(triangles.begin(), triangles.end());
+
+		// edges with more than two triangles or with two triangles using them in the same direction
+		const uint32 halfEdgeCount = (uint32) edges.size();
+		for (uint32 edgeIdx = 0; edgeIdx < halfEdgeCount; )
+		{
+			uint32 end = edgeIdx + 1;
+			while (end < halfEdgeCount && edges[end].first == edges[edgeIdx].first)
+				++end;
+
+			bool invalid = (end - edgeIdx > 2);
+			if (end - edgeIdx == 2)
+			{
+				const uint32 h0 = edges[edgeIdx].second;
+				const uint32 h1 = edges[edgeIdx + 1].second;
+				invalid = (replacements[mIndices[h0]] == replacements[mIndices[h1]]);
+			}
+
+			if (invalid)
+				for (uint32 i = edgeIdx; i < end; ++i)
+					invalidTriangles.push_back(edges[i].second / 3);
+			edgeIdx = end;
+		}
+
+		// duplicate triangles
+		const uint32 weldedTriangleCount = (uint32) triangles.size();
+		for (uint32 i = 0; i < weldedTriangleCount; )
+		{
+			uint32 end = i + 1;
+			while (end < weldedTriangleCount && triangles[end].first == triangles[i].first)
+				++end;
+
+			if (end - i > 1)
+				for (uint32 j = i; j < end; ++j)
+					invalidTriangles.push_back(triangles[j].second);
+			i = end;
+		}
+
+		// undo the welds of the invalid triangles
+		uint32 undoneCount = 0;
+		const uint32 invalidCount = (uint32) invalidTriangles.size();
+		for (uint32 i = 0; i < invalidCount; ++i)
+		{
+			for (uint32 cornerIdx = 0; cornerIdx < 3; ++cornerIdx)
+			{
+				const uint32 vertexIdx = mIndices[3 * invalidTriangles[i] + cornerIdx];
+				if (replacements[vertexIdx] == vertexIdx)
+					continue;
+
+				replacements[vertexIdx] = vertexIdx;
+				++undoneCount;
+			}
+		}
+
+		// each round undoes at least one weld or stops
+		if (0 == undoneCount)
+			return rejectedCount;
+		rejectedCount += undoneCount;
+	}
+}
+
+uint32 MeshStitcher::zipSeamGaps(vector<uint32> &indices, const vector<uint32> &triangleTiles) const
+{
+	// all half edges as (edge key, index of its start)
+	const uint32 indexCount = (uint32) indices.size();
+	vector<pair<uint64, uint32>> edges(indexCount);
+
+	#pragma omp parallel for
+	for (int64 i = 0; i < indexCount; ++i)
+	{
+		const uint32 indexIdx = (uint32) i;
+		const uint32 v0 = indices[indexIdx];
+		const uint32 v1 = indices[indexIdx - (indexIdx % 3) + ((indexIdx + 1) % 3)];
+		edges[indexIdx] = make_pair(getEdgeKey(v0, v1), indexIdx);
+	}
+	sort(edges.begin(), edges.end());
+
+	// holes run against the border half edges: border half edge v0 -> v1 is hole edge v1 -> v0, stored as (v1, border half edge)
+	vector<pair<uint32, uint32>> holeEdges;
+	for (uint32 edgeIdx = 0; edgeIdx < indexCount; )
+	{
+		uint32 end = edgeIdx + 1;
+		while (end < indexCount && edges[end].first == edges[edgeIdx].first)
+			++end;
+
+		if (end - edgeIdx == 1)
+		{
+			const uint32 halfEdgeIdx = edges[edgeIdx].second;
+			const uint32 v1 = indices[halfEdgeIdx - (halfEdgeIdx % 3) + ((halfEdgeIdx + 1) % 3)];
+			holeEdges.push_back(make_pair(v1, halfEdgeIdx));
+		}
+
+		edgeIdx = end;
+	}
+	sort(holeEdges.begin(), holeEdges.end());
+
+	// successor of each hole edge v1 -> v0: a hole edge starting at v0
+	// (at border vertices with several triangle fans, it is the one which does not belong to the fan of the border half edge v0 -> v1)
+	const uint32 holeEdgeCount = (uint32) holeEdges.size();
+	vector<uint32> nextHoleEdges(holeEdgeCount, Vertex::INVALID_IDX);
+
+	#pragma omp parallel for
+	for (int64 i = 0; i < holeEdgeCount; ++i)
+	{
+		const uint32 holeEdgeIdx = (uint32) i;
+		const uint32 borderHalfEdge = holeEdges[holeEdgeIdx].second;
+		const uint32 v0 = indices[borderHalfEdge];
+
+		const uint32 first = (uint32) (lower_bound(holeEdges.begin(), holeEdges.end(), make_pair(v0, (uint32) 0)) - holeEdges.begin());
+		uint32 end = first;
+		while (end < holeEdgeCount && holeEdges[end].first == v0)
+			++end;
+
+		if (end - first == 1)
+		{
+			nextHoleEdges[holeEdgeIdx] = first;
+			continue;
+		}
+
+		// hole edge v0 -> fanVertex bounds the same triangle fan
+		const uint32 fanVertex = findFanBorderVertex(indices, edges, borderHalfEdge);
+		if (Vertex::INVALID_IDX == fanVertex)
+			continue;
+
+		uint32 candidateCount = 0;
+		for (uint32 candidate = first; candidate < end; ++candidate)
+		{
+			if (indices[holeEdges[candidate].second] == fanVertex)
+				continue;
+
+			nextHoleEdges[holeEdgeIdx] = candidate;
+			++candidateCount;
+		}
+
+		// ambiguous for more than two fans
+		if (1 != candidateCount)
+			nextHoleEdges[holeEdgeIdx] = Vertex::INVALID_IDX;
+	}
+
+	// zip each closed ring along seams
+	const uint32 vertexCount = (uint32) mPositions.size();
+	vector<uint8> visited(holeEdgeCount, 0);
+	vector<uint32> ringMarks(vertexCount, Vertex::INVALID_IDX);
+	vector<uint32> ring;
+	set<uint64> newEdges;
+	uint32 zippingTriangleCount = 0;
+
+	for (uint32 startEdge = 0; startEdge < holeEdgeCount; ++startEdge)
+	{
+		if (visited[startEdge])
+			continue;
+
+		// follow the ring
+		const uint32 firstTile = triangleTiles[holeEdges[startEdge].second / 3];
+		bool closed = false;
+		bool repeatedVertex = false;
+		bool croppedOnly = true;
+		bool severalTiles = false;
+		ring.clear();
+
+		for (uint32 holeEdgeIdx = startEdge; Vertex::INVALID_IDX != holeEdgeIdx && !visited[holeEdgeIdx]; holeEdgeIdx = nextHoleEdges[holeEdgeIdx])
+		{
+			visited[holeEdgeIdx] = 1;
+
+			const uint32 vertexIdx = holeEdges[holeEdgeIdx].first;
+			repeatedVertex |= (startEdge == ringMarks[vertexIdx]);
+			ringMarks[vertexIdx] = startEdge;
+			ring.push_back(vertexIdx);
+
+			croppedOnly &= (0 != mCroppedVertices[vertexIdx]);
+			severalTiles |= (triangleTiles[holeEdges[holeEdgeIdx].second / 3] != firstTile);
+			closed = (startEdge == nextHoleEdges[holeEdgeIdx]);
+		}
+
+		// only simple closed seam gaps, i.e., rings of cropped vertices between triangles of different tiles
+		// (no holes or borders of the tile meshes themselves and no seam sides without any weld which would only be capped)
+		if (!closed || repeatedVertex || !croppedOnly || !severalTiles || ring.size() < 3)
+			continue;
+
+		zippingTriangleCount += zipRing(indices, newEdges, edges, ring);
+	}
+
+	return zippingTriangleCount;
+}
+
+uint32 MeshStitcher::findFanBorderVertex(const vector<uint32> &indices, const vector<pair<uint64, uint32>> &edges, const uint32 borderHalfEdge) const
+{
+	// rotate around center from triangle to triangle via the triangle edges ending at center
+	const uint32 center = indices[borderHalfEdge];
+	uint32 halfEdge = borderHalfEdge;
+
+	while (true)
+	{
+		const uint32 previousHalfEdge = halfEdge - (halfEdge % 3) + ((halfEdge + 2) % 3);
+		const uint32 previousVertex = indices[previousHalfEdge];
+		const uint64 key = getEdgeKey(previousVertex, center);
+
+		// twin center -> previousVertex of the next triangle?
+		vector<pair<uint64, uint32>>::const_iterator it = lower_bound(edges.begin(), edges.end(), make_pair(key, (uint32) 0));
+		for (halfEdge = Vertex::INVALID_IDX; it != edges.end() && it->first == key; ++it)
+		{
+			if (it->second != previousHalfEdge && indices[it->second] == center)
+			{
+				halfEdge = it->second;
+				break;
+			}
+		}
+
+		// other border of the fan or closed fan (should not happen for a border vertex)
+		if (Vertex::INVALID_IDX == halfEdge)
+			return previousVertex;
+		if (borderHalfEdge == halfEdge)
+			return Vertex::INVALID_IDX;
+	}
+}
+
+uint32 MeshStitcher::zipRing(vector<uint32> &indices, set<uint64> &newEdges,
+	const vector<pair<uint64, uint32>> &edges, const vector<uint32> &ring) const
+{
+	// a triangular ring might just be the back of a single triangle
+	const uint32 ringSize = (uint32) ring.size();
+	if (3 == ringSize)
+	{
+		uint32 triangles[3];
+		for (uint32 i = 0; i < 3; ++i)
+			triangles[i] = lower_bound(edges.begin(), edges.end(), make_pair(getEdgeKey(ring[i], ring[(i + 1) % 3]), (uint32) 0))->second / 3;
+		if (triangles[0] == triangles[1] && triangles[1] == triangles[2])
+			return 0;
+	}
+
+	// ring as doubly linked list
+	vector<uint32> previous(ringSize);
+	vector<uint32> next(ringSize);
+	vector<uint8> clipped(ringSize, 0);
+	for (uint32 i = 0; i < ringSize; ++i)
+	{
+		previous[i] = (i + ringSize - 1) % ringSize;
+		next[i] = (i + 1) % ringSize;
+	}
+
+	// ears by the length of their new edge with their neighbors when they were found (previous << 32 | next)
+	typedef pair<Real, pair<uint32, uint64>> Ear;
+	priority_queue<Ear, vector<Ear>, greater<Ear>> ears;
+	for (uint32 i = 0; i < ringSize; ++i)
+	{
+		const Real length = (mPositions[ring[next[i]]] - mPositions[ring[previous[i]]]).getLength();
+		ears.push(make_pair(length, make_pair(i, (((uint64) previous[i]) << 32) | next[i])));
+	}
+
+	// clip the shortest valid ears
+	uint32 remainingCount = ringSize;
+	uint32 addedCount = 0;
+	while (remainingCount > 3 && !ears.empty())
+	{
+		// still an ear with the same neighbors?
+		const Ear ear = ears.top();
+		ears.pop();
+
+		const uint32 i = ear.second.first;
+		if (clipped[i] || ear.second.second != ((((uint64) previous[i]) << 32) | next[i]))
+			continue;
+
+		// the new edge must not exist already
+		const uint32 v0 = ring[previous[i]];
+		const uint32 v1 = ring[i];
+		const uint32 v2 = ring[next[i]];
+		const uint64 newEdge = getEdgeKey(v2, v0);
+		vector<pair<uint64, uint32>>::const_iterator it = lower_bound(edges.begin(), edges.end(), make_pair(newEdge, (uint32) 0));
+		if ((it != edges.end() && it->first == newEdge) || newEdges.end() != newEdges.find(newEdge))
+			continue;
+
+		// clip it
+		indices.push_back(v0);
+		indices.push_back(v1);
+		indices.push_back(v2);
+		newEdges.insert(newEdge);
+		++addedCount;
+
+		clipped[i] = 1;
+		next[previous[i]] = next[i];
+		previous[next[i]] = previous[i];
+		--remainingCount;
+
+		// the neighbors are new ears
+		const uint32 neighbors[2] = { previous[i], next[i] };
+		for (uint32 j = 0; j < 2; ++j)
+		{
+			const uint32 n = neighbors[j];
+			const Real length = (mPositions[ring[next[n]]] - mPositions[ring[previous[n]]]).getLength();
+			ears.push(make_pair(length, make_pair(n, (((uint64) previous[n]) << 32) | next[n])));
+		}
+	}
+
+	// last triangle (only consists of ring edges which have a single triangle each)
+	if (3 != remainingCount)
+		return addedCount;
+
+	uint32 i = 0;
+	while (clipped[i])
+		++i;
+	indices.push_back(ring[i]);
+	indices.push_back(ring[next[i]]);
+	indices.push_back(ring[next[next[i]]]);
+	return addedCount + 1;
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+#ifndef _MESH_STITCHER_H_
+#define _MESH_STITCHER_H_
+
+#include <cassert>
+#include <set>
+#include <utility>
+#include <vector>
+#include "Math/Vector3.h"
+#include "Platform/DataTypes.h"
+
+namespace SurfaceReconstruction
+{
+	class FlexibleMesh;
+
+	/** Combines meshes which were independently reconstructed for overlapping tiles of a scene into a single mesh.
+		Each tile mesh is cropped to the core of its tile (the tile without overlap) by keeping exactly the triangles with a centroid inside the core.
+		The cores of all tiles partition the scene so that every surface part is taken from exactly one tile.
+		Afterwards, mutually closest border vertices of different tiles along the seams are welded as long as the welded mesh stays edge manifold
+		and the remaining gaps along the seams are zipped with new triangles. */
+	class MeshStitcher
+	{
+	public:
+		MeshStitcher();
+
+		/** Adds the part of a tile mesh which is within the core of its tile.
+		@param mesh Set this to the mesh reconstructed for the tile including its overlap.
+		@param coreAABB Set this to the minimum [0] and maximum [1] corner of the tile without overlap.
+			Triangles are kept if their centroid c fulfills coreAABB[0] <= c < coreAABB[1] for all axes.
+		@param maxInclusive Set this to true for axes where the core ends at the scene border to keep triangles with centroid coordinate == coreAABB[1]. */
+		void addTile(const FlexibleMesh &mesh, const Math::Vector3 coreAABB[2], const bool maxInclusive[3]);
+
+		/** Welds close border vertices of different tiles, zips the remaining seam gaps and returns the stitched mesh.
+		@param relativeWeldDistance Border vertices of different tiles are welded if they are mutually closest
+			and their distance is below this factor times their average border edge length.
+		@return Returns a new mesh the caller is responsible for. */
+		FlexibleMesh *createStitchedMesh(const Real relativeWeldDistance);
+
+		inline uint32 getTileCount() const;
+
+	private:
+		/** Copy constructor is forbidden. Don't use it. */
+		inline MeshStitcher(const MeshStitcher &other);
+
+		/** Assignment operator is forbidden. Don't use it.*/
+		inline MeshStitcher &operator =(const MeshStitcher &rhs);
+
+		/** Finds all vertices at open borders and the average length of their border edges. */
+		void findBorderVertices(std::vector<uint32> &borderVertices, std::vector<Real> &borderEdgeLengths) const;
+
+		/** Finds for each border vertex the closest border vertex of another tile within the weld distance and welds mutually closest vertices.
+			Welds are thus one-to-one and the vertex of the later tile is replaced by the one of the earlier tile.
+		@param replacements Is set to the vertex each vertex is welded to or to itself. */
+		void findWeldPartners(std::vector<uint32> &replacements, const std::vector<uint32> &borderVertices,
+			const std::vector<Real> &borderEdgeLengths, const Real relativeWeldDistance) const;
+
+		/** Undoes welds until no welded triangle has an edge with more than two triangles, an edge which is used twice in the same direction or a duplicate.
+		@param replacements Set this to the weld replacements of findWeldPartners. Invalid welds are reset to the replaced vertices themselves.
+		@return Returns the number of undone welds. */
+		uint32 rejectInvalidWelds(std::vector<uint32> &replacements) const;
+
+		/** Closes the remaining gaps along the seams by adding triangles between existing vertices.
+			Each closed ring of border edges which only consists of cropped vertices and which borders triangles of more than one tile
+			is zipped by repeatedly clipping the ear with the shortest new edge.
+			Ears which would create an edge which already exists are skipped so that the mesh stays edge manifold.
+		@param indices Set this to the triangles of the welded mesh. The zipping triangles are appended.
+		@param triangleTiles Set this to the index of the tile each triangle of indices stems from.
+		@return Returns the number of added triangles. */
+		uint32 zipSeamGaps(std::vector<uint32> &indices, const std::vector<uint32> &triangleTiles) const;
+
+		/** Rotates around the start vertex of a border half edge through the triangles around it until the other border of this triangle fan.
+		@param indices Set this to the triangles of the welded mesh.
+		@param edges Set this to the sorted edge keys and their half edge indices of indices.
+		@param borderHalfEdge Set this to the index of the start of a half edge in indices which is the only one of its edge.
+		@return Returns the start vertex of the border half edge which ends at the start of borderHalfEdge and bounds the same fan
+			or Vertex::INVALID_IDX if the fan is closed. */
+		uint32 findFanBorderVertex(const std::vector<uint32> &indices, const std::vector<std::pair<uint64, uint32>> &edges,
+			const uint32 borderHalfEdge) const;
+
+		/** Zips a single ring of border vertices of zipSeamGaps.
+		@param indices The zipping triangles are appended to these triangles.
+		@param newEdges Set this to the edges which were created by zipping so far. The new edges of ring are added.
+		@param edges Set this to the sorted edge keys and their half edge indices of indices before zipping.
+		@param ring Set this to the border vertices in hole order, i.e., against the winding order of their triangles.
+		@return Returns the number of added triangles. */
+		uint32 zipRing(std::vector<uint32> &indices, std::set<uint64> &newEdges,
+			const std::vector<std::pair<uint64, uint32>> &edges, const std::vector<uint32> &ring) const;
+
+		/** Returns the key of the undirected edge between v0 and v1 with the smaller vertex index in the upper half. */
+		inline static uint64 getEdgeKey(const uint32 v0, const uint32 v1);
+
+	private:
+		// stitched geometry
+		std::vector<Math::Vector3> mColors;
+		std::vector<Math::Vector3> mNormals;
+		std::vector<Math::Vector3> mPositions;
+		std::vector<Real> mScales;
+		std::vector<uint32> mIndices;
+
+		std::vector<uint32> mVertexTiles;	/// Stores for each vertex the index of the tile it stems from.
+		std::vector<uint8> mCroppedVertices;	/// Stores for each vertex whether it was used by a triangle outside the core of its tile, i.e., whether it is at a seam.
+		uint32 mTileCount;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	///   inline function definitions   ////////////////////////////////////////////////////////////////////////////////////
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	inline MeshStitcher::MeshStitcher(const MeshStitcher &other)
+	{
+		assert(false);
+	}
+
+	inline MeshStitcher &MeshStitcher::operator =(const MeshStitcher &rhs)
+	{
+		assert(false);
+		return *this;
+	}
+
+	inline uint64 MeshStitcher::getEdgeKey(const uint32 v0, const uint32 v1)
+	{
+		return (v0 < v1 ? (((uint64) v0) << 32) | v1 : (((uint64) v1) << 32) | v0);
+	}
+
+	inline uint32 MeshStitcher::getTileCount() const
+	{
+		return mTileCount;
+	}
+}
+
+#endif // _MESH_STITCHER_H_
@@ -15,6 +15,7 @@
 #include "SurfaceReconstruction/Geometry/RayTracer.h" 
 #include "SurfaceReconstruction/Geometry/Triangle.h"
 #include "SurfaceReconstruction/Scene/Scene.h"
+#include "SurfaceReconstruction/Scene/StageProfiler.h"
 #include "SurfaceReconstruction/Scene/View.h"
 
 using namespace FailureHandling;
@@ -112,6 +113,9 @@ void RayTracer::createStaticScene(const Vector3 *positions, const uint32 vertexC
 
 	// create scene and add a triangle mesh to represent mesh
 	const uint32 triangleCount = indexCount / 3; 
+	StageProfiler::Scope profilerScope("RayTracingSceneBuild", "triangles");
+	profilerScope.addItems(triangleCount);
+
 	mSceneCoherency = (coherentSceneTracing ? RTC_SCENE_COHERENT : RTC_SCENE_INCOHERENT);
 	const RTCSceneFlags sceneFlags = RTC_SCENE_STATIC | RTC_SCENE_HIGH_QUALITY | RTC_SCENE_ROBUST | mSceneCoherency;
 	const RTCAlgorithmFlags sceneAlgorithmFlags = RTC_INTERSECT_STREAM;
@@ -370,7 +374,8 @@ bool RayTracer::findIntersection(Surfel &surfel, const Math::Vector3 &rayStartWS
 
 void RayTracer::findIntersectionsForViewSamplePairs(
 	const bool backFaceCulling, const uint32 startPairIdx, const uint32 endPairIdx, const uint32 rayBatchSize,
-	const Utilities::Size2<uint32> &raysPerViewSamplePair, const bool orientLikeViews)
+	const Utilities::Size2<uint32> &raysPerViewSamplePair, const bool orientLikeViews, const uint32 *pairOrder,
+	const uint32 *patternSubset, const uint32 patternSubsetSize)
 {
 	cout << "findIntersectionsForViewSamplePairs" << endl;
 
@@ -381,12 +386,15 @@ void RayTracer::findIntersectionsForViewSamplePairs(
 
 	// configure ray tracer
 	const uint32 pairCount = endPairIdx - startPairIdx;
-	const uint32 raysPerPair = raysPerViewSamplePair.getElementCount();
+	const uint32 raysPerPair = (patternSubset ? patternSubsetSize : raysPerViewSamplePair.getElementCount());
 	const uint32 rayCount = pairCount * raysPerPair;
 
 	setMaximumRayCount(rayCount);
 	setBackFaceCulling(backFaceCulling);
 
+	StageProfiler::Scope profilerScope("RayTracing", "rays");
+	profilerScope.addItems(rayCount);
+
 	// for each ray: from camera to sample
 	#pragma omp parallel for
 	for (int64 i = 0; i < rayCount; ++i)
@@ -394,7 +402,8 @@ void RayTracer::findIntersectionsForViewSamplePairs(
 		// get indices
 		const uint32 rayIdx = (uint32) i;
 		const uint32 localPairIdx = rayIdx / raysPerPair;
-		const uint32 globalPairIdx = localPairIdx + startPairIdx;
+		const uint32 orderIdx = localPairIdx + startPairIdx;
+		const uint32 globalPairIdx = (pairOrder ? pairOrder[orderIdx] : orderIdx);
 		const uint32 sampleIdx = samples.getSampleIdx(globalPairIdx);
 		const uint32 viewIdx = samples.getViewIdx(globalPairIdx);
 		
@@ -439,8 +448,9 @@ void RayTracer::findIntersectionsForViewSamplePairs(
 		}
 
 		// get remaining data for sampling pattern
-		const uint32 localSamplingIdx = (rayIdx % raysPerPair);
-		const uint32 localSamplingCoords[2] = { localSamplingIdx % raysPerViewSamplePair[0], localSamplingIdx / raysPerViewSamplePair[1] };
+		const uint32 localRayIdx = (rayIdx % raysPerPair);
+		const uint32 localSamplingIdx = (patternSubset ? patternSubset[localRayIdx] : localRayIdx);
+		const uint32 localSamplingCoords[2] = { localSamplingIdx % raysPerViewSamplePair[0], localSamplingIdx / raysPerViewSamplePair[0] };
 
 		// ray direction = towards sampling point of sampling pattern of sample patch
 		Vector2 offset = getRelativeSamplingOffset(localSamplingCoords, raysPerViewSamplePair);
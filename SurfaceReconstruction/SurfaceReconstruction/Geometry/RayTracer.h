@@ -58,9 +58,17 @@ namespace SurfaceReconstruction
 		//void filterForBackFaceCulling(int *valid, RTCRayN *ray, const RTCHitN *potentionHit, const size_t N, const bool forOcclusionTest) const;
 		
 		bool findIntersection(Surfel &surfel, const Math::Vector3 &rayStartWS, const Math::Vector3 &rayDirWS, const bool backFaceCulling = true);
+
+		/** Traces rays from the views to the samples of the view sample pairs [startPairIdx, endPairIdx).
+		@param pairOrder Set this to NULL to trace the pairs in view cone index order (see Samples::getViewIdx) or to an array of view cone indices
+			to trace the view cones pairOrder[startPairIdx], ..., pairOrder[endPairIdx - 1] instead.
+		@param patternSubset Set this to NULL to trace the complete supersampling pattern of each pair or to an array of patternSubsetSize
+			row major pattern indices (x + y * raysPerViewSamplePair[0]) to trace only these rays per pair. Ray rayIdx then belongs to pair
+			rayIdx / patternSubsetSize and pattern entry patternSubset[rayIdx % patternSubsetSize]. */
 		void findIntersectionsForViewSamplePairs(
 			const bool backFaceCulling,	const uint32 startPairIdx, const uint32 endPairIdx, const uint32 rayBatchSize,
-			const Utilities::Size2<uint32> &raysPerViewSamplePair, const bool orientLikeView);
+			const Utilities::Size2<uint32> &raysPerViewSamplePair, const bool orientLikeView, const uint32 *pairOrder = NULL,
+			const uint32 *patternSubset = NULL, const uint32 patternSubsetSize = 0);
 		void findIntersectionsAlongMeshNormals(const Math::Vector3 *normals, const Real *searchLengths, 
 			const Real searchLengthScaleFactor, const bool backFaceCulling);
 
@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+#ifndef _SIMD_REAL_H_
+#define _SIMD_REAL_H_
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+	#include <immintrin.h>
+#endif
+#include "Platform/DataTypes.h"
+
+/** Thin wrappers around the widest single precision vector instructions the compiler is allowed to use (see -march=native in the top level CMakeLists.txt).
+	SIMD_REAL_WIDTH is the number of floats per vector and it is only defined if AVX-512 or AVX2 is available.
+	Callers must check that Real is float and otherwise, or if SIMD_REAL_WIDTH is not defined, fall back to scalar code. */
+#if defined(__AVX512F__)
+	#define SIMD_REAL_WIDTH 16
+#elif defined(__AVX2__)
+	#define SIMD_REAL_WIDTH 8
+#endif
+
+#ifdef SIMD_REAL_WIDTH
+
+namespace SurfaceReconstruction
+{
+	namespace SIMD
+	{
+		#if defined(__AVX512F__)
+			typedef __m512 Vector;
+			typedef __mmask16 Mask;
+		#else
+			typedef __m256 Vector;
+			typedef __m256 Mask;
+		#endif
+
+		/** Returns a vector with the entered value in each lane. */
+		inline Vector set(const float value);
+
+		/** Loads SIMD_REAL_WIDTH consecutive floats from source which does not need to be aligned. */
+		inline Vector load(const float *source);
+
+		/** Loads every third float starting at source, e.g., all x-coordinates of SIMD_REAL_WIDTH consecutive Math::Vector3 objects. */
+		inline Vector loadStrided3(const float *source);
+
+		/** Stores all lanes to target which does not need to be aligned. */
+		inline void store(float *target, const Vector &v);
+
+		inline Vector add(const Vector &lhs, const Vector &rhs);
+		inline Vector sub(const Vector &lhs, const Vector &rhs);
+		inline Vector mul(const Vector &lhs, const Vector &rhs);
+		inline Vector div(const Vector &lhs, const Vector &rhs);
+		inline Vector max(const Vector &lhs, const Vector &rhs);
+		inline Vector sqrt(const Vector &v);
+
+		inline Mask isLess(const Vector &lhs, const Vector &rhs);
+		inline Mask isGreaterEqual(const Vector &lhs, const Vector &rhs);
+		inline Mask both(const Mask &lhs, const Mask &rhs);
+
+		/** Returns ifTrue for each lane with a set mask bit and ifFalse for all other lanes. */
+		inline Vector select(const Mask &mask, const Vector &ifTrue, const Vector &ifFalse);
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		///   inline function definitions   ////////////////////////////////////////////////////////////////////////////////////
+		////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+		#if defined(__AVX512F__)
+
+			inline Vector set(const float value)
+			{
+				return _mm512_set1_ps(value);
+			}
+
+			inline Vector load(const float *source)
+			{
+				return _mm512_loadu_ps(source);
+			}
+
+			inline Vector loadStrided3(const float *source)
+			{
+				const __m512i offsets = _mm512_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21, 24, 27, 30, 33, 36, 39, 42, 45);
+				return _mm512_i32gather_ps(offsets, source, sizeof(float));
+			}
+
+			inline void store(float *target, const Vector &v)
+			{
+				_mm512_storeu_ps(target, v);
+			}
+
+			inline Vector add(const Vector &lhs, const Vector &rhs)
+			{
+				return _mm512_add_ps(lhs, rhs);
+			}
+
+			inline Vector sub(const Vector &lhs, const Vector &rhs)
+			{
+				return _mm512_sub_ps(lhs, rhs);
+			}
+
+			inline Vector mul(const Vector &lhs, const Vector &rhs)
+			{
+				return _mm512_mul_ps(lhs, rhs);
+			}
+
+			inline Vector div(const Vector &lhs, const Vector &rhs)
+			{
+				return _mm512_div_ps(lhs, rhs);
+			}
+
+			inline Vector max(const Vector &lhs, const Vector &rhs)
+			{
+				return _mm512_max_ps(lhs, rhs);
+			}
+
+			inline Vector sqrt(const Vector &v)
+			{
+				return _mm512_sqrt_ps(v);
+			}
+
+			inline Mask isLess(const Vector &lhs, const Vector &rhs)
+			{
+				return _mm512_cmp_ps_mask(lhs, rhs, _CMP_LT_OQ);
+			}
+
+			inline Mask isGreaterEqual(const Vector &lhs, const Vector &rhs)
+			{
+				return _mm512_cmp_ps_mask(lhs, rhs, _CMP_GE_OQ);
+			}
+
+			inline Mask both(const Mask &lhs, const Mask &rhs)
+			{
+				return (Mask) (lhs & rhs);
+			}
+
+			inline Vector select(const Mask &mask, const Vector &ifTrue, const Vector &ifFalse)
+			{
+				return _mm512_mask_blend_ps(mask, ifFalse, ifTrue);
+			}
+
+		#else
+
+			inline Vector set(const float value)
+			{
+				return _mm256_set1_ps(value);
+			}
+
+			inline Vector load(const float *source)
+			{
+				return _mm256_loadu_ps(source);
+			}
+
+			inline Vector loadStrided3(const float *source)
+			{
+				const __m256i offsets = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+				return _mm256_i32gather_ps(source, offsets, sizeof(float));
+			}
+
+			inline void store(float *target, const Vector &v)
+			{
+				_mm256_storeu_ps(target, v);
+			}
+
+			inline Vector add(const Vector &lhs, const Vector &rhs)
+			{
+				return _mm256_add_ps(lhs, rhs);
+			}
+
+			inline Vector sub(const Vector &lhs, const Vector &rhs)
+			{
+				return _mm256_sub_ps(lhs, rhs);
+			}
+
+			inline Vector mul(const Vector &lhs, const Vector &rhs)
+			{
+				return _mm256_mul_ps(lhs, rhs);
+			}
+
+			inline Vector div(const Vector &lhs, const Vector &rhs)
+			{
+				return _mm256_div_ps(lhs, rhs);
+			}
+
+			inline Vector max(const Vector &lhs, const Vector &rhs)
+			{
+				return _mm256_max_ps(lhs, rhs);
+			}
+
+			inline Vector sqrt(const Vector &v)
+			{
+				return _mm256_sqrt_ps(v);
+			}
+
+			inline Mask isLess(const Vector &lhs, const Vector &rhs)
+			{
+				return _mm256_cmp_ps(lhs, rhs, _CMP_LT_OQ);
+			}
+
+			inline Mask isGreaterEqual(const Vector &lhs, const Vector &rhs)
+			{
+				return _mm256_cmp_ps(lhs, rhs, _CMP_GE_OQ);
+			}
+
+			inline Mask both(const Mask &lhs, const Mask &rhs)
+			{
+				return _mm256_and_ps(lhs, rhs);
+			}
+
+			inline Vector select(const Mask &mask, const Vector &ifTrue, const Vector &ifFalse)
+			{
+				return _mm256_blendv_ps(ifFalse, ifTrue, mask);
+			}
+
+		#endif // __AVX512F__
+	}
+}
+
+#endif // SIMD_REAL_WIDTH
+
+#endif // _SIMD_REAL_H_
@@ -23,7 +23,7 @@ namespace SurfaceReconstruction
 	public:
 		Math::Vector3 mNormal;		/// normal of triangle mTriangleIdx
 		Math::Vector3 mPosition;	/// 3D world space position
-		Real mBaryCoords[2];		/// 3D point mPosition's barycentric coordinates w.r.t. triangle mTriangleIdx
+		Real mBaryCoords[2];		/// 3D point mPosition's barycentric weights of the vertices 0 and 1 of triangle mTriangleIdx (vertex 2 weight = 1 - [0] - [1])
 		uint32 mTriangleIdx;		/// Identifies the mesh triangle onto which this point was reprojected.
 	};
 
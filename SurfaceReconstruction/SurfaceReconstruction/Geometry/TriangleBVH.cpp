@@ -0,0 +1,454 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+
+#include <algorithm>
+#include "CollisionDetection/CollisionDetection.h"
+#include "Math/MathHelper.h"
+#include "SurfaceReconstruction/Geometry/Surfel.h"
+#include "SurfaceReconstruction/Geometry/TriangleBVH.h"
+#include "SurfaceReconstruction/Scene/StageProfiler.h"
+#include "SurfaceReconstruction/Scene/Tree/Nodes.h"
+#include "SurfaceReconstruction/Scene/Tree/Tree.h"
+
+using namespace CollisionDetection;
+using namespace Math;
+using namespace std;
+using namespace SurfaceReconstruction;
+
+const uint32 TriangleBVH::MAX_DEPTH = 64;
+const uint32 TriangleBVH::MAX_LEAF_SIZE = 4;
+const uint32 TriangleBVH::MIN_TRAVERSAL_TASK_COUNT = 256;
+
+Vector3 TriangleBVH::getClosestPoint(Real baryCoords[2], const Vector3 &p, const Vector3 triangle[3])
+{
+	// Voronoi regions of the triangle vertices, edges & face, see Ericson: Real-Time Collision Detection
+	const Vector3 &a = triangle[0];
+	const Vector3 &b = triangle[1];
+	const Vector3 &c = triangle[2];
+	const Vector3 ab = b - a;
+	const Vector3 ac = c - a;
+
+	// vertex a?
+	const Vector3 ap = p - a;
+	const Real d1 = ab.dotProduct(ap);
+	const Real d2 = ac.dotProduct(ap);
+	if (d1 <= 0.0f && d2 <= 0.0f)
+	{
+		baryCoords[0] = 1.0f;
+		baryCoords[1] = 0.0f;
+		return a;
+	}
+
+	// vertex b?
+	const Vector3 bp = p - b;
+	const Real d3 = ab.dotProduct(bp);
+	const Real d4 = ac.dotProduct(bp);
+	if (d3 >= 0.0f && d4 <= d3)
+	{
+		baryCoords[0] = 0.0f;
+		baryCoords[1] = 1.0f;
+		return b;
+	}
+
+	// edge ab?
+	const Real vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+	{
+		const Real v = d1 / (d1 - d3);
+		baryCoords[0] = 1.0f - v;
+		baryCoords[1] = v;
+		return a + ab * v;
+	}
+
+	// vertex c?
+	const Vector3 cp = p - c;
+	const Real d5 = ab.dotProduct(cp);
+	const Real d6 = ac.dotProduct(cp);
+	if (d6 >= 0.0f && d5 <= d6)
+	{
+		baryCoords[0] = 0.0f;
+		baryCoords[1] = 0.0f;
+		return c;
+	}
+
+	// edge ac?
+	const Real vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+	{
+		const Real w = d2 / (d2 - d6);
+		baryCoords[0] = 1.0f - w;
+		baryCoords[1] = 0.0f;
+		return a + ac * w;
+	}
+
+	// edge bc?
+	const Real va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+	{
+		const Real w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		baryCoords[0] = 0.0f;
+		baryCoords[1] = 1.0f - w;
+		return b + (c - b) * w;
+	}
+
+	// face
+	const Real denominator = 1.0f / (va + vb + vc);
+	const Real v = vb * denominator;
+	const Real w = vc * denominator;
+	baryCoords[0] = 1.0f - v - w;
+	baryCoords[1] = v;
+	return a + ab * v + ac * w;
+}
+
+TriangleBVH::TriangleBVH() :
+	mPositions(NULL), mIndices(NULL)
+{
+
+}
+
+void TriangleBVH::build(const Vector3 *positions, const uint32 *indices, const uint32 triangleCount)
+{
+	clear();
+	if (0 == triangleCount)
+		return;
+
+	StageProfiler::Scope profilerScope("TriangleBVHBuild", "triangles");
+	profilerScope.addItems(triangleCount);
+
+	mPositions = positions;
+	mIndices = indices;
+
+	// triangle centroids & boxes
+	vector<Vector3> centroids(triangleCount);
+	vector<Vector3> boxes(2 * triangleCount);
+	mTriangles.resize(triangleCount);
+
+	#pragma omp parallel for
+	for (int64 i = 0; i < triangleCount; ++i)
+	{
+		const uint32 triangleIdx = (uint32) i;
+		const uint32 *triangle = indices + 3 * triangleIdx;
+		const Vector3 corners[3] = { positions[triangle[0]], positions[triangle[1]], positions[triangle[2]] };
+		Vector3 &minimum = boxes[2 * triangleIdx];
+		Vector3 &maximum = boxes[2 * triangleIdx + 1];
+
+		minimum = corners[0];
+		maximum = corners[0];
+		for (uint32 cornerIdx = 1; cornerIdx < 3; ++cornerIdx)
+		{
+			for (uint32 axis = 0; axis < 3; ++axis)
+			{
+				minimum[axis] = min(minimum[axis], corners[cornerIdx][axis]);
+				maximum[axis] = max(maximum[axis], corners[cornerIdx][axis]);
+			}
+		}
+
+		centroids[triangleIdx] = (corners[0] + corners[1] + corners[2]) / 3.0f;
+		mTriangles[triangleIdx] = triangleIdx;
+	}
+
+	// root covers all triangles
+	mNodes.reserve(2 * ((triangleCount + MAX_LEAF_SIZE - 1) / MAX_LEAF_SIZE));
+	mNodes.resize(1);
+	mNodes[0].mFirst = 0;
+	mNodes[0].mTriangleCount = triangleCount;
+
+	// top down in breadth first order: split nodes at the centroid median along their largest centroid extent
+	for (uint32 nodeIdx = 0; nodeIdx < mNodes.size(); ++nodeIdx)
+	{
+		const uint32 first = mNodes[nodeIdx].mFirst;
+		const uint32 count = mNodes[nodeIdx].mTriangleCount;
+
+		// boxes around the node triangles & their centroids
+		Vector3 aabb[2] = { Vector3(REAL_MAX, REAL_MAX, REAL_MAX), Vector3(-REAL_MAX, -REAL_MAX, -REAL_MAX) };
+		Vector3 centroidsAABB[2] = { aabb[0], aabb[1] };
+
+		for (uint32 localIdx = 0; localIdx < count; ++localIdx)
+		{
+			const uint32 triangleIdx = mTriangles[first + localIdx];
+			const Vector3 &centroid = centroids[triangleIdx];
+
+			for (uint32 axis = 0; axis < 3; ++axis)
+			{
+				aabb[0][axis] = min(aabb[0][axis], boxes[2 * triangleIdx][axis]);
+				aabb[1][axis] = max(aabb[1][axis], boxes[2 * triangleIdx + 1][axis]);
+				centroidsAABB[0][axis] = min(centroidsAABB[0][axis], centroid[axis]);
+				centroidsAABB[1][axis] = max(centroidsAABB[1][axis], centroid[axis]);
+			}
+		}
+
+		mNodes[nodeIdx].mAABB[0] = aabb[0];
+		mNodes[nodeIdx].mAABB[1] = aabb[1];
+		if (count <= MAX_LEAF_SIZE)
+			continue;
+
+		// split axis
+		const Vector3 extent = centroidsAABB[1] - centroidsAABB[0];
+		uint32 axis = 0;
+		if (extent[1] > extent[axis])
+			axis = 1;
+		if (extent[2] > extent[axis])
+			axis = 2;
+
+		// median split keeps the tree balanced
+		const uint32 leftCount = count / 2;
+		uint32 *nodeTriangles = mTriangles.data() + first;
+		nth_element(nodeTriangles, nodeTriangles + leftCount, nodeTriangles + count, CentroidComparer(centroids.data(), axis));
+
+		// children
+		const uint32 childIdx = (uint32) mNodes.size();
+		mNodes.resize(childIdx + 2);
+		mNodes[nodeIdx].mFirst = childIdx;
+		mNodes[nodeIdx].mTriangleCount = 0;
+		mNodes[childIdx].mFirst = first;
+		mNodes[childIdx].mTriangleCount = leftCount;
+		mNodes[childIdx + 1].mFirst = first + leftCount;
+		mNodes[childIdx + 1].mTriangleCount = count - leftCount;
+	}
+}
+
+void TriangleBVH::clear()
+{
+	mNodes.clear();
+	mTriangles.clear();
+	mPositions = NULL;
+	mIndices = NULL;
+}
+
+bool TriangleBVH::findClosestPoint(Surfel &surfel, const Vector3 &queryPosWS, const Real maxDistance, const Vector3 *viewPosWS) const
+{
+	if (mNodes.empty())
+		return false;
+
+	Real bestDistanceSq = maxDistance * maxDistance;
+	bool found = false;
+
+	// depth first traversal: at most one pending sibling per level
+	uint32 stack[MAX_DEPTH + 1];
+	uint32 stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		// too far away?
+		const Node &node = mNodes[stack[--stackSize]];
+		if (getSquaredDistance(node, queryPosWS) >= bestDistanceSq)
+			continue;
+
+		// inner node: visit the closer child first to shrink the search radius early
+		if (0 == node.mTriangleCount)
+		{
+			assert(stackSize + 2 <= MAX_DEPTH + 1);
+			const Real distanceSq0 = getSquaredDistance(mNodes[node.mFirst], queryPosWS);
+			const Real distanceSq1 = getSquaredDistance(mNodes[node.mFirst + 1], queryPosWS);
+			const uint32 closerChild = (distanceSq0 <= distanceSq1 ? 0 : 1);
+
+			stack[stackSize++] = node.mFirst + !closerChild;
+			stack[stackSize++] = node.mFirst + closerChild;
+			continue;
+		}
+
+		// leaf: closest point of each triangle
+		for (uint32 localIdx = 0; localIdx < node.mTriangleCount; ++localIdx)
+		{
+			const uint32 triangleIdx = mTriangles[node.mFirst + localIdx];
+			const uint32 *indices = mIndices + 3 * triangleIdx;
+			const Vector3 triangle[3] = { mPositions[indices[0]], mPositions[indices[1]], mPositions[indices[2]] };
+
+			// only front faces w.r.t. the view like with back face culling?
+			Vector3 normal;
+			Math::computeTriangleNormal(normal, triangle[0], triangle[1], triangle[2]);
+			if (viewPosWS && normal.dotProduct(*viewPosWS - triangle[0]) <= 0.0f)
+				continue;
+
+			Real baryCoords[2];
+			const Vector3 closestPoint = getClosestPoint(baryCoords, queryPosWS, triangle);
+			const Real distanceSq = (closestPoint - queryPosWS).getLengthSquared();
+			if (distanceSq >= bestDistanceSq)
+				continue;
+
+			// new closest surface point
+			bestDistanceSq = distanceSq;
+			found = true;
+
+			surfel.mNormal = normal;
+			surfel.mPosition = closestPoint;
+			surfel.mBaryCoords[0] = baryCoords[0];
+			surfel.mBaryCoords[1] = baryCoords[1];
+			surfel.mTriangleIdx = triangleIdx;
+		}
+	}
+
+	return found;
+}
+
+void TriangleBVH::findMinIntersectedLeafSizes(vector<Real> &minLeafSizes, const Tree &tree) const
+{
+	const uint32 triangleCount = (uint32) mTriangles.size();
+	minLeafSizes.clear();
+	minLeafSizes.resize(triangleCount, REAL_MAX);
+	if (mNodes.empty())
+		return;
+
+	StageProfiler::Scope profilerScope("TriangleLeafSizes", "triangles");
+	profilerScope.addItems(triangleCount);
+
+	// independent sub hierarchies for parallel traversals: expand the top levels breadth first
+	vector<uint32> startNodes(1, 0);
+	vector<uint32> nextStartNodes;
+	bool expanded = true;
+	while (expanded && startNodes.size() < MIN_TRAVERSAL_TASK_COUNT)
+	{
+		expanded = false;
+		nextStartNodes.clear();
+
+		const uint32 startNodeCount = (uint32) startNodes.size();
+		for (uint32 localIdx = 0; localIdx < startNodeCount; ++localIdx)
+		{
+			const Node &node = mNodes[startNodes[localIdx]];
+			if (0 != node.mTriangleCount)
+			{
+				nextStartNodes.push_back(startNodes[localIdx]);
+				continue;
+			}
+
+			nextStartNodes.push_back(node.mFirst);
+			nextStartNodes.push_back(node.mFirst + 1);
+			expanded = true;
+		}
+
+		startNodes.swap(nextStartNodes);
+	}
+
+	// traverse each sub hierarchy together with the scene tree (triangles & thus written sizes are disjoint)
+	const Nodes &nodes = tree.getNodes();
+	const Scope rootScope = tree.getRootScope();
+	const int64 startNodeCount = startNodes.size();
+
+	#pragma omp parallel for schedule(dynamic, 1)
+	for (int64 i = 0; i < startNodeCount; ++i)
+		findMinIntersectedLeafSizes(minLeafSizes.data(), nodes, rootScope, startNodes[i]);
+}
+
+void TriangleBVH::findMinIntersectedLeafSizes(Real *minLeafSizes, const Nodes &nodes, const Scope &rootScope, const uint32 startNodeIdx) const
+{
+	vector<NodePair> stack;
+	NodePair start;
+	start.mScope = rootScope;
+	start.mNodeIdx = startNodeIdx;
+	stack.push_back(start);
+
+	while (!stack.empty())
+	{
+		// boxes overlap?
+		const NodePair pair = stack.back();
+		stack.pop_back();
+
+		const Node &node = mNodes[pair.mNodeIdx];
+		if (!isOverlapping(node, pair.mScope))
+			continue;
+
+		// hierarchy leaf: exact triangle tests within the current scene tree subtree
+		if (0 != node.mTriangleCount)
+		{
+			for (uint32 localIdx = 0; localIdx < node.mTriangleCount; ++localIdx)
+			{
+				const uint32 triangleIdx = mTriangles[node.mFirst + localIdx];
+				findMinIntersectedLeafSize(minLeafSizes[triangleIdx], nodes, pair.mScope, triangleIdx);
+			}
+			continue;
+		}
+
+		// split the hierarchy node if it is larger than the scene tree node or if the latter is a leaf
+		const Vector3 extent = node.mAABB[1] - node.mAABB[0];
+		const Real maxExtent = max(extent.x, max(extent.y, extent.z));
+		const uint32 sceneNodeIdx = pair.mScope.getNodeIndex();
+
+		if (nodes.isLeaf(sceneNodeIdx) || maxExtent >= pair.mScope.getSize())
+		{
+			NodePair child = pair;
+			for (uint32 childIdx = 0; childIdx < 2; ++childIdx)
+			{
+				child.mNodeIdx = node.mFirst + childIdx;
+				stack.push_back(child);
+			}
+			continue;
+		}
+
+		// split the scene tree node
+		NodePair child = pair;
+		for (uint32 childIdx = 0; childIdx < Nodes::CHILD_COUNT; ++childIdx)
+		{
+			child.mScope = nodes.getChildScope(pair.mScope, childIdx);
+			stack.push_back(child);
+		}
+	}
+}
+
+void TriangleBVH::findMinIntersectedLeafSize(Real &minLeafSize, const Nodes &nodes, const Scope &scope, const uint32 triangleIdx) const
+{
+	const uint32 *indices = mIndices + 3 * triangleIdx;
+	const Vector3 &v0 = mPositions[indices[0]];
+	const Vector3 &v1 = mPositions[indices[1]];
+	const Vector3 &v2 = mPositions[indices[2]];
+
+	// depth first like LeavesIterator with TriangleNodesChecker
+	vector<Scope> stack(1, scope);
+	while (!stack.empty())
+	{
+		const Scope current = stack.back();
+		stack.pop_back();
+
+		// intersection?
+		const Vector3 &minimum = current.getMinimumCoordinates();
+		const Vector3 maximum = current.getMaximumCoordinates();
+		if (!intersectAABBWithTriangle(minimum, maximum, v0, v1, v2))
+			continue;
+
+		// leaf?
+		if (nodes.isLeaf(current.getNodeIndex()))
+		{
+			if (current.getSize() < minLeafSize)
+				minLeafSize = current.getSize();
+			continue;
+		}
+
+		for (uint32 childIdx = 0; childIdx < Nodes::CHILD_COUNT; ++childIdx)
+			stack.push_back(nodes.getChildScope(current, childIdx));
+	}
+}
+
+Real TriangleBVH::getSquaredDistance(const Node &node, const Vector3 &p)
+{
+	Real distanceSq = 0.0f;
+	for (uint32 axis = 0; axis < 3; ++axis)
+	{
+		Real difference = 0.0f;
+		if (p[axis] < node.mAABB[0][axis])
+			difference = node.mAABB[0][axis] - p[axis];
+		else if (p[axis] > node.mAABB[1][axis])
+			difference = p[axis] - node.mAABB[1][axis];
+
+		distanceSq += difference * difference;
+	}
+
+	return distanceSq;
+}
+
+bool TriangleBVH::isOverlapping(const Node &node, const Scope &scope)
+{
+	const Vector3 &minimum = scope.getMinimumCoordinates();
+	const Vector3 maximum = scope.getMaximumCoordinates();
+
+	for (uint32 axis = 0; axis < 3; ++axis)
+		if (node.mAABB[0][axis] > maximum[axis] || node.mAABB[1][axis] < minimum[axis])
+			return false;
+
+	return true;
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+#ifndef _TRIANGLE_BVH_H_
+#define _TRIANGLE_BVH_H_
+
+#include <cassert>
+#include <vector>
+#include "Math/Vector3.h"
+#include "Platform/DataTypes.h"
+#include "SurfaceReconstruction/Scene/Tree/Scope.h"
+
+namespace SurfaceReconstruction
+{
+	class Nodes;
+	struct Surfel;
+	class Tree;
+
+	/** Bounding volume hierarchy of axis aligned boxes over the triangles of a mesh for closest point queries which Embree 2 does not provide
+		and for finding the scene tree leaves intersected by all triangles in a simultaneous traversal of both trees.
+		It is built via median splits along the largest centroid extent and shares the position & index buffers of the mesh.
+		The mesh must therefore not change as long as the hierarchy is used. Queries are thread safe. */
+	class TriangleBVH
+	{
+	public:
+		/// Inner node with two children or leaf with triangles.
+		struct Node
+		{
+		public:
+			Math::Vector3 mAABB[2];	/// Minimum [0] and maximum [1] corner of the box around all triangles of the node.
+			uint32 mFirst;			/// Index of the first child (the second one is mFirst + 1) for inner nodes or of the first entry in mTriangles for leaves.
+			uint32 mTriangleCount;	/// Number of triangles of a leaf or 0 for inner nodes.
+		};
+
+		/// Orders triangle indices by the coordinate mAxis of their centroids for median splits.
+		struct CentroidComparer
+		{
+		public:
+			inline CentroidComparer(const Math::Vector3 *centroids, const uint32 axis);
+			inline bool operator ()(const uint32 leftTriangleIdx, const uint32 rightTriangleIdx) const;
+
+		public:
+			const Math::Vector3 *mCentroids;
+			const uint32 mAxis;
+		};
+
+	public:
+		/** Computes the point of triangle which is closest to p.
+		@param baryCoords Is set to the barycentric weights of triangle[0] (baryCoords[0]) and triangle[1] (baryCoords[1]) for the closest point.
+			The weight of triangle[2] is 1 - baryCoords[0] - baryCoords[1].
+			This is the convention RayTracer::getHitData uses for Surfel::mBaryCoords (Embree's 1 - u - v and u).
+		@return Returns the closest point. */
+		static Math::Vector3 getClosestPoint(Real baryCoords[2], const Math::Vector3 &p, const Math::Vector3 triangle[3]);
+
+	public:
+		/** Creates an empty hierarchy. */
+		TriangleBVH();
+
+		/** Builds the hierarchy for the triangles defined by positions and indices.
+		@param positions Is shared and must be valid until the next build or clear call.
+		@param indices Is shared and must be valid until the next build or clear call. 3 consecutive vertex indices define a triangle. */
+		void build(const Math::Vector3 *positions, const uint32 *indices, const uint32 triangleCount);
+
+		/** Frees the hierarchy. */
+		void clear();
+
+		/** Finds the surface point which is closest to queryPosWS.
+		@param surfel Is set to the closest surface point if there is one within maxDistance.
+		@param queryPosWS Set this to the world space position of the query.
+		@param maxDistance Only surface points with a distance to queryPosWS below this are considered.
+		@param viewPosWS Set this to NULL to consider all triangles or to a view position to only consider triangles which face the view.
+		@return Returns true if a surface point was found. */
+		bool findClosestPoint(Surfel &surfel, const Math::Vector3 &queryPosWS, const Real maxDistance,
+			const Math::Vector3 *viewPosWS = NULL) const;
+
+		/** Finds for each triangle the smallest size of the scene tree leaves it intersects.
+			Both trees are traversed simultaneously so that neighboring triangles share the tests of upper tree levels.
+			Only the triangle & leaf pairs with overlapping boxes are tested exactly like via TriangleNodesChecker.
+		@param minLeafSizes Is resized to the triangle count and set to the smallest intersected leaf size per triangle or REAL_MAX if there is none.
+		@param tree Set this to the scene tree which is tested for intersections. */
+		void findMinIntersectedLeafSizes(std::vector<Real> &minLeafSizes, const Tree &tree) const;
+
+		inline uint32 getNodeCount() const;
+
+	private:
+		/** Copy constructor is forbidden. Don't use it. */
+		inline TriangleBVH(const TriangleBVH &other);
+
+		/** Assignment operator is forbidden. Don't use it.*/
+		inline TriangleBVH &operator =(const TriangleBVH &rhs);
+
+		/** Returns the squared distance between p and the box of node or 0 if p is inside the box. */
+		static Real getSquaredDistance(const Node &node, const Math::Vector3 &p);
+
+		/** Returns true if the box of node and the scene tree node box of scope overlap or touch. */
+		static bool isOverlapping(const Node &node, const Scope &scope);
+
+		/** Tests triangle triangleIdx exactly against the scene tree node of scope and its descendants and updates minLeafSize via the intersected leaves. */
+		void findMinIntersectedLeafSize(Real &minLeafSize, const Nodes &nodes, const Scope &scope, const uint32 triangleIdx) const;
+
+		/** Simultaneous traversal of the sub hierarchy at node startNodeIdx and the scene tree starting at rootScope. See findMinIntersectedLeafSizes. */
+		void findMinIntersectedLeafSizes(Real *minLeafSizes, const Nodes &nodes, const Scope &rootScope, const uint32 startNodeIdx) const;
+
+	public:
+		static const uint32 MAX_DEPTH;		/// Maximum tree depth which limits the query stack size.
+		static const uint32 MAX_LEAF_SIZE;	/// Nodes with at most this many triangles are not split.
+		static const uint32 MIN_TRAVERSAL_TASK_COUNT;	/// Simultaneous traversals with the scene tree start at at least this many hierarchy nodes if possible for parallelization.
+
+	private:
+		/// Hierarchy node and scene tree node which are visited together by findMinIntersectedLeafSizes.
+		struct NodePair
+		{
+		public:
+			Scope mScope;		/// Scene tree node.
+			uint32 mNodeIdx;	/// Hierarchy node.
+		};
+
+	private:
+		std::vector<Node> mNodes;			/// Root node first.
+		std::vector<uint32> mTriangles;		/// Triangle indices ordered so that each leaf references a contiguous range.
+
+		// shared mesh buffers
+		const Math::Vector3 *mPositions;
+		const uint32 *mIndices;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	///   inline function definitions   ////////////////////////////////////////////////////////////////////////////////////
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	inline TriangleBVH::CentroidComparer::CentroidComparer(const Math::Vector3 *centroids, const uint32 axis) :
+		mCentroids(centroids), mAxis(axis)
+	{
+
+	}
+
+	inline bool TriangleBVH::CentroidComparer::operator ()(const uint32 leftTriangleIdx, const uint32 rightTriangleIdx) const
+	{
+		return mCentroids[leftTriangleIdx][mAxis] < mCentroids[rightTriangleIdx][mAxis];
+	}
+
+	inline TriangleBVH::TriangleBVH(const TriangleBVH &other)
+	{
+		assert(false);
+	}
+
+	inline TriangleBVH &TriangleBVH::operator =(const TriangleBVH &rhs)
+	{
+		assert(false);
+		return *this;
+	}
+
+	inline uint32 TriangleBVH::getNodeCount() const
+	{
+		return (uint32) mNodes.size();
+	}
+}
+
+#endif // _TRIANGLE_BVH_H_
@@ -62,9 +62,64 @@ FSSFParameters::FSSFParameters()
 	// outlier removal stuff
 	ok &= m.get(mOutlierIsleMinKeepingSize, "FSSF::outlierIsleMinKeepingSize");
 
+	// optional parameters: caching of MeshDijkstra searches
+	mCacheGeodesicNeighborhoods = false;
+	mGeodesicCacheMaxMegabytes = 2048;
+	m.get(mCacheGeodesicNeighborhoods, "FSSF::cacheGeodesicNeighborhoods");
+	m.get(mGeodesicCacheMaxMegabytes, "FSSF::geodesicCacheMaxMegabytes");
+
+	// optional parameters: coherent view sample pair order
+	mSortViewSamplePairs = false;
+	m.get(mSortViewSamplePairs, "FSSF::sortViewSamplePairs");
+
+	// optional parameters: adaptive supersampling of view sample pairs
+	mAdaptiveSupersampling = false;
+	mValidateAdaptiveSupersampling = false;
+	mAdaptiveSamplingMaxRelativeDepthDifference = 0.1f;
+	mAdaptiveSamplingMaxAngleDifference = 5.0f;
+	m.get(mAdaptiveSupersampling, "FSSF::adaptiveSupersampling");
+	m.get(mValidateAdaptiveSupersampling, "FSSF::validateAdaptiveSupersampling");
+	m.get(mAdaptiveSamplingMaxRelativeDepthDifference, "FSSF::adaptiveSamplingMaxRelativeDepthDifference");
+	m.get(mAdaptiveSamplingMaxAngleDifference, "FSSF::adaptiveSamplingMaxDegreesDifference");
+
+	// optional parameters: closest point projection of samples in late iterations
+	mClosestPointProjection = false;
+	mClosestPointProjectionMaxRelativeMovement = 0.05f;
+	m.get(mClosestPointProjection, "FSSF::closestPointProjection");
+	m.get(mClosestPointProjectionMaxRelativeMovement, "FSSF::closestPointProjectionMaxRelativeMovement");
+
+	// optional parameters: coarse to fine view sample pair subsets
+	mStochasticPairSubsets = false;
+	mPairSubsetMinFraction = 0.125f;
+	mPairSubsetFullMovement = 0.1f;
+	m.get(mStochasticPairSubsets, "FSSF::stochasticPairSubsets");
+	m.get(mPairSubsetMinFraction, "FSSF::pairSubsetMinFraction");
+	m.get(mPairSubsetFullMovement, "FSSF::pairSubsetFullMovement");
+
+	// optional parameters: spatial mesh reordering
+	mMeshReordering = false;
+	mMeshReorderingRelativeChurn = 0.5f;
+	m.get(mMeshReordering, "FSSF::meshReordering");
+	m.get(mMeshReorderingRelativeChurn, "FSSF::meshReorderingRelativeChurn");
+
+	// optional parameters: single pass vertex update
+	mFusedVertexUpdate = false;
+	mValidateFusedVertexUpdate = false;
+	m.get(mFusedVertexUpdate, "FSSF::fusedVertexUpdate");
+	m.get(mValidateFusedVertexUpdate, "FSSF::validateFusedVertexUpdate");
+
+	// optional parameters: precomputed surface kernel search steps
+	mCacheDijkstraSteps = true;
+	m.get(mCacheDijkstraSteps, "FSSF::cacheDijkstraSteps");
+
+	// optional parameters: edge merge rounds
+	mEdgeMergeOneRingRechecks = false;
+	m.get(mEdgeMergeOneRingRechecks, "FSSF::edgeMergeOneRingRechecks");
+
 	// convert degrees to angles
 	mSpikyGeometryAngleThreshold = convertDegreesToRadians(mSpikyGeometryAngleThreshold);
 	mSupportSampleMaxAngleDifference = convertDegreesToRadians(mSupportSampleMaxAngleDifference);
+	mAdaptiveSamplingMaxAngleDifference = convertDegreesToRadians(mAdaptiveSamplingMaxAngleDifference);
 
 	// check that all parameters were ok properly
 	if (ok)
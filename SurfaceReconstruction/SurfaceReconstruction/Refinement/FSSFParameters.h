@@ -44,6 +44,26 @@ namespace SurfaceReconstruction
 		uint32 mOutlierIsleMinKeepingSize;
 		Utilities::Size2<uint32> mRaysPerViewSamplePair;
 		bool mOrientSamplingPatternLikeView;
+
+		// optional parameters
+		uint32 mGeodesicCacheMaxMegabytes;	/// Memory limit for cached geodesic neighborhoods, see mCacheGeodesicNeighborhoods.
+		bool mCacheGeodesicNeighborhoods;	/// Reuse surface kernel searches of samples projected onto the same triangle within an iteration?
+		bool mCacheDijkstraSteps;			/// Precompute edge normals & lengths once per iteration instead of within each surface kernel search?
+		bool mSortViewSamplePairs;			/// Process view sample pairs grouped by view for coherent rays and surface kernel searches?
+		Real mAdaptiveSamplingMaxRelativeDepthDifference;	/// Probe hits on other triangles than the center hit must be closer than this times the sample scale to the center tangent plane.
+		Real mAdaptiveSamplingMaxAngleDifference;			/// Maximum angle in radians between the hit normals of probes on other triangles than the center hit.
+		bool mAdaptiveSupersampling;		/// Trace only a probe subset of the supersampling pattern and the complete pattern only for pairs with disagreeing probes?
+		bool mValidateAdaptiveSupersampling;	/// Also trace the complete pattern for all pairs and report the deviations of the adaptive mode from it?
+		Real mClosestPointProjectionMaxRelativeMovement;	/// Mean vertex movement relative to vertex scales below which samples are projected onto closest points.
+		bool mClosestPointProjection;		/// Project samples onto closest surface points instead of tracing ray patterns once the surface hardly moves anymore?
+		Real mPairSubsetMinFraction;		/// Smallest fraction of view sample pairs which is processed in an iteration with pair subsets.
+		Real mPairSubsetFullMovement;		/// All pairs are processed once the mean vertex movement relative to vertex scales is below this.
+		bool mStochasticPairSubsets;		/// Process only stratified random view sample pair subsets in early iterations while the surface still moves much?
+		Real mMeshReorderingRelativeChurn;	/// The mesh is reordered once the number of created & deleted vertices since the last reordering reaches this times the vertex count.
+		bool mMeshReordering;				/// Renumber mesh elements spatially after much topology churn for coherent memory accesses?
+		bool mFusedVertexUpdate;			/// Normalize weighted sums, mark unsupported vertices and move vertices in a single pass over the vertex data?
+		bool mValidateFusedVertexUpdate;	/// Run the separate passes and the fused vertex update on the same data, keep the fused results and count vertices with differing results?
+		bool mEdgeMergeOneRingRechecks;		/// Also recheck the triangles around merged vertices in later edge merge rounds and continue merging until a round merges nothing? (Mesh quality option which adds work and changes results.)
 	};
 }
 
@@ -7,6 +7,7 @@
  * of the BSD 3-Clause license. See the License.txt file for details.
  */
 
+#include <cstring>
 #include <iostream>
 #include <omp.h>
 #include "CollisionDetection/CollisionDetection.h"
@@ -17,8 +18,11 @@
 #include "SurfaceReconstruction/Refinement/FSSFParameters.h"
 #include "SurfaceReconstruction/Refinement/FSSFRefiner.h"
 #include "SurfaceReconstruction/Refinement/MeshDijkstra.h"
+#include "SurfaceReconstruction/Scene/AsyncMeshWriter.h"
 #include "SurfaceReconstruction/Scene/Scene.h"
+#include "SurfaceReconstruction/Scene/StageProfiler.h"
 #include "SurfaceReconstruction/Scene/Tree/LeavesIterator.h"
+#include "SurfaceReconstruction/Scene/Tree/Nodes.h"
 #include "SurfaceReconstruction/Scene/Tree/Tree.h"
 #include "SurfaceReconstruction/Scene/Tree/TriangleNodesChecker.h"
 #include "SurfaceReconstruction/Scene/View.h"
@@ -40,6 +44,14 @@ const uint32 FSSFRefiner::EMBREE_RAY_BATCH_SIZE = 0x1 << 16;
 const uint32 FSSFRefiner::MEMORY_ALLOCATION_FACTOR = 0x1 << 4;
 const uint32 FSSFRefiner::OMP_PAIR_BATCH_COUNT = 0x1 << 15;
 const uint32 FSSFRefiner::OMP_PAIR_BATCH_SIZE = 0x1 << 7;
+const uint32 FSSFRefiner::PROBE_RAY_COUNT = 5;
+
+FSSFRefiner::AdaptiveSamplingReport::AdaptiveSamplingReport() :
+	mPairCount(0), mRefinedPairCount(0), mTracedRayCount(0), mFixedPatternRayCount(0),
+	mValidatedPairCount(0), mDecisionMismatchCount(0), mConfidenceErrorSum(0.0), mMaxConfidenceError(0.0f)
+{
+
+}
 
 FSSFRefiner::FSSFRefiner(const FlexibleMesh &initialMesh) :
 	FSSFRefiner()
@@ -60,7 +72,10 @@ FSSFRefiner::FSSFRefiner(const string &meshFileName) :
 }
 
 FSSFRefiner::FSSFRefiner() : 
-	mDijkstras(NULL), mLocalConfidences(NULL)//, mLocalEdgeWeights(NULL)
+	mDijkstras(NULL), mLocalConfidences(NULL), //mLocalEdgeWeights(NULL),
+	mMeanRelativeMovement(REAL_MAX), mUsingClosestPointProjection(false),
+	mPairSubsetFraction(1.0f), mAllPairsRequired(false),
+	mTopologyChurn(0), mFusedVertexUpdateMismatchCount(0)
 {
 	// objects for parallel dijkstra searches	
 	const uint32 maxNumThreads = omp_get_max_threads();
@@ -102,33 +117,86 @@ void FSSFRefiner::refine()
 bool FSSFRefiner::doRefinementStep(const uint32 iteration)
 {
 	cout << "Starting sample-based refinement step. Iteration: " << iteration << "." << endl;
+	StageProfiler::Scope iterationScope("Iteration", "vertices");
+	iterationScope.addItems(mMesh.getVertexCount());
 	
 	// remove triangles with too small side lengths or altitudes
-	simplifyMesh(iteration);
-	mMesh.checkEdges();
+	{
+		StageProfiler::Scope profilerScope("Simplification", "triangles");
+		profilerScope.addItems(mMesh.getTriangleCount());
+
+		simplifyMesh(iteration);
+		mMesh.checkEdges();
+	}
 
 	// floating scale quantities, such as colors, errors etc. via kernel-based interpolations
 	kernelInterpolation();
 	mMesh.checkEdges();
 
 	// correct the mesh w.r.t. the samples (move surface towards the samples using the floating scale vertex movement field)
-	mMesh.computeVertexScales(mMesh.getScales(), mVertexNeighbors.data(), mVertexNeighborsOffsets.data(), mMesh.getPositions(), mMesh.getVertexCount());
-	moveVertices();
+	{
+		StageProfiler::Scope profilerScope("VertexMovement", "vertices");
+		profilerScope.addItems(mMesh.getVertexCount());
+
+		mMesh.computeVertexScales(mMesh.getScales(), mVertexNeighbors.data(), mVertexNeighborsOffsets.data(), mMesh.getPositions(), mMesh.getVertexCount());
+		if (mParams.mValidateFusedVertexUpdate)
+			validateFusedVertexUpdate();
+		else if (mParams.mFusedVertexUpdate)
+			updateVertices();
+		else
+			moveVertices();
+	}
 	updateObservers(iteration, "FSSFMoved", IReconstructorObserver::RECONSTRUCTION_VIA_SAMPLES);
 	
 	// regularization & resolution stuff
-	enforceRegularGeometry(iteration);
+	{
+		StageProfiler::Scope profilerScope("Regularization", "vertices");
+		profilerScope.addItems(mMesh.getVertexCount());
+		enforceRegularGeometry(iteration);
+	}
 
 	// error stats
-	const bool stop = computeErrorStatistics(iteration);
+	bool stop = false;
+	{
+		StageProfiler::Scope profilerScope("ErrorStatistics", "vertices");
+		profilerScope.addItems(mMesh.getVertexCount());
+		stop = computeErrorStatistics(iteration);
+	}
 
 	// save intermediate result
-	saveResult(iteration);
+	{
+		StageProfiler::Scope profilerScope("Saving", "vertices");
+		profilerScope.addItems(mMesh.getVertexCount());
+		saveResult(iteration);
+	}
+
+	// converged result must stem from all pairs
+	if (stop && isUsingPairSubset())
+	{
+		cout << "Converged with a subset of the view sample pairs. Continuing with all pairs." << endl;
+		mAllPairsRequired = true;
+		stop = false;
+	}
 	if (stop)
 		return true;
 
-	subdivideMesh();
-	mMesh.checkEdges();
+	{
+		StageProfiler::Scope profilerScope("Subdivision", "triangles");
+		profilerScope.addItems(mMesh.getTriangleCount());
+
+		subdivideMesh();
+		mMesh.checkEdges();
+	}
+
+	// spatially coherent memory layout after much topology churn
+	if (mParams.mMeshReordering && mTopologyChurn >= mParams.mMeshReorderingRelativeChurn * mMesh.getVertexCount())
+	{
+		StageProfiler::Scope profilerScope("MeshReordering", "vertices");
+		profilerScope.addItems(mMesh.getVertexCount());
+
+		mMesh.reorderSpatially();
+		mTopologyChurn = 0;
+	}
 
 	cout << "Finished sample-based refinement step." << endl;
 	return false;
@@ -136,28 +204,98 @@ bool FSSFRefiner::doRefinementStep(const uint32 iteration)
 
 void FSSFRefiner::kernelInterpolation()
 {
+	// Dijkstra expansions for throughput
+	StageProfiler::Scope profilerScope("KernelInterpolation", "expansions");
+	const uint32 maxNumThreads = omp_get_max_threads();
+	uint64 expansionCount = 0;
+	for (uint32 threadIdx = 0; threadIdx < maxNumThreads; ++threadIdx)
+		expansionCount -= mDijkstras[threadIdx].getExpansionCount();
+
 	// prepare computation of floating scale quantities from mesh & ray hits
 	mMesh.computeNormalsOfTriangles(mTriangleNormals.data());
 	mMesh.getVertexNeighbors(mVertexNeighbors, mVertexNeighborsOffsets);
+	if (mParams.mCacheDijkstraSteps)
+		MeshDijkstra::computeSteps(mDijkstraSteps, mMesh, mTriangleNormals.data(), mVertexNeighbors.data(), mVertexNeighborsOffsets.data());
 
 	zeroFloatingScaleQuantities();
-	mRayTracer.createStaticScene(mMesh.getPositions(), mMesh.getVertexCount(), mMesh.getIndices(), mMesh.getIndexCount(), true);
+
+	// switch from ray patterns to cheaper closest points as soon as the surface hardly moves anymore
+	if (mParams.mClosestPointProjection && !mUsingClosestPointProjection &&
+		mMeanRelativeMovement < mParams.mClosestPointProjectionMaxRelativeMovement)
+	{
+		cout << "Switching to closest point projection of samples. Mean relative vertex movement: " << mMeanRelativeMovement << endl;
+		mUsingClosestPointProjection = true;
+	}
+
+	if (mUsingClosestPointProjection)
+		mTriangleBVH.build(mMesh.getPositions(), mMesh.getIndices(), mMesh.getTriangleCount());
+	else
+		mRayTracer.createStaticScene(mMesh.getPositions(), mMesh.getVertexCount(), mMesh.getIndices(), mMesh.getIndexCount(), true);
+
+	// reuse surface kernel searches of samples hitting the same triangles?
+	if (isUsingDijkstraCache())
+		mDijkstraCache.reset(&mMesh, mTriangleNormals.data(), mVertexNeighbors.data(), mVertexNeighborsOffsets.data(),
+			((uint64) mParams.mGeodesicCacheMaxMegabytes) << 20, getDijkstraSteps());
 
 	// for all ray hits: apply surface kernel & sample downweighting functions
 	cout << "Summing of weighted quantities via surface kernels." << endl;
 	const Scene &scene = Scene::getSingleton();
 	const Samples &samples = scene.getSamples();
-	const uint32 pairCount = samples.getMaxViewConeCount();
+
+	// pairs in view cone index order or grouped by view?
+	const uint32 *pairOrder = NULL;
+	uint32 pairCount = samples.getMaxViewConeCount();
+	if (mParams.mSortViewSamplePairs)
+	{
+		updateViewSamplePairOrder();
+		pairOrder = mViewSamplePairOrder.data();
+		pairCount = (uint32) mViewSamplePairOrder.size();
+	}
+
+	// coarse to fine: only a random subset of the pairs while the surface still moves much?
+	mPairSubsetFraction = getPairSubsetFraction();
+	mAllPairsRequired = false;
+	if (mPairSubsetFraction < 1.0f)
+	{
+		selectPairSubset(pairOrder, pairCount, mPairSubsetFraction);
+		pairOrder = mPairSubset.data();
+		pairCount = (uint32) mPairSubset.size();
+	}
+
+	// adaptive supersampling: probe pattern center first & then the 4 pattern corners
+	const Size2<uint32> &pattern = mParams.mRaysPerViewSamplePair;
+	const bool adaptive = !mUsingClosestPointProjection && isUsingAdaptiveSupersampling();
+	const uint32 probePattern[] =
+	{
+		pattern[0] / 2 + (pattern[1] / 2) * pattern[0],
+		0, pattern[0] - 1, (pattern[1] - 1) * pattern[0], pattern.getElementCount() - 1
+	};
+	AdaptiveSamplingReport report;
+	if (mParams.mAdaptiveSupersampling && !adaptive && !mUsingClosestPointProjection)
+		cout << "Adaptive supersampling requires odd pattern dimensions larger than 1 x 1. Tracing complete patterns." << endl;
+
+	// closest points instead of ray patterns?
+	if (mUsingClosestPointProjection)
+		projectSamplesOntoClosestPoints(pairOrder, pairCount);
+	const uint32 rayTracedPairCount = (mUsingClosestPointProjection ? 0 : pairCount);
 	
 	// ray trace scene from sensors to samples in batches
-	for (uint32 startPairIdx = 0; startPairIdx < pairCount; startPairIdx += EMBREE_PAIR_BATCH_SIZE)
+	for (uint32 startPairIdx = 0; startPairIdx < rayTracedPairCount; startPairIdx += EMBREE_PAIR_BATCH_SIZE)
 	{
 		// find intersections
 		uint32 batchSize = EMBREE_PAIR_BATCH_SIZE;
-		if (batchSize + startPairIdx > pairCount)
-			batchSize = pairCount - startPairIdx;
+		if (batchSize + startPairIdx > rayTracedPairCount)
+			batchSize = rayTracedPairCount - startPairIdx;
+
+		// probes first & complete patterns only where necessary?
+		if (adaptive)
+		{
+			processViewSamplePairsAdaptively(report, probePattern, pairOrder, startPairIdx, batchSize);
+			continue;
+		}
+
 		mRayTracer.findIntersectionsForViewSamplePairs(true, startPairIdx, startPairIdx + batchSize,
-			EMBREE_RAY_BATCH_SIZE, mParams.mRaysPerViewSamplePair, mParams.mOrientSamplingPatternLikeView);
+			EMBREE_RAY_BATCH_SIZE, mParams.mRaysPerViewSamplePair, mParams.mOrientSamplingPatternLikeView, pairOrder);
 
 		// process ray tracing results
 		cout << "Processing projected samples." << endl;
@@ -165,7 +303,8 @@ void FSSFRefiner::kernelInterpolation()
 		for (int64 i = 0; i < batchSize; ++i)
 		{
 			const uint32 localPairIdx = (uint32) i;
-			const uint32 globalPairIdx = localPairIdx + startPairIdx;
+			const uint32 orderIdx = localPairIdx + startPairIdx;
+			const uint32 globalPairIdx = (pairOrder ? pairOrder[orderIdx] : orderIdx);
 			const uint32 sampleIdx = samples.getSampleIdx(globalPairIdx);
 			ProjectedSample projectedSample;
 			
@@ -179,9 +318,315 @@ void FSSFRefiner::kernelInterpolation()
 		}
 	}
 
+	// adaptive supersampling savings & accuracy
+	if (adaptive)
+	{
+		cout << "Adaptive supersampling: refined pairs: " << report.mRefinedPairCount << " of " << report.mPairCount;
+		cout << ", traced rays: " << report.mTracedRayCount << " instead of " << report.mFixedPatternRayCount << endl;
+		if (report.mValidatedPairCount > 0)
+		{
+			cout << "Adaptive supersampling validation: compared pairs: " << report.mValidatedPairCount;
+			cout << ", accept / discard mismatches: " << report.mDecisionMismatchCount;
+			cout << ", mean confidence error: " << report.mConfidenceErrorSum / report.mValidatedPairCount;
+			cout << ", max confidence error: " << report.mMaxConfidenceError << endl;
+		}
+	}
+
+	// the caches & the hierarchy are invalid as soon as the mesh changes
+	mTriangleBVH.clear();
+	mDijkstraSteps.clear();
+	if (isUsingDijkstraCache())
+	{
+		cout << "Cached geodesic neighborhoods: " << mDijkstraCache.getNeighborhoodCount();
+		cout << ", memory: " << (mDijkstraCache.getByteCount() >> 20) << " MB" << endl;
+		mDijkstraCache.clear();
+	}
+
+	// deterministic mode: order independent sums -> weighted sums
+	if (!mFixedVertexSums.empty())
+		applyFixedVertexSums();
+
 	// normalize floating scale quantities / weighted sums (scales, colors & corrections)
-	normalize();
-	markUnreliableVerticesViaSupport();
+	// or do it together with the vertex movement, see updateVertices & validateFusedVertexUpdate
+	if (!mParams.mFusedVertexUpdate && !mParams.mValidateFusedVertexUpdate)
+	{
+		normalize();
+		markUnreliableVerticesViaSupport();
+	}
+
+	for (uint32 threadIdx = 0; threadIdx < maxNumThreads; ++threadIdx)
+		expansionCount += mDijkstras[threadIdx].getExpansionCount();
+	profilerScope.addItems(expansionCount);
+}
+
+void FSSFRefiner::processViewSamplePairsAdaptively(AdaptiveSamplingReport &report, const uint32 *probePattern,
+	const uint32 *pairOrder, const uint32 startPairIdx, const uint32 pairCount)
+{
+	const Samples &samples = Scene::getSingleton().getSamples();
+	const uint32 patternSize = mParams.mRaysPerViewSamplePair.getElementCount();
+	const int64 batchSize = pairCount;
+
+	// explicit view cone indices to trace pair subsets of the batch
+	mBatchPairs.resize(pairCount);
+	for (uint32 localPairIdx = 0; localPairIdx < pairCount; ++localPairIdx)
+	{
+		const uint32 orderIdx = localPairIdx + startPairIdx;
+		mBatchPairs[localPairIdx] = (pairOrder ? pairOrder[orderIdx] : orderIdx);
+	}
+
+	// validation: reference results of the complete patterns
+	const bool validate = mParams.mValidateAdaptiveSupersampling;
+	if (validate)
+	{
+		mValidationSamples.resize(pairCount);
+		mRayTracer.findIntersectionsForViewSamplePairs(true, 0, pairCount,
+			EMBREE_RAY_BATCH_SIZE, mParams.mRaysPerViewSamplePair, mParams.mOrientSamplingPatternLikeView, mBatchPairs.data());
+
+		#pragma omp parallel for schedule(dynamic, OMP_PAIR_BATCH_SIZE)
+		for (int64 i = 0; i < batchSize; ++i)
+		{
+			const uint32 localPairIdx = (uint32) i;
+			getProjectedSample(mValidationSamples[localPairIdx], localPairIdx, samples.getSampleIdx(mBatchPairs[localPairIdx]));
+		}
+	}
+
+	// probe rays
+	mRayTracer.findIntersectionsForViewSamplePairs(true, 0, pairCount,
+		EMBREE_RAY_BATCH_SIZE, mParams.mRaysPerViewSamplePair, mParams.mOrientSamplingPatternLikeView, mBatchPairs.data(),
+		probePattern, PROBE_RAY_COUNT);
+
+	// process pairs with agreeing probes & flag the others
+	cout << "Processing probed projected samples." << endl;
+	mPairRefinementFlags.resize(pairCount);
+	uint64 validatedPairCount = 0;
+	uint64 decisionMismatchCount = 0;
+	double confidenceErrorSum = 0.0;
+	vector<Real> maxConfidenceErrors(omp_get_max_threads(), report.mMaxConfidenceError); // per thread for a race free maximum
+
+	#pragma omp parallel for schedule(dynamic, OMP_PAIR_BATCH_SIZE) reduction(+ : validatedPairCount, decisionMismatchCount, confidenceErrorSum)
+	for (int64 i = 0; i < batchSize; ++i)
+	{
+		const uint32 localPairIdx = (uint32) i;
+		const uint32 sampleIdx = samples.getSampleIdx(mBatchPairs[localPairIdx]);
+		ProjectedSample projectedSample;
+
+		// complete pattern required?
+		const bool agreement = getProbedProjectedSample(projectedSample, localPairIdx, sampleIdx);
+		mPairRefinementFlags[localPairIdx] = (agreement ? 0 : 1);
+		if (!agreement)
+			continue;
+
+		const bool used = (Triangle::INVALID_IDX != projectedSample.mSurfel.mTriangleIdx && projectedSample.mConfidence > EPSILON);
+		if (validate)
+		{
+			// compare with complete pattern
+			const ProjectedSample &reference = mValidationSamples[localPairIdx];
+			const bool referenceUsed = (Triangle::INVALID_IDX != reference.mSurfel.mTriangleIdx && reference.mConfidence > EPSILON);
+			const Real confidenceError = fabsr(projectedSample.mConfidence - reference.mConfidence);
+
+			++validatedPairCount;
+			if (used != referenceUsed)
+				++decisionMismatchCount;
+			confidenceErrorSum += confidenceError;
+
+			Real &maxConfidenceError = maxConfidenceErrors[omp_get_thread_num()];
+			if (confidenceError > maxConfidenceError)
+				maxConfidenceError = confidenceError;
+		}
+
+		// apply local refinement starting from hit surfel
+		if (used)
+			processProjectedSample(projectedSample, sampleIdx);
+	}
+
+	// gather pairs with disagreeing probes
+	mRefinedPairs.clear();
+	for (uint32 localPairIdx = 0; localPairIdx < pairCount; ++localPairIdx)
+		if (0 != mPairRefinementFlags[localPairIdx])
+			mRefinedPairs.push_back(mBatchPairs[localPairIdx]);
+	const uint32 refinedPairCount = (uint32) mRefinedPairs.size();
+
+	// update report
+	report.mPairCount += pairCount;
+	report.mRefinedPairCount += refinedPairCount;
+	report.mTracedRayCount += ((uint64) pairCount) * PROBE_RAY_COUNT + ((uint64) refinedPairCount) * patternSize;
+	report.mFixedPatternRayCount += ((uint64) pairCount) * patternSize;
+	report.mValidatedPairCount += validatedPairCount;
+	report.mDecisionMismatchCount += decisionMismatchCount;
+	report.mConfidenceErrorSum += confidenceErrorSum;
+
+	// maximum over all threads
+	const uint32 maxNumThreads = (uint32) maxConfidenceErrors.size();
+	for (uint32 threadIdx = 0; threadIdx < maxNumThreads; ++threadIdx)
+		if (maxConfidenceErrors[threadIdx] > report.mMaxConfidenceError)
+			report.mMaxConfidenceError = maxConfidenceErrors[threadIdx];
+
+	if (0 == refinedPairCount)
+		return;
+
+	// complete patterns for the pairs with disagreeing probes
+	mRayTracer.findIntersectionsForViewSamplePairs(true, 0, refinedPairCount,
+		EMBREE_RAY_BATCH_SIZE, mParams.mRaysPerViewSamplePair, mParams.mOrientSamplingPatternLikeView, mRefinedPairs.data());
+
+	cout << "Processing refined projected samples." << endl;
+	const int64 refinedCount = refinedPairCount;
+
+	#pragma omp parallel for schedule(dynamic, OMP_PAIR_BATCH_SIZE)
+	for (int64 i = 0; i < refinedCount; ++i)
+	{
+		const uint32 localPairIdx = (uint32) i;
+		const uint32 sampleIdx = samples.getSampleIdx(mRefinedPairs[localPairIdx]);
+		ProjectedSample projectedSample;
+
+		getProjectedSample(projectedSample, localPairIdx, sampleIdx);
+		if (Triangle::INVALID_IDX == projectedSample.mSurfel.mTriangleIdx || projectedSample.mConfidence <= EPSILON)
+			continue;
+
+		processProjectedSample(projectedSample, sampleIdx);
+	}
+}
+
+void FSSFRefiner::projectSamplesOntoClosestPoints(const uint32 *pairOrder, const uint32 pairCount)
+{
+	cout << "Processing samples projected onto closest surface points." << endl;
+	StageProfiler::Scope profilerScope("ClosestPointProjection", "pairs");
+	profilerScope.addItems(pairCount);
+
+	// get scene data
+	const Scene &scene = Scene::getSingleton();
+	const Samples &samples = scene.getSamples();
+	const vector<View *> &views = scene.getViews();
+	const int64 count = pairCount;
+
+	#pragma omp parallel for schedule(dynamic, OMP_PAIR_BATCH_SIZE)
+	for (int64 i = 0; i < count; ++i)
+	{
+		const uint32 orderIdx = (uint32) i;
+		const uint32 globalPairIdx = (pairOrder ? pairOrder[orderIdx] : orderIdx);
+		const uint32 viewIdx = samples.getViewIdx(globalPairIdx);
+		if (!scene.isValidView(viewIdx))
+			continue;
+
+		// closest surface point facing the view within the distance support of the sample
+		const uint32 sampleIdx = samples.getSampleIdx(globalPairIdx);
+		const Vector3 &samplePosWS = samples.getPositionWS(sampleIdx);
+		const Vector3 viewPosWS = views[viewIdx]->getPositionWS();
+		const Real maxDistance = mParams.mSupportSampleDistanceBandwidth * samples.getScale(sampleIdx);
+		ProjectedSample projectedSample;
+
+		if (!mTriangleBVH.findClosestPoint(projectedSample.mSurfel, samplePosWS, maxDistance, &viewPosWS))
+			continue;
+
+		// matching confidence like for a single ray
+		const Real projectionConfidence = getProjectionConfidence(projectedSample.mSurfel, sampleIdx);
+		projectedSample.mConfidence = projectionConfidence * samples.getConfidence(sampleIdx);
+		if (projectionConfidence <= EPSILON || projectedSample.mConfidence <= EPSILON)
+			continue;
+
+		projectedSample.mViewingDir = samplePosWS - viewPosWS;
+		projectedSample.mViewingDir.normalize();
+
+		// apply local refinement starting from closest surfel
+		processProjectedSample(projectedSample, sampleIdx);
+	}
+}
+
+Real FSSFRefiner::getPairSubsetFraction() const
+{
+	if (!mParams.mStochasticPairSubsets || mAllPairsRequired)
+		return 1.0f;
+	if (mMeanRelativeMovement <= mParams.mPairSubsetFullMovement)
+		return 1.0f;
+
+	// grow with decreasing vertex movement
+	const Real fraction = mParams.mPairSubsetFullMovement / mMeanRelativeMovement;
+	return clamp<Real>(fraction, 1.0f, mParams.mPairSubsetMinFraction);
+}
+
+void FSSFRefiner::selectPairSubset(const uint32 *pairOrder, const uint32 pairCount, const Real fraction)
+{
+	cout << "Selecting stratified random subset of view sample pairs. Fraction: " << fraction << endl;
+
+	// get scene data
+	const Samples &samples = Scene::getSingleton().getSamples();
+	const Tree *tree = Scene::getTree();
+	const uint32 sampleCount = samples.getCount();
+	const uint32 viewsPerSample = samples.getViewsPerSample();
+	RandomManager &randomManager = RandomManager::getSingleton();
+
+	// strata: disjoint & spatially compact sample sets of the tree nodes or all (tree ordered) samples without tree
+	vector<uint8> keptPairs(samples.getMaxViewConeCount(), 0);
+	const uint32 strataCount = (tree ? tree->getNodes().getCount() : 1);
+
+	for (uint32 stratumIdx = 0; stratumIdx < strataCount; ++stratumIdx)
+	{
+		uint32 stratumSampleCount = sampleCount;
+		uint32 startSampleIdx = 0;
+		if (tree)
+			startSampleIdx = tree->getNodes().getSamples(stratumSampleCount, stratumIdx);
+		if (0 == stratumSampleCount)
+			continue;
+
+		// systematic sampling with random start: kept pairs are evenly spread over the pairs of the stratum
+		const uint32 startPairIdx = startSampleIdx * viewsPerSample;
+		const uint32 stratumPairCount = stratumSampleCount * viewsPerSample;
+		const double start = randomManager.getUniform(0.0f, 1.0f);
+
+		for (uint32 localPairIdx = 0; localPairIdx < stratumPairCount; ++localPairIdx)
+		{
+			const uint64 before = (uint64) (start + localPairIdx * (double) fraction);
+			const uint64 after = (uint64) (start + (localPairIdx + 1) * (double) fraction);
+			if (after > before)
+				keptPairs[startPairIdx + localPairIdx] = 1;
+		}
+	}
+
+	// kept pairs in the entered order
+	mPairSubset.clear();
+	for (uint32 orderIdx = 0; orderIdx < pairCount; ++orderIdx)
+	{
+		const uint32 pairIdx = (pairOrder ? pairOrder[orderIdx] : orderIdx);
+		if (0 != keptPairs[pairIdx])
+			mPairSubset.push_back(pairIdx);
+	}
+
+	cout << "Kept view sample pairs: " << mPairSubset.size() << " of " << pairCount << endl;
+}
+
+void FSSFRefiner::updateViewSamplePairOrder()
+{
+	// still valid?
+	if (!mViewSamplePairOrder.empty())
+		return;
+
+	cout << "Sorting view sample pairs by view." << endl;
+
+	// get scene data
+	const Scene &scene = Scene::getSingleton();
+	const Samples &samples = scene.getSamples();
+	const uint32 viewCount = (uint32) scene.getViews().size();
+	const uint32 pairCount = samples.getMaxViewConeCount();
+
+	// count the pairs of each view
+	vector<uint32> viewStarts(viewCount + 1, 0);
+	for (uint32 pairIdx = 0; pairIdx < pairCount; ++pairIdx)
+	{
+		const uint32 viewIdx = samples.getViewIdx(pairIdx);
+		if (scene.isValidView(viewIdx))
+			++viewStarts[viewIdx + 1];
+	}
+
+	for (uint32 viewIdx = 0; viewIdx < viewCount; ++viewIdx)
+		viewStarts[viewIdx + 1] += viewStarts[viewIdx];
+
+	// stable counting sort: pairs of the same view keep their (spatially coherent) sample order
+	mViewSamplePairOrder.resize(viewStarts[viewCount]);
+	for (uint32 pairIdx = 0; pairIdx < pairCount; ++pairIdx)
+	{
+		const uint32 viewIdx = samples.getViewIdx(pairIdx);
+		if (scene.isValidView(viewIdx))
+			mViewSamplePairOrder[viewStarts[viewIdx]++] = pairIdx;
+	}
 }
 
 void FSSFRefiner::getProjectedSample(ProjectedSample &projectedSample,
@@ -238,6 +683,66 @@ void FSSFRefiner::getProjectedSample(ProjectedSample &projectedSample,
 		projectedSample.mConfidence = medianValue * samples.getConfidence(sampleIdx);
 }
 
+bool FSSFRefiner::getProbedProjectedSample(ProjectedSample &projectedSample,
+	const uint32 localPairIdx, const uint32 sampleIdx) const
+{
+	const Samples &samples = Scene::getSingleton().getSamples();
+	const uint32 startRayIdx = localPairIdx * PROBE_RAY_COUNT;
+	vector<Real> &localConfidences = mLocalConfidences[omp_get_thread_num()];
+
+	projectedSample.mSurfel.mTriangleIdx = Triangle::INVALID_IDX;
+	projectedSample.mConfidence = 0.0f;
+
+	// center probe = center ray of complete pattern: a missed or low confidence center means the same for both
+	if (!mRayTracer.getHitValidity(startRayIdx))
+		return true;
+
+	Surfel centerSurfelWS;
+	mRayTracer.getSurfel(centerSurfelWS, startRayIdx);
+	localConfidences[0] = getProjectionConfidence(centerSurfelWS, sampleIdx);
+	if (localConfidences[0] <= EPSILON)
+		return true;
+
+	// do the other probes agree with the center?
+	const Real maxDepthDifference = mParams.mAdaptiveSamplingMaxRelativeDepthDifference * samples.getScale(sampleIdx);
+	const Real minCosAngle = cosr(mParams.mAdaptiveSamplingMaxAngleDifference);
+
+	for (uint32 probeIdx = 1; probeIdx < PROBE_RAY_COUNT; ++probeIdx)
+	{
+		const uint32 rayIdx = startRayIdx + probeIdx;
+		if (!mRayTracer.getHitValidity(rayIdx))
+			return false;
+
+		Surfel surfelWS;
+		mRayTracer.getSurfel(surfelWS, rayIdx);
+
+		// hits on other triangles must be close to the center tangent plane & similarly oriented
+		if (surfelWS.mTriangleIdx != centerSurfelWS.mTriangleIdx)
+		{
+			const Real depthDifference = fabsr((surfelWS.mPosition - centerSurfelWS.mPosition).dotProduct(centerSurfelWS.mNormal));
+			if (depthDifference > maxDepthDifference)
+				return false;
+			if (surfelWS.mNormal.dotProduct(centerSurfelWS.mNormal) < minCosAngle)
+				return false;
+		}
+
+		localConfidences[probeIdx] = getProjectionConfidence(surfelWS, sampleIdx);
+	}
+
+	// median of probe confidences
+	vector<Real>::iterator middle = localConfidences.begin() + (PROBE_RAY_COUNT / 2);
+	std::nth_element(localConfidences.begin(), middle, localConfidences.begin() + PROBE_RAY_COUNT);
+
+	// goodish projected sample
+	projectedSample.mSurfel = centerSurfelWS;
+	projectedSample.mViewingDir = mRayTracer.getRayDirection(startRayIdx);
+
+	const Real medianValue = *middle;
+	if (medianValue > EPSILON)
+		projectedSample.mConfidence = medianValue * samples.getConfidence(sampleIdx);
+	return true;
+}
+
 Real FSSFRefiner::getProjectionConfidence(const Surfel &surfelWS, const uint32 sampleIdx) const
 {
 	const Samples &samples = Scene::getSingleton().getSamples();
@@ -277,8 +782,9 @@ void FSSFRefiner::processProjectedSample(const ProjectedSample &projectedSample,
 	
 	// find vertices & edges within the support range of the projected sample
 	MeshDijkstra &dijkstra = mDijkstras[omp_get_thread_num()];
-	dijkstra.findVertices(&mMesh, mTriangleNormals.data(), mVertexNeighbors.data(), mVertexNeighborsOffsets.data(),
-		surfelWS, hitTriangle, surfaceSupportRange, mDijkstraParams);
+	if (!isUsingDijkstraCache() || !mDijkstraCache.findVertices(dijkstra, surfelWS, surfaceSupportRange, mDijkstraParams))
+		dijkstra.findVertices(&mMesh, mTriangleNormals.data(), mVertexNeighbors.data(), mVertexNeighborsOffsets.data(),
+			surfelWS, hitTriangle, surfaceSupportRange, mDijkstraParams, getDijkstraSteps());
 	
 	// compute weights for surface posisionts
 	//vector<Real> &edgeWeights = mLocalEdgeWeights[threadIdx];
@@ -352,6 +858,9 @@ void FSSFRefiner::addFloatingScaleQuantities(const MeshDijkstra &dijkstra, //con
 	const Vector3 &samplePosWS = samples.getPositionWS(sampleIdx);
 	const Real sampleScale = samples.getScale(sampleIdx);
 
+	// each pair of a subset represents 1 / fraction pairs
+	const Real subsetWeightFactor = 1.0f / mPairSubsetFraction;
+
 	// dijkstra data
 	const vector<RangedVertexIdx> &rangedVertices = dijkstra.getVertices();
 	const vector<uint32> &order = dijkstra.getOrder();
@@ -364,12 +873,13 @@ void FSSFRefiner::addFloatingScaleQuantities(const MeshDijkstra &dijkstra, //con
 		const uint32 nextBestIdx = order[localVertexIdx];
 		const RangedVertexIdx &rangedVertex = rangedVertices[nextBestIdx];
 		const uint32 vertexIdx = rangedVertex.getGlobalVertexIdx();
-		const Real weight = rangedVertex.getCosts() * projectedSample.mConfidence;
+		const Real weight = rangedVertex.getCosts() * projectedSample.mConfidence * subsetWeightFactor;
+		FixedPointSum *fixedTargets = (mFixedVertexSums.empty() ? NULL : mFixedVertexSums.data() + FIXED_SUM_COUNT * vertexIdx);
 
 		// add influence of ray to sample on vertex
 		addFloatingScaleQuantities(&mMesh.getColor(vertexIdx), mVectorField[vertexIdx],	mSurfaceErrors[vertexIdx], mWeightField[vertexIdx],
 			correctionDir, meshPositions[vertexIdx],
-			&sampleColor, sampleNormalWS, samplePosWS, weight);
+			&sampleColor, sampleNormalWS, samplePosWS, weight, fixedTargets);
 
 		//// also compute errors at edges?
 		//if (!mFineEstimation)
@@ -398,7 +908,7 @@ void FSSFRefiner::addFloatingScaleQuantities(Vector3 *targetColor, Vector3 &targ
 	Real &targetSumOfSurfaceErrors, Real &targetSumOfWeights,
 	const Vector3 &correctionDirWS, const Vector3 &surfacePosWS,
 	const Vector3 *sampleColor, const Vector3 &sampleNormalWS, const Vector3 &samplePosWS,
-	const Real weight)
+	const Real weight, FixedPointSum *fixedTargets)
 {
 	// compute final hit weight (= influence strength)
 	if (weight <= EPSILON)
@@ -411,13 +921,30 @@ void FSSFRefiner::addFloatingScaleQuantities(Vector3 *targetColor, Vector3 &targ
 		correctionDirWS, surfacePosWS, sampleNormalWS, samplePosWS);
 	if (!reasonable)
 		return;
+
+	// surface error
+	//const Real lengthSq = correction.getLengthSquared();
+	//const Real loss = logr(1.0f + lengthSq);
+	//const Real loss = correction.getLength();
+	const Real loss = logr(1.0f + correction.getLength());
+	const Vector3 weightedCorrection = correction * weight;
+
+	// deterministic mode: order independent sums instead of floating point atomics
+	if (fixedTargets)
+	{
+		fixedTargets[FIXED_SUM_WEIGHT].add(weight);
+		FixedPointSum::add(fixedTargets + FIXED_SUM_CORRECTION, weightedCorrection);
+		fixedTargets[FIXED_SUM_SURFACE_ERROR].add(loss * weight);
+		if (targetColor && sampleColor)
+			FixedPointSum::add(fixedTargets + FIXED_SUM_COLOR, *sampleColor * weight);
+		return;
+	}
 	
 	// update global vertex weight
 	#pragma omp atomic
 	targetSumOfWeights += weight;
 
 	// update global vertex movement
-	const Vector3 weightedCorrection = correction * weight;
 	#pragma omp atomic
 	targetSumOfCorrections.x += weightedCorrection.x;
 	#pragma omp atomic
@@ -426,10 +953,6 @@ void FSSFRefiner::addFloatingScaleQuantities(Vector3 *targetColor, Vector3 &targ
 	targetSumOfCorrections.z += weightedCorrection.z;		
 
 	// update surface error
-	//const Real lengthSq = correction.getLengthSquared();
-	//const Real loss = logr(1.0f + lengthSq);
-	//const Real loss = correction.getLength();
-	const Real loss = logr(1.0f + correction.getLength());
 	#pragma omp atomic
 	targetSumOfSurfaceErrors += loss * weight;
 
@@ -479,6 +1002,11 @@ void FSSFRefiner::zeroFloatingScaleQuantities()
 	#pragma omp parallel for
 	for (int64 vertexIdx = 0; vertexIdx < vertexCount; ++vertexIdx)
 		mSurfaceErrors[vertexIdx] = 0.0f;
+
+	// deterministic mode: zero order independent sums which replace the floating point atomics
+	mFixedVertexSums.clear();
+	if (FixedPointSum::isDeterministicModeEnabled())
+		mFixedVertexSums.resize(FIXED_SUM_COUNT * vertexCount);
 	
 	//if (!mFineEstimation)
 	//	return;
@@ -502,6 +1030,27 @@ void FSSFRefiner::zeroFloatingScaleQuantities()
 	//	mEdgeWeights[edgeIdx] = 0.0f;
 }
 
+void FSSFRefiner::applyFixedVertexSums()
+{
+	// vertex data
+	const int64 vertexCount = mMesh.getVertexCount();
+	Vector3 *colors = mMesh.getColors();
+
+	#pragma omp parallel for
+	for (int64 i = 0; i < vertexCount; ++i)
+	{
+		const uint32 vertexIdx = (uint32) i;
+		const FixedPointSum *sums = mFixedVertexSums.data() + FIXED_SUM_COUNT * vertexIdx;
+
+		colors[vertexIdx] = FixedPointSum::getVector(sums + FIXED_SUM_COLOR);
+		mVectorField[vertexIdx] = FixedPointSum::getVector(sums + FIXED_SUM_CORRECTION);
+		mSurfaceErrors[vertexIdx] = sums[FIXED_SUM_SURFACE_ERROR].getValue();
+		mWeightField[vertexIdx] = sums[FIXED_SUM_WEIGHT].getValue();
+	}
+
+	mFixedVertexSums.clear();
+}
+
 void FSSFRefiner::normalize()
 {
 	cout << "Normalizing weighted sums." << endl;
@@ -538,14 +1087,17 @@ void FSSFRefiner::markUnreliableVerticesViaSupport()
 	// get mesh data
 	const uint32 vertexCount = mMesh.getVertexCount();
 
+	// weights of a pair subset are only estimates -> keep the reliability of the last iteration with all pairs
+	if (isUsingPairSubset())
+		return;
+
 	// unreliable if no surface support
 	#pragma omp parallel for
 	for (int64 i = 0; i < vertexCount; ++i)
 	{
 		// unreliable if unsupported
 		const uint32 vertexIdx = (uint32) i;
-		const Real weight = mWeightField[vertexIdx];
-		if (weight < mParams.mSupportWeakThreshold || isNaN(weight))
+		if (isWeaklySupported(vertexIdx))
 		{
 			mVertexStates[vertexIdx] |= UNSUPPORTED;
 			continue;
@@ -558,38 +1110,179 @@ void FSSFRefiner::markUnreliableVerticesViaSupport()
 void FSSFRefiner::moveVertices()
 {	
 	const uint32 vertexCount = mMesh.getVertexCount();
+	double movementSum = 0.0;
+	int64 movedVertexCount = 0;
 
-	#pragma omp parallel for
+	#pragma omp parallel for reduction(+ : movementSum, movedVertexCount)
 	for (int64 i = 0; i < vertexCount; ++i)
 	{
 		// get & check vertex
+		// (weakly supported ones are only UNSUPPORTED if all pairs were processed but they are never moved, see updateVertices)
 		const uint32 vertexIdx = (uint32) i;
-		if (isBad(vertexIdx))
+		if (isBad(vertexIdx) || isWeaklySupported(vertexIdx))
 			continue;
 
-		// position is worse than oldPosition? -> move back
-		Real &newError = mSurfaceErrors[vertexIdx];
-		Real &lowestError = mBestSurfaceErrors[vertexIdx];
-		if (fabsr(newError) >= mParams.mSurfaceErrorRelativeThreshold * fabsr(lowestError))
-		{
-			newError = lowestError;
-			mMesh.setPosition(mBestPositions[vertexIdx], vertexIdx);
+		// move it & sum up its movement
+		Real relativeMovement;
+		if (!moveVertex(relativeMovement, vertexIdx))
 			continue;
-		}
+		movementSum += relativeMovement;
+		++movedVertexCount;
+	}
+
+	setMeanRelativeMovement(movementSum, movedVertexCount);
+}
+
+bool FSSFRefiner::moveVertex(Real &relativeMovement, const uint32 vertexIdx)
+{
+	// position is worse than oldPosition? -> move back
+	Real &newError = mSurfaceErrors[vertexIdx];
+	Real &lowestError = mBestSurfaceErrors[vertexIdx];
+	if (fabsr(newError) >= mParams.mSurfaceErrorRelativeThreshold * fabsr(lowestError))
+	{
+		newError = lowestError;
+		mMesh.setPosition(mBestPositions[vertexIdx], vertexIdx);
+		return false;
+	}
+
+	// position & its error is okayish -> continue moving
+	Vector3 &position = mMesh.getPosition(vertexIdx);
+
+	// new best position with lowest error? (not for estimated errors of a pair subset)
+	if (newError < lowestError && !isUsingPairSubset())
+	{
+		lowestError = newError;
+		mBestPositions[vertexIdx] = position;
+	}
+
+	// move towards a better reconstruction! (hopefully)
+	const Vector3 &movement = mVectorField[vertexIdx];
+	position += movement;
 
-		// position & its error is okayish -> continue moving
-		Vector3 &position = mMesh.getPosition(vertexIdx);
+	// movement relative to resolution
+	const Real scale = mMesh.getScale(vertexIdx);
+	if (scale <= EPSILON)
+		return false;
+	relativeMovement = movement.getLength() / scale;
+	return true;
+}
+
+void FSSFRefiner::setMeanRelativeMovement(const double movementSum, const int64 movedVertexCount)
+{
+	// for switching to closest point projection
+	mMeanRelativeMovement = (movedVertexCount > 0 ? (Real) (movementSum / movedVertexCount) : 0.0f);
+	cout << "Mean relative vertex movement: " << mMeanRelativeMovement << endl;
+}
+
+void FSSFRefiner::updateVertices()
+{
+	cout << "Normalizing weighted sums, finding unreliable vertices & moving vertices." << endl;
+
+	const Vector3 WEAK_SUPPORT_COLOR(0.757255f, 0.150784f, 0.520784f);
+	const Vector3 ZERO(0.0f, 0.0f, 0.0f);
 
-		// new best position with lowest error?
-		if (newError < lowestError)
+	const uint32 vertexCount = mMesh.getVertexCount();
+	const bool updateReliability = !isUsingPairSubset();
+	Vector3 *colors = mMesh.getColors();
+	double movementSum = 0.0;
+	int64 movedVertexCount = 0;
+
+	#pragma omp parallel for reduction(+ : movementSum, movedVertexCount)
+	for (int64 i = 0; i < vertexCount; ++i)
+	{
+		const uint32 vertexIdx = (uint32) i;
+		const Real weight = mWeightField[vertexIdx];
+
+		// unsupported: invalid weighted means & unreliable (see normalize & markUnreliableVerticesViaSupport), not moved (see moveVertices)
+		if (isWeaklySupported(vertexIdx))
 		{
-			lowestError = newError;
-			mBestPositions[vertexIdx] = position;
+			colors[vertexIdx] = WEAK_SUPPORT_COLOR;
+			mVectorField[vertexIdx] = ZERO;
+			mSurfaceErrors[vertexIdx] = REAL_MAX;
+			if (updateReliability)
+				mVertexStates[vertexIdx] |= UNSUPPORTED;
+			continue;
 		}
 
-		// move towards a better reconstruction! (hopefully)
-		position += mVectorField[vertexIdx];
+		// supported: weighted means
+		colors[vertexIdx] /= weight;
+		mVectorField[vertexIdx] /= weight;
+		mSurfaceErrors[vertexIdx] /= weight;
+		if (updateReliability)
+			mVertexStates[vertexIdx] &= ~UNSUPPORTED;
+
+		// outliers are not moved (see moveVertices)
+		if (isBad(vertexIdx))
+			continue;
+
+		// move it & sum up its movement
+		Real relativeMovement;
+		if (!moveVertex(relativeMovement, vertexIdx))
+			continue;
+		movementSum += relativeMovement;
+		++movedVertexCount;
 	}
+
+	setMeanRelativeMovement(movementSum, movedVertexCount);
+}
+
+void FSSFRefiner::validateFusedVertexUpdate()
+{
+	cout << "Validating the fused vertex update against the separate passes." << endl;
+
+	const uint32 vertexCount = mMesh.getVertexCount();
+	Vector3 *colors = mMesh.getColors();
+	Vector3 *positions = mMesh.getPositions();
+
+	// inputs of both variants: weighted sums & vertex data
+	const vector<Vector3> inputColors(colors, colors + vertexCount);
+	const vector<Vector3> inputPositions(positions, positions + vertexCount);
+	const vector<Vector3> inputVectorField(mVectorField);
+	const vector<Real> inputSurfaceErrors(mSurfaceErrors);
+	const vector<uint8> inputVertexStates(mVertexStates);
+	const vector<Vector3> inputBestPositions(mBestPositions);
+	const vector<Real> inputBestSurfaceErrors(mBestSurfaceErrors);
+
+	// separate passes
+	normalize();
+	markUnreliableVerticesViaSupport();
+	moveVertices();
+
+	const vector<Vector3> separatePositions(positions, positions + vertexCount);
+	const vector<Real> separateSurfaceErrors(mSurfaceErrors);
+	const vector<uint8> separateVertexStates(mVertexStates);
+	const vector<Vector3> separateBestPositions(mBestPositions);
+	const vector<Real> separateBestSurfaceErrors(mBestSurfaceErrors);
+
+	// fused variant on the same inputs (its results are kept)
+	memcpy(colors, inputColors.data(), sizeof(Vector3) * vertexCount);
+	memcpy(positions, inputPositions.data(), sizeof(Vector3) * vertexCount);
+	mVectorField = inputVectorField;
+	mSurfaceErrors = inputSurfaceErrors;
+	mVertexStates = inputVertexStates;
+	mBestPositions = inputBestPositions;
+	mBestSurfaceErrors = inputBestSurfaceErrors;
+	updateVertices();
+
+	// bitwise comparison of the results
+	int64 mismatchCount = 0;
+
+	#pragma omp parallel for reduction(+ : mismatchCount)
+	for (int64 i = 0; i < vertexCount; ++i)
+	{
+		const uint32 vertexIdx = (uint32) i;
+		if (0 == memcmp(positions + vertexIdx, separatePositions.data() + vertexIdx, sizeof(Vector3)) &&
+			0 == memcmp(&mSurfaceErrors[vertexIdx], &separateSurfaceErrors[vertexIdx], sizeof(Real)) &&
+			mVertexStates[vertexIdx] == separateVertexStates[vertexIdx] &&
+			0 == memcmp(&mBestPositions[vertexIdx], &separateBestPositions[vertexIdx], sizeof(Vector3)) &&
+			0 == memcmp(&mBestSurfaceErrors[vertexIdx], &separateBestSurfaceErrors[vertexIdx], sizeof(Real)))
+			continue;
+
+		++mismatchCount;
+	}
+
+	mFusedVertexUpdateMismatchCount += mismatchCount;
+	cout << "Vertices with different results of fused and separate vertex update: " << mismatchCount << " of " << vertexCount << endl;
 }
 
 void FSSFRefiner::enforceRegularGeometry(const uint32 iteration)
@@ -615,8 +1308,9 @@ void FSSFRefiner::enforceRegularGeometry(const uint32 iteration)
 			break;
 	}
 
-	// deletion of unsupported small parts
-	enforceRegularGeometryForOutliers(iteration);
+	// deletion of unsupported small parts (only with reliability from all pairs)
+	if (!isUsingPairSubset())
+		enforceRegularGeometryForOutliers(iteration);
 	
 	mMesh.umbrellaSmooth(mVectorField.data(), mWeightField.data(), mParams.mUmbrellaSmoothingLambdaLow);
 	updateObservers(iteration, "FSSFMoreRegular", IReconstructorObserver::RECONSTRUCTION_VIA_SAMPLES);
@@ -1085,7 +1779,9 @@ void FSSFRefiner::simplifyMesh(const uint32 iteration)
 	mEdgeMergeCandidates.clear();
 	mLeftEdgeMergeCandidates.clear();
 	mLeftTriangleMergeCandidates.clear();
+	mMergedVertices.clear();
 	
+	// first round: all triangles, later rounds: only triangles of left candidates (& around merged vertices for one-ring rechecks)
 	while (true)
 	{
 		const uint32 oldVertexCount = mMesh.getVertexCount();
@@ -1095,12 +1791,18 @@ void FSSFRefiner::simplifyMesh(const uint32 iteration)
 		if (mEdgeMergeCandidates.empty())
 			break;
 
-		// merge them
+		// merge them (& remember the changed one-rings via onEdgeMerging)
+		mMergedVertices.clear();
 		mMesh.mergeEdges(mLeftEdgeMergeCandidates, mEdgeMergeCandidates);
-		if (mLeftEdgeMergeCandidates.empty() || mMesh.getVertexCount() == oldVertexCount) // wasn't possible to merge the edges?
+		if (mMesh.getVertexCount() == oldVertexCount) // wasn't possible to merge the edges?
+			break;
+		if (mLeftEdgeMergeCandidates.empty() && !mParams.mEdgeMergeOneRingRechecks)
 			break;
 	}
 
+	mLeftEdgeMergeCandidates.clear();
+	mMergedVertices.clear();
+
 	//updateObservers(iteration, "FSSFSimplified", IReconstructorObserver::RECONSTRUCTION_VIA_SAMPLES);
 	mFirstHoleFillingTriangle = mMesh.getTriangleCount();
 }
@@ -1112,6 +1814,10 @@ void FSSFRefiner::findMergingEdges()
 	uint32 triangleCount;
 	uint32 *restrictedTriangleSet = getEdgeMergeTriangleSearchSet(triangleCount);
 
+	// all triangles? -> intersected tree nodes for all triangles at once
+	if (!restrictedTriangleSet)
+		computeMinIntersectionTreeNodeLengths();
+
 	// for each triangle: find intersecting nodes & mark the triangle if it's too large w.r.t. its intersection tree nodes
 	mEdgeMergeCandidates.clear();
 
@@ -1130,7 +1836,7 @@ void FSSFRefiner::findMergingEdges()
 		};
 
 		// find minimum node length { triangle intersection nodes }, find shortest and longest triangle side
-		const Real minNodeLength = getMinIntersectionTreeNodeLength(corners);
+		const Real minNodeLength = (restrictedTriangleSet ? getMinIntersectionTreeNodeLength(corners) : mMinTriangleNodeLengths[triangleIdx]);
 		Real minTriLength2 = sideLengths2[0];
 		Real maxTriLength2 = sideLengths2[0];
 		uint32 shortestSide = 0;
@@ -1172,14 +1878,17 @@ void FSSFRefiner::findMergingEdges()
 			mEdgeMergeCandidates.push_back(edgeIdx);
 	}
 
+	mMinTriangleNodeLengths.clear();
 	Utilities::removeDuplicates(mEdgeMergeCandidates);
 }
 
 uint32 *FSSFRefiner::getEdgeMergeTriangleSearchSet(uint32 &triangleCount)
 {
 	// search within complete triangle set?
+	// (only for the first merge round as each later round has left candidates or, for one-ring rechecks, merged vertices)
 	const uint32 leftEdgeCandidateCount = (uint32) mLeftEdgeMergeCandidates.size();
-	if (leftEdgeCandidateCount == 0)
+	const uint32 mergedVertexCount = (uint32) mMergedVertices.size();
+	if (leftEdgeCandidateCount == 0 && mergedVertexCount == 0)
 	{
 		triangleCount = mMesh.getTriangleCount();
 		return NULL;
@@ -1198,8 +1907,26 @@ uint32 *FSSFRefiner::getEdgeMergeTriangleSearchSet(uint32 &triangleCount)
 		mLeftTriangleMergeCandidates[2 * edgeIdx + 0] = triangles[0];
 		mLeftTriangleMergeCandidates[2 * edgeIdx + 1] = triangles[1];
 	}
+
+	// triangles around merged vertices changed their shapes
+	const Edge *edges = mMesh.getEdges();
+	const vector<uint32> *verticesToEdges = mMesh.getVerticesToEdges();
+	for (uint32 localVertexIdx = 0; localVertexIdx < mergedVertexCount; ++localVertexIdx)
+	{
+		const vector<uint32> &vertexEdges = verticesToEdges[mMergedVertices[localVertexIdx]];
+		const uint32 vertexEdgeCount = (uint32) vertexEdges.size();
+
+		for (uint32 localEdgeIdx = 0; localEdgeIdx < vertexEdgeCount; ++localEdgeIdx)
+		{
+			const uint32 *triangles = edges[vertexEdges[localEdgeIdx]].getTriangleIndices();
+			for (uint32 sideIdx = 0; sideIdx < 2; ++sideIdx)
+				if (Triangle::INVALID_IDX != triangles[sideIdx])
+					mLeftTriangleMergeCandidates.push_back(triangles[sideIdx]);
+		}
+	}
 		
 	mLeftEdgeMergeCandidates.clear();
+	mMergedVertices.clear();
 	Utilities::removeDuplicates(mLeftTriangleMergeCandidates);
 	triangleCount = (uint32) mLeftTriangleMergeCandidates.size();
 	return mLeftTriangleMergeCandidates.data();
@@ -1305,6 +2032,7 @@ void FSSFRefiner::findSubdivisionEdgesViaNodes()
 	// get tree & mesh data
 	const uint32 triangleCount = mMesh.getTriangleCount();
 	const Vector3 *positions = mMesh.getPositions();
+	computeMinIntersectionTreeNodeLengths();
 
 	// for each triangle: find intersecting nodes & mark the triangle if it's too large w.r.t. its intersection tree nodes
 	#pragma omp parallel for
@@ -1336,7 +2064,7 @@ void FSSFRefiner::findSubdivisionEdgesViaNodes()
 		}
 		
 		// minimum node length { triangle intersection nodes }
-		const Real minNodeLength = getMinIntersectionTreeNodeLength(corners);
+		const Real minNodeLength = mMinTriangleNodeLengths[triangleIdx];
 
 		// longest triangle side > smallest side length of triangle intersection nodes?
 		if (maxTriLength2 <= minNodeLength * minNodeLength)
@@ -1346,6 +2074,8 @@ void FSSFRefiner::findSubdivisionEdgesViaNodes()
 		#pragma omp critical (OMPPushBackSubdivisionEdge)
 			mSubdivisionEdges.push_back(edgeIdx);
 	}
+
+	mMinTriangleNodeLengths.clear();
 }
 
 bool FSSFRefiner::isNotForSubdivision(const uint32 *triangle, const uint32 triangleIdx) const
@@ -1382,6 +2112,15 @@ Real FSSFRefiner::getMinIntersectionTreeNodeLength(const Vector3 triangle[3]) co
 	return minNodeLength;
 }
 
+void FSSFRefiner::computeMinIntersectionTreeNodeLengths()
+{
+	// the hierarchy is only needed for the simultaneous traversal
+	const Tree &tree = *Scene::getSingleton().getTree();
+	mTriangleBVH.build(mMesh.getPositions(), mMesh.getIndices(), mMesh.getTriangleCount());
+	mTriangleBVH.findMinIntersectedLeafSizes(mMinTriangleNodeLengths, tree);
+	mTriangleBVH.clear();
+}
+
 //void FSSFRefiner::findSubdivisionEdgesViaErrors()
 //{
 //
@@ -1449,15 +2188,9 @@ bool FSSFRefiner::smoothUntilConvergence(const uint8 requiredFlags)
 	// find islands of vertices with requiredFlags & get counts
 	IslesEraser isleManager(mMesh, mVertexStates.data(), requiredFlags);
 	const atomic<uint32> *verticesToIsles = isleManager.getVerticesToIsles();
-	const map<uint32, uint32> &sizes = isleManager.getIsleSizes();
+	const vector<uint32> &isleIDs = isleManager.getIsleIDs();
+	const vector<uint32> &sizes = isleManager.getIsleSizes();
 	const uint32 threadCount = omp_get_max_threads();
-
-	// gather isle IDs
-	vector<uint32> isleIDs;
-	isleIDs.reserve(sizes.size());
-	for (map<uint32, uint32>::const_iterator it = sizes.begin(); it != sizes.end(); ++it)
-		if (IslesEraser::INVALID_TRIANGLE_ISLAND != it->first)
-			isleIDs.push_back(it->first);
 	
 	// smooth each isle
 	vector<uint32> *isles = new vector<uint32>[threadCount];
@@ -1471,7 +2204,7 @@ bool FSSFRefiner::smoothUntilConvergence(const uint8 requiredFlags)
 		// create isle
 		vector<uint32> &isle = isles[omp_get_thread_num()];
 		const uint32 isleID = isleIDs[isleIdx];
-		const uint32 size = sizes.find(isleID)->second;
+		const uint32 size = sizes[isleID];
 
 		isle.clear();
 		isle.reserve(size);
@@ -1558,12 +2291,25 @@ void FSSFRefiner::onFilterData(
 	const uint32 *triangleOffsets, const uint32 triangleOffsetCount)
 {
 	MeshRefiner::onFilterData(vertexOffsets, vertexOffsetCount, edgeOffsets, edgeOffsetCount, triangleOffsets, triangleOffsetCount);
+	mTopologyChurn += vertexOffsets[vertexOffsetCount];
 	
 	FlexibleMesh::filterData<Vector3>(mBestPositions, vertexOffsets);
 	FlexibleMesh::filterData<Real>(mBestSurfaceErrors, vertexOffsets);
 	FlexibleMesh::filterData<Real>(mSurfaceErrors, vertexOffsets);
 	FlexibleMesh::filterData<uint8>(mVertexStates, vertexOffsets);
 
+	// new indices of merged vertices which were not removed by later merges
+	const uint32 oldMergedVertexCount = (uint32) mMergedVertices.size();
+	uint32 mergedVertexCount = 0;
+	for (uint32 localVertexIdx = 0; localVertexIdx < oldMergedVertexCount; ++localVertexIdx)
+	{
+		const uint32 oldVertexIdx = mMergedVertices[localVertexIdx];
+		if (vertexOffsets[oldVertexIdx] != vertexOffsets[oldVertexIdx + 1])
+			continue;
+		mMergedVertices[mergedVertexCount++] = oldVertexIdx - vertexOffsets[oldVertexIdx];
+	}
+	mMergedVertices.resize(mergedVertexCount);
+
 	//FlexibleMesh::filterData<Vector3>(mEdgeVectorField, edgeOffsets);
 	//FlexibleMesh::filterData<Real>(mEdgeScales, edgeOffsets);
 	//FlexibleMesh::filterData<Real>(mEdgeWeights, edgeOffsets);
@@ -1577,6 +2323,10 @@ void FSSFRefiner::onEdgeMerging(const uint32 targetVertex, const uint32 edgeVert
 	// update vertexData
 	createNewVertex(targetVertex, edgeVertex0, edgeVertex1, 0.5f);
 
+	// its one-ring must be checked again by simplifyMesh?
+	if (mParams.mEdgeMergeOneRingRechecks)
+		mMergedVertices.push_back(targetVertex);
+
 	//// update edge data
 	//for (uint32 i = 0; i < 2; ++i)
 	//{
@@ -1620,6 +2370,7 @@ void FSSFRefiner::onNewElements(
 {
 	MeshRefiner::onNewElements(firstNewVertex, newVertexCount, firstNewEdge, newEdgeCount, firstNewTriangle, newTriangleCount);
 	resize(newVertexCount, newEdgeCount, newTriangleCount);
+	mTopologyChurn += newVertexCount - firstNewVertex;
 }
 
 void FSSFRefiner::onNewStartMesh()
@@ -1641,6 +2392,22 @@ void FSSFRefiner::onNewStartMesh()
 	#pragma omp parallel for
 	for (int64 i = 0; i < vertexCount; ++i)
 		mBestPositions[i] = positions[i];
+
+	// the start mesh order is arbitrary
+	mTopologyChurn = vertexCount;
+}
+
+void FSSFRefiner::onReorderData(
+	const uint32 *vertexOrder, const uint32 vertexCount,
+	const uint32 *edgeOrder, const uint32 edgeCount,
+	const uint32 *triangleOrder, const uint32 triangleCount)
+{
+	MeshRefiner::onReorderData(vertexOrder, vertexCount, edgeOrder, edgeCount, triangleOrder, triangleCount);
+
+	FlexibleMesh::reorderData<Vector3>(mBestPositions, vertexOrder);
+	FlexibleMesh::reorderData<Real>(mBestSurfaceErrors, vertexOrder);
+	FlexibleMesh::reorderData<Real>(mSurfaceErrors, vertexOrder);
+	FlexibleMesh::reorderData<uint8>(mVertexStates, vertexOrder);
 }
 
 void FSSFRefiner::reserve(const uint32 vertexCapacity, const uint32 edgeCapacity, const uint32 triangleCapacity)
@@ -1691,6 +2458,7 @@ void FSSFRefiner::deleteOutlierSamples()
 
 	// delete outliers
 	Scene::getSingleton().eraseSamples(inliers, true);
+	mViewSamplePairOrder.clear();
 
 	// free resources
 	delete [] inliers;
@@ -1763,6 +2531,8 @@ void FSSFRefiner::clear()
 	// clear merging & subdivision data
 	mEdgeMergeCandidates.clear();
 	mLeftEdgeMergeCandidates.clear();
+	mLeftTriangleMergeCandidates.clear();
+	mMergedVertices.clear();
 	mSubdivisionEdges.clear();
 
 	//// clear edges' data
@@ -1779,6 +2549,16 @@ void FSSFRefiner::clear()
 	// clear connectivity data
 	mVertexNeighborsOffsets.clear();
 	mVertexNeighbors.clear();
+	mDijkstraSteps.clear();
+	mViewSamplePairOrder.clear();
+
+	// projection mode starts with ray patterns
+	mTriangleBVH.clear();
+	mMeanRelativeMovement = REAL_MAX;
+	mUsingClosestPointProjection = false;
+	mPairSubset.clear();
+	mPairSubsetFraction = 1.0f;
+	mAllPairsRequired = false;
 
 	// clear base object
 	MeshRefiner::clear();
@@ -1843,7 +2623,7 @@ void FSSFRefiner::outputErrorColoredMesh(vector<Real> &temp, const Real *errors,
 	std::nth_element(temp.begin(), it, temp.end());
 	const Real maximum = *it;
 	
-	StaticMesh staticMesh(mMesh.getColors(), mMesh.getNormals(), mMesh.getPositions(), mMesh.getScales(), mMesh.getIndices(),
+	StaticMesh *snapshot = new StaticMesh(mMesh.getColors(), mMesh.getNormals(), mMesh.getPositions(), mMesh.getScales(), mMesh.getIndices(),
 		vertexCount, indexCount);
 
 	// compute error colors
@@ -1854,20 +2634,20 @@ void FSSFRefiner::outputErrorColoredMesh(vector<Real> &temp, const Real *errors,
 		const Real error = errors[vertexIdx];
 		const Real colorFactor = clamp<Real>(error * scaleFactor, 1.0f, 0.0f);
 
-		Vector3 &color = staticMesh.getColor(vertexIdx);
+		Vector3 &color = snapshot->getColor(vertexIdx);
 		if (isBad(vertexIdx))
 			color.set(1.0f, 0.5f, 0.5f);
 		else
 			color.set(colorFactor, 0.5f, 0.5f);
 	}
 
-	FSSFRefiner::saveMesh(staticMesh, iteration, coreName.data());
+	FSSFRefiner::saveSnapshot(snapshot, iteration, coreName.data());
 }
 
 void FSSFRefiner::saveAngleColoredMesh(const uint32 iteration) const
 {
 	const uint32 vertexCount = mMesh.getVertexCount();
-	FlexibleMesh copy(mMesh);
+	FlexibleMesh *copy = new FlexibleMesh(mMesh);
 
 	#pragma omp parallel for
 	for (int64 i = 0; i < vertexCount; ++i)
@@ -1883,27 +2663,27 @@ void FSSFRefiner::saveAngleColoredMesh(const uint32 iteration) const
 			color.y = (average - QUARTER_PI) / HALF_PI + 0.5f;
 		else
 			color.z = average / HALF_PI + 0.5f; 
-		copy.setColor(color, vertexIdx);
-		copy.setScale(average, vertexIdx);
+		copy->setColor(color, vertexIdx);
+		copy->setScale(average, vertexIdx);
 	}
 
-	FSSFRefiner::saveMesh(copy, iteration, "ColoredByAngles");
+	FSSFRefiner::saveSnapshot(copy, iteration, "ColoredByAngles");
 }
 
 void FSSFRefiner::saveResult(const uint32 iteration)
 {
-	FlexibleMesh copy(mMesh);
-	copy.deleteUnsupportedGeometry(*this);
-	copy.computeNormalsWeightedByAngles();
-	FSSFRefiner::saveMesh(copy, iteration, "Result");
+	FlexibleMesh *copy = new FlexibleMesh(mMesh);
+	copy->deleteUnsupportedGeometry(*this);
+	copy->computeNormalsWeightedByAngles();
+	FSSFRefiner::saveSnapshot(copy, iteration, "Result");
 }
 
 void FSSFRefiner::saveOutlierColoredMesh(const uint32 iteration) const
 {
 	// mark OUTLIER, BORDER_INLIER and unreliable vertices
-	FlexibleMesh copy(mMesh);
-	Vector3 *colors = copy.getColors();
-	for (uint32 i = 0; i < copy.getVertexCount(); ++i)
+	FlexibleMesh *copy = new FlexibleMesh(mMesh);
+	Vector3 *colors = copy->getColors();
+	for (uint32 i = 0; i < copy->getVertexCount(); ++i)
 	{
 		const uint8 state = mVertexStates[i];
 		
@@ -1913,7 +2693,7 @@ void FSSFRefiner::saveOutlierColoredMesh(const uint32 iteration) const
 		colors[i].set(red, green, blue);
 	}
 
-	FSSFRefiner::saveMesh(copy, iteration, "OutliersAndUnreliableOnes");
+	FSSFRefiner::saveSnapshot(copy, iteration, "OutliersAndUnreliableOnes");
 }
 
 void FSSFRefiner::saveMeshForDebugging(FlexibleMesh &mesh,
@@ -1987,6 +2767,20 @@ void FSSFRefiner::saveMeshForDebugging(FlexibleMesh &mesh,
 }
 
 void FSSFRefiner::saveMesh(const Mesh &mesh, const uint32 iteration, const char *text, const bool saveAsMesh)
+{
+	// save it
+	const Path fileName = getIterationFileName(iteration, text);
+	mesh.saveToFile(fileName, true, saveAsMesh);
+}
+
+void FSSFRefiner::saveSnapshot(Mesh *snapshot, const uint32 iteration, const char *text, const bool saveAsMesh)
+{
+	// save it in the background if possible
+	const Path fileName = getIterationFileName(iteration, text);
+	AsyncMeshWriter::save(snapshot, fileName, true, saveAsMesh);
+}
+
+Path FSSFRefiner::getIterationFileName(const uint32 iteration, const char *text)
 {
 	// file name
 	const uint32 BUFFER_SIZE = 100;
@@ -1995,10 +2789,7 @@ void FSSFRefiner::saveMesh(const Mesh &mesh, const uint32 iteration, const char
 
 	const Path &folder = Scene::getSingleton().getResultsFolder();
 	const string temp(buffer);
-	const Path fileName = Path::appendChild(folder, temp + text);
-
-	// save it
-	mesh.saveToFile(fileName, true, saveAsMesh);
+	return Path::appendChild(folder, temp + text);
 }
 
 
@@ -11,12 +11,16 @@
 
 // todo comments
 
+#include "Platform/Storage/Path.h"
 #include "SurfaceReconstruction/Geometry/IVertexChecker.h"
 #include "SurfaceReconstruction/Geometry/Surfel.h"
+#include "SurfaceReconstruction/Geometry/TriangleBVH.h"
+#include "SurfaceReconstruction/Refinement/MeshDijkstraCache.h"
 #include "SurfaceReconstruction/Refinement/MeshDijkstraParameters.h"
 #include "SurfaceReconstruction/Refinement/MeshRefiner.h"
 #include "SurfaceReconstruction/Refinement/FSSFParameters.h"
 #include "SurfaceReconstruction/Refinement/FSSFStatistics.h"
+#include "SurfaceReconstruction/Scene/FixedPointSum.h"
 
 namespace SurfaceReconstruction
 {
@@ -34,6 +38,16 @@ namespace SurfaceReconstruction
 			BORDER_INLIER	= 0x1 << 3
 		};
 
+		/// Per vertex layout of mFixedVertexSums.
+		enum FixedVertexSum
+		{
+			FIXED_SUM_COLOR				= 0,	/// 3 sums for x, y and z
+			FIXED_SUM_CORRECTION		= 3,	/// 3 sums for x, y and z
+			FIXED_SUM_SURFACE_ERROR		= 6,
+			FIXED_SUM_WEIGHT			= 7,
+			FIXED_SUM_COUNT				= 8
+		};
+
 		struct ProjectedSample
 		{
 			Surfel mSurfel;
@@ -41,6 +55,24 @@ namespace SurfaceReconstruction
 			Real mConfidence;
 		};
 
+		/// Counters of the adaptive supersampling mode for one kernelInterpolation call. (See FSSFParameters::mAdaptiveSupersampling.)
+		struct AdaptiveSamplingReport
+		{
+		public:
+			AdaptiveSamplingReport();
+
+			uint64 mPairCount;				/// Number of view sample pairs which were probed.
+			uint64 mRefinedPairCount;		/// Number of pairs with disagreeing probes which were traced with the complete pattern.
+			uint64 mTracedRayCount;			/// Probe and refinement rays without validation rays.
+			uint64 mFixedPatternRayCount;	/// Rays the fixed complete pattern requires for the same pairs.
+
+			// deviations of probe results from complete pattern results, only with FSSFParameters::mValidateAdaptiveSupersampling
+			uint64 mValidatedPairCount;		/// Number of pairs with agreeing probes which were compared to their complete pattern results.
+			uint64 mDecisionMismatchCount;	/// Pairs which are used by one mode but discarded by the other one.
+			double mConfidenceErrorSum;		/// Sum of absolute confidence differences.
+			Real mMaxConfidenceError;		/// Maximum absolute confidence difference.
+		};
+
 	public:
 		static void findDepthExtrema(Real &minDepth, Real &maxDepth, const Real *depthMap, uint32 pixelCount);
 
@@ -59,6 +91,10 @@ namespace SurfaceReconstruction
 
 		inline const FSSFParameters &getParameters() const;
 
+		/** Returns the number of vertices for which the fused vertex update and the separate passes gave different results, summed over all iterations.
+			It is only counted if FSSFParameters::mValidateFusedVertexUpdate is set. */
+		inline uint64 getFusedVertexUpdateMismatchCount() const;
+
 		inline virtual bool isBad(const uint32 vertexIdx) const;
 
 		void loadFromFile(const std::string &meshFileName);
@@ -66,8 +102,15 @@ namespace SurfaceReconstruction
 		void refine();
 
 	protected:
+		/** Returns the results folder file name beginning for the mesh of FSSF iteration iteration described by text. */
+		static Storage::Path getIterationFileName(const uint32 iteration, const char *text);
+
 		static void saveMesh(const Mesh &mesh, const uint32 iteration, const char *text, const bool saveAsMesh = false);
 
+		/** Like saveMesh but saves snapshot via the AsyncMeshWriter in the background if there is one.
+		@param snapshot Set this to a mesh copy allocated via new. Ownership is transferred. */
+		static void saveSnapshot(Mesh *snapshot, const uint32 iteration, const char *text, const bool saveAsMesh = false);
+
 	protected:
 		FSSFRefiner();
 
@@ -77,10 +120,13 @@ namespace SurfaceReconstruction
 			Real &targetSumOfSurfaceErrors, Real &targetSumOfWeights,
 			const Math::Vector3 &correctionDir, const Math::Vector3 &surfacePosWS,
 			const Math::Vector3 *sampleColor, const Math::Vector3 &sampleNormalWS, const Math::Vector3 &samplePosWS,
-			const Real weight);
+			const Real weight, FixedPointSum *fixedTargets);
 		
 		void addToOutliers(const std::vector<uint32> &newOutliers);
 
+		/** Replaces the floating scale quantities of all vertices by the deterministic sums of mFixedVertexSums and frees these. */
+		void applyFixedVertexSums();
+
 		void averageVertexAngles();
 
 		bool computeErrorStatistics(const uint32 iteration);
@@ -127,12 +173,31 @@ namespace SurfaceReconstruction
 		//void findSubdivisionEdgesViaErrors();
 		void findSubdivisionEdgesViaNodes();
 	
+		/** Returns the triangles which findMergingEdges must check or NULL for all triangles.
+			These are the ones of left edge merge candidates and, with FSSFParameters::mEdgeMergeOneRingRechecks, the ones around vertices of the last merge round as their shapes changed.
+		@param triangleCount Is set to the number of returned triangles or to the total triangle count. */
 		uint32 *getEdgeMergeTriangleSearchSet(uint32 &triangleCount);
+
+		/** Returns the precomputed geometry of the Dijkstra steps along the current mesh or NULL if the steps are computed on the fly. */
+		inline const MeshDijkstra::Step *getDijkstraSteps() const;
+
 		Real getMinIntersectionTreeNodeLength(const Math::Vector3 triangle[3]) const;
+
+		/** Sets mMinTriangleNodeLengths to getMinIntersectionTreeNodeLength of every triangle via one simultaneous traversal of mTriangleBVH and the scene tree. */
+		void computeMinIntersectionTreeNodeLengths();
 		uint32 getNeighborCount(const uint8 flag, const uint32 vertexIdx) const;
 
+		/** Returns the fraction of view sample pairs which is processed by the next kernelInterpolation call.
+			It grows from mParams.mPairSubsetMinFraction to 1 with decreasing mean vertex movement. It is 1 if pair subsets are disabled or all pairs are required. */
+		Real getPairSubsetFraction() const;
+
 		Real getProjectionConfidence(const Surfel &surfel, const uint32 sampleIdx) const;
 		void getProjectedSample(ProjectedSample &projectedSample, const uint32 localPairIdx, const uint32 sampleIdx) const;
+
+		/** Computes projectedSample like getProjectedSample but only from the PROBE_RAY_COUNT probe rays of the pair localPairIdx.
+			The first probe is the pattern center which defines the projected surfel like for the complete pattern.
+			@return Returns false if the probes disagree in hit validity, triangle & depth or normal and the complete pattern is required. */
+		bool getProbedProjectedSample(ProjectedSample &projectedSample, const uint32 localPairIdx, const uint32 sampleIdx) const;
 				
 		bool getSurfaceErrorCorrection(Math::Vector3 &correction, 
 			const Math::Vector3 &correctionDirection, const Math::Vector3 &surfacePosition,
@@ -146,6 +211,21 @@ namespace SurfaceReconstruction
 
 		inline bool isSpiky(const uint32 vertexIdx) const;
 
+		/** Returns true if the interpolated weight of vertex vertexIdx is too small or invalid for weighted means. Such vertices are not moved. */
+		inline bool isWeaklySupported(const uint32 vertexIdx) const;
+
+		/** Returns true if view sample pairs are supposed to be probed with a pattern subset first. This requires a pattern center ray, i.e., odd pattern dimensions. */
+		inline bool isUsingAdaptiveSupersampling() const;
+
+		/** Returns true if surface kernel searches are supposed to reuse cached neighborhoods during kernelInterpolation.
+			Which neighborhoods are cached depends on thread scheduling. Thus, they are not used in deterministic reductions mode. */
+		inline bool isUsingDijkstraCache() const;
+
+		/** Returns true if the last kernelInterpolation call only processed a subset of the view sample pairs.
+			The interpolated weights and errors of such an iteration are only estimates.
+			Thus, it neither changes vertex reliability, outlier deletion nor the best vertex positions and errors. */
+		inline bool isUsingPairSubset() const;
+
 		void kernelInterpolation();
 
 		//void limitVertexCorrections();
@@ -159,8 +239,25 @@ namespace SurfaceReconstruction
 		void moveVertices();
 		bool moveSpikyGeometryBack();
 
+		/** Moves vertex vertexIdx via mVectorField or back to its best position if its new surface error is too large. Used by moveVertices and updateVertices.
+		@param relativeMovement Is set to the movement length relative to the vertex scale if the vertex was moved via mVectorField and has a valid scale.
+		@return Returns true if relativeMovement was set. */
+		bool moveVertex(Real &relativeMovement, const uint32 vertexIdx);
+
 		/** Normalizes weighted sums (e.g. mMovmentField, mColors) for weighted means using mWeightField. */
 		void normalize();
+
+		/** Sets mMeanRelativeMovement from the summed relative vertex movements of moveVertices or updateVertices. */
+		void setMeanRelativeMovement(const double movementSum, const int64 movedVertexCount);
+
+		/** Does normalize(), markUnreliableVerticesViaSupport() and moveVertices() with identical results but in a single pass over the vertex data.
+			Each vertex only depends on its own data in these steps. Requires vertex scales which are computed before. */
+		void updateVertices();
+
+		/** Runs normalize(), markUnreliableVerticesViaSupport() and moveVertices() and then updateVertices() on the same weighted sums and vertex data.
+			Keeps the results of updateVertices() and adds the number of vertices with bitwise different positions, states, surface errors, best positions or
+			best surface errors to mFusedVertexUpdateMismatchCount. (See FSSFParameters::mValidateFusedVertexUpdate.) */
+		void validateFusedVertexUpdate();
 		
 		void createWellFormedOutlierIsles();
 
@@ -179,6 +276,12 @@ namespace SurfaceReconstruction
 			const uint32 firstNewTriangle, const uint32 newTriangleCount);
 
 		virtual void onNewStartMesh();
+
+		virtual void onReorderData(
+			const uint32 *vertexOrder, const uint32 vertexCount,
+			const uint32 *edgeOrder, const uint32 edgeCount,
+			const uint32 *triangleOrder, const uint32 triangleCount);
+
 		virtual void onReserveMemory(const uint32 vertexCapacity, const uint32 edgeCapacity, const uint32 indexCapacity);
 		
 
@@ -187,6 +290,18 @@ namespace SurfaceReconstruction
 
 		void processProjectedSample(const ProjectedSample &projectedSample, const uint32 sampleIdx);
 
+		/** Projects the sample of each view sample pair onto its closest surface point which faces the pair view instead of tracing a ray pattern and processes it.
+			The projection confidence is computed like for a single ray. Requires mTriangleBVH for the current mesh.
+		@param pairOrder Set this to NULL to process the pairs in view cone order or to pairCount view cone indices. */
+		void projectSamplesOntoClosestPoints(const uint32 *pairOrder, const uint32 pairCount);
+
+		/** Traces the probes of the view sample pairs [startPairIdx, startPairIdx + pairCount) of pairOrder (or in view cone order if pairOrder is NULL)
+			and processes them. Pairs with disagreeing probes are traced and processed with the complete pattern afterwards.
+		@param report Is updated with the numbers of traced pairs & rays and possibly with the deviations from the complete pattern.
+		@param probePattern Contains the row major pattern indices of the PROBE_RAY_COUNT probe rays with the center first. */
+		void processViewSamplePairsAdaptively(AdaptiveSamplingReport &report, const uint32 *probePattern,
+			const uint32 *pairOrder, const uint32 startPairIdx, const uint32 pairCount);
+
 		void removeTangentialCorrections();
 
 		void reserve(const uint32 vertexCapacity, const uint32 edgeCapacity, const uint32 triangleCapacity);
@@ -194,6 +309,12 @@ namespace SurfaceReconstruction
 		void resize(const uint32 newVertexCount, const uint32 newEdgeCount, const uint32 newTriangleCount);
 		
 		void saveAngleColoredMesh(const uint32 iteration) const;
+
+		/** Fills mPairSubset with a stratified random subset of the pairCount view sample pairs of pairOrder (or in view cone order if pairOrder is NULL).
+			The strata are the disjoint sample sets of the scene tree nodes. Within each stratum, about fraction of its pairs are chosen evenly spread via systematic sampling with random start.
+			Each kept pair thus represents 1 / fraction pairs in expectation. */
+		void selectPairSubset(const uint32 *pairOrder, const uint32 pairCount, const Real fraction);
+
 		void saveResult(const uint32 iteration);
 
 		static void saveMeshForDebugging(FlexibleMesh &copy, 
@@ -203,6 +324,10 @@ namespace SurfaceReconstruction
 
 		void simplifyMesh(const uint32 iteration);
 		void subdivideMesh();
+
+		/** Sorts all view sample pairs with valid views by view and, for the same view, by sample index into mViewSamplePairOrder if it is empty.
+			Samples are ordered by the scene tree and thus spatially coherent. So the rays and surface kernel searches of consecutive pairs are coherent, too. */
+		void updateViewSamplePairOrder();
 		
 		bool smoothUntilConvergence(const uint8 requiredFlags);
 		bool smoothIsleUntilConvergence(const std::vector<uint32> &isle);
@@ -219,6 +344,7 @@ namespace SurfaceReconstruction
 		static const uint32 MEMORY_ALLOCATION_FACTOR;
 		static const uint32 OMP_PAIR_BATCH_COUNT;
 		static const uint32 OMP_PAIR_BATCH_SIZE;
+		static const uint32 PROBE_RAY_COUNT;		/// Number of probe rays per view sample pair in adaptive supersampling mode: center & 4 corners.
 
 	private:
 		// triangle data
@@ -236,20 +362,44 @@ namespace SurfaceReconstruction
 		std::vector<Real> mRelativeSurfaceErrors; /// = mSurfaceErrors normalized by vertex scale values.
 		std::vector<uint8> mVertexStates;		/// Contains data to identify vertex support, outliers, bad normals used for replacing geometry or smoothing for robustness.
 		std::vector<Real> mAverageAngles[2];
+		std::vector<FixedPointSum> mFixedVertexSums;	/// FIXED_SUM_COUNT order independent sums per vertex during kernelInterpolation in deterministic reductions mode. Empty otherwise.
 
 		// for surface hits processing
 		std::vector<Real> *mLocalConfidences;
 
 		// for quick Dijkstra searches
 		MeshDijkstra *mDijkstras;						/// For each process: Dijkstra object for shortest path searches along surface.
+		MeshDijkstraCache mDijkstraCache;				/// Reusable searches for samples which are projected onto the same triangles. Only valid during kernelInterpolation.
+		std::vector<MeshDijkstra::Step> mDijkstraSteps;	/// Precomputed step geometry for each mVertexNeighbors entry if mParams.mCacheDijkstraSteps is set. Only valid during kernelInterpolation.
 		//std::vector<Real> *mLocalEdgeWeights;			/// Stores data-driven surface kernel edge weights for local surface refinements (subdivision).
 		std::vector<uint32> mVertexNeighborsOffsets;	/// mVertexNeighbors[i] starts at mVertexNeighborsOffsets[i] and ends at (exclusive) mVertexNeighborsOffsets[i + 1];
 		std::vector<uint32> mVertexNeighbors;			/// mVertexNeighbors[i] contains the global direct vertex neighbor indices of vertex i
 
+		// view sample pair order
+		std::vector<uint32> mViewSamplePairOrder;		/// View cone indices grouped by view if mParams.mSortViewSamplePairs is set. Cleared whenever the samples change.
+
+		// adaptive supersampling data
+		std::vector<ProjectedSample> mValidationSamples;	/// Complete pattern results of the current pair batch if adaptive supersampling is validated.
+		std::vector<uint32> mBatchPairs;					/// View cone indices of the current pair batch.
+		std::vector<uint32> mRefinedPairs;					/// View cone indices of the pairs of the current batch with disagreeing probes.
+		std::vector<uint8> mPairRefinementFlags;			/// For each pair of the current batch: 1 if its probes disagree and 0 otherwise.
+
+		// closest point projection data
+		TriangleBVH mTriangleBVH;				/// Closest point queries on the current mesh. Only valid during kernelInterpolation in closest point projection mode and computeMinIntersectionTreeNodeLengths.
+		Real mMeanRelativeMovement;				/// Mean vertex movement of the last moveVertices call relative to the vertex scales.
+		bool mUsingClosestPointProjection;		/// Set once mMeanRelativeMovement is small enough if mParams.mClosestPointProjection is enabled.
+
+		// coarse to fine pair subsets
+		std::vector<uint32> mPairSubset;		/// View cone indices processed by the current kernelInterpolation call if only a subset of the pairs is used.
+		Real mPairSubsetFraction;				/// Fraction of the pairs which were processed by the last kernelInterpolation call. Kernel weights are scaled by its inverse.
+		bool mAllPairsRequired;					/// Set if the statistics converged with a pair subset. The next iteration then processes all pairs.
+
 		// merging & subdivision data
 		std::vector<uint32> mEdgeMergeCandidates;
 		std::vector<uint32> mLeftEdgeMergeCandidates;
 		std::vector<uint32> mLeftTriangleMergeCandidates;
+		std::vector<Real> mMinTriangleNodeLengths;	/// Per triangle: smallest size of the intersected scene tree leaves, see computeMinIntersectionTreeNodeLengths.
+		std::vector<uint32> mMergedVertices;	/// Target vertices of the last merge round, i.e., centers of the changed one-rings. Kept up to date via onFilterData.
 		std::vector<uint32> mSubdivisionEdges;
 
 		// temp vector for enforcing regular geometry
@@ -258,6 +408,8 @@ namespace SurfaceReconstruction
 		// iteration, error statistics & convergence stuff
 		FSSFStatistics mStatistics;					/// Error statistics. Used to estimate convergence.
 		uint32 mFirstHoleFillingTriangle;			/// triangles with indices >= mFirstHoleFillingTriangle until the last one were created to fill holes.
+		uint64 mTopologyChurn;						/// Number of created and deleted vertices since the last spatial reordering of the mesh.
+		uint64 mFusedVertexUpdateMismatchCount;		/// Vertices with different results of both vertex update variants over all iterations, see validateFusedVertexUpdate.
 
 		const MeshDijkstraParameters mDijkstraParams;
 		const FSSFParameters mParams;
@@ -291,6 +443,16 @@ namespace SurfaceReconstruction
 	{
 		return mParams;
 	}
+
+	inline uint64 FSSFRefiner::getFusedVertexUpdateMismatchCount() const
+	{
+		return mFusedVertexUpdateMismatchCount;
+	}
+
+	inline const MeshDijkstra::Step *FSSFRefiner::getDijkstraSteps() const
+	{
+		return (mDijkstraSteps.empty() ? NULL : mDijkstraSteps.data());
+	}
 	
 	inline bool FSSFRefiner::isBad(const uint32 vertexIdx) const
 	{
@@ -304,6 +466,28 @@ namespace SurfaceReconstruction
 		return 0 !=  (SPIKY & mVertexStates[vertexIdx]);
 	}
 
+	inline bool FSSFRefiner::isWeaklySupported(const uint32 vertexIdx) const
+	{
+		const Real weight = mWeightField[vertexIdx];
+		return (weight < mParams.mSupportWeakThreshold || Math::isNaN(weight));
+	}
+
+	inline bool FSSFRefiner::isUsingAdaptiveSupersampling() const
+	{
+		const Utilities::Size2<uint32> &pattern = mParams.mRaysPerViewSamplePair;
+		return mParams.mAdaptiveSupersampling && (1 == pattern[0] % 2) && (1 == pattern[1] % 2) && (pattern.getElementCount() > PROBE_RAY_COUNT);
+	}
+
+	inline bool FSSFRefiner::isUsingDijkstraCache() const
+	{
+		return mParams.mCacheGeodesicNeighborhoods && mFixedVertexSums.empty();
+	}
+
+	inline bool FSSFRefiner::isUsingPairSubset() const
+	{
+		return mPairSubsetFraction < 1.0f;
+	}
+
 	inline FSSFRefiner &FSSFRefiner::operator =(const FSSFRefiner &rhs)
 	{
 		assert(false);
@@ -30,6 +30,8 @@ const char *FSSFIterationStats::msErrorDescriptions[FSSFIterationStats::ERROR_TY
 	"absolute"
 };
 
+const uint32 FSSFStatistics::ERROR_BLOCK_SIZE = 0x1 << 12;
+
 FSSFIterationStats::FSSFIterationStats()
 {
 	clear();
@@ -89,12 +91,8 @@ FSSFIterationStats &FSSFIterationStats::operator +=(const FSSFIterationStats &so
 }
 
 FSSFStatistics::FSSFStatistics() :
-	mTargetError(EPSILON), mFailedReductionCount(0)
+	mTargetError(EPSILON), mFailedReductionCount(0), mMaxIterationCount(0)
 {
-	// create thread objects for parallel stats computation
-	const uint32 maxNumThreads = omp_get_max_threads();
-	mStatsPerThread = new FSSFIterationStats[maxNumThreads];
-
 	// set parameters
 	// required parameters
 	const string relativeThresholdName = "FSSFStatistics::targetSurfaceErrorReductionThreshold";
@@ -139,18 +137,21 @@ FSSFStatistics::FSSFStatistics() :
 
 		mFailedReductionCountMax = 3;
 	}
+
+	// optional iteration limit, e.g., for benchmarks
+	manager.get(mMaxIterationCount, "FSSFStatistics::maxIterationCount");
 }
 
 FSSFStatistics::~FSSFStatistics()
 {
-	delete [] mStatsPerThread;
-	mStatsPerThread = NULL;
-
 	mStats.clear();
 }
 
 bool FSSFStatistics::hasConverged()
 {
+	if (0 != mMaxIterationCount && mStats.size() >= mMaxIterationCount)
+		return true;
+
 	if (mStats.back().getMeanError(FSSFIterationStats::ABSOLUTE_ERROR) < mTargetError)
 		return true;
 	
@@ -160,19 +161,10 @@ bool FSSFStatistics::hasConverged()
 void FSSFStatistics::processIteration(const Real **errors, const Real **weights, const uint32 *arraySizes, const uint32 arrayCount,
 	const Real weakSupportThreshold)
 {
-	// clear stats of new iteration
-	const uint32 maxNumThreads = omp_get_max_threads();
-	for (uint32 i = 0; i < maxNumThreads; ++i)
-		mStatsPerThread[i].clear();
-
-	// gather new stats per thread
-	for (uint32 i = 0; i < arrayCount; ++i)
-		processErrors(errors[i], weights[i], arraySizes[i], weakSupportThreshold);
-
-	// merge per thread data
+	// gather new stats in a fixed order
 	FSSFIterationStats target;
-	for (uint32 i = 0; i < maxNumThreads; ++i)
-		target += mStatsPerThread[i];
+	for (uint32 i = 0; i < arrayCount; ++i)
+		processErrors(target, errors[i], weights[i], arraySizes[i], weakSupportThreshold);
 	mStats.push_back(target);
 	
 	// better than before?
@@ -219,30 +211,40 @@ void FSSFStatistics::processIteration(const Real **errors, const Real **weights,
 	cout << "Low error improvement count: " << mFailedReductionCount << endl;
 }
 
-void FSSFStatistics::processErrors(const Real *errors, const Real *weights, const uint32 count,
+void FSSFStatistics::processErrors(FSSFIterationStats &target, const Real *errors, const Real *weights, const uint32 count,
 	const Real weakSupportThreshold)
 {
-	const int64 temp = count;
+	// gather stats per block of errors independent of the thread count
+	const int64 blockCount = (count + ERROR_BLOCK_SIZE - 1) / ERROR_BLOCK_SIZE;
+	vector<FSSFIterationStats> blockStats(blockCount);
 
-	// gather stats per thread
 	#pragma omp parallel for
-	for (int64 i = 0; i < temp; ++i)
+	for (int64 blockIdx = 0; blockIdx < blockCount; ++blockIdx)
 	{
-		// reliable estimate?
-		if (weights[i] < weakSupportThreshold)
-			continue;
-
-		// add error to statistics
-		const Real &error = errors[i];
-		if (Math::isNaN(error))
-			continue;
-		if (REAL_MAX == error)
-			continue;
-
-		const uint32 threadIdx = omp_get_thread_num();
-		FSSFIterationStats &data = mStatsPerThread[threadIdx];
-		data.addError(error);
+		const uint32 start = (uint32) (blockIdx * ERROR_BLOCK_SIZE);
+		const uint32 end = (start + ERROR_BLOCK_SIZE < count ? start + ERROR_BLOCK_SIZE : count);
+		FSSFIterationStats &data = blockStats[blockIdx];
+
+		for (uint32 i = start; i < end; ++i)
+		{
+			// reliable estimate?
+			if (weights[i] < weakSupportThreshold)
+				continue;
+
+			// add error to statistics
+			const Real &error = errors[i];
+			if (Math::isNaN(error))
+				continue;
+			if (REAL_MAX == error)
+				continue;
+
+			data.addError(error);
+		}
 	}
+
+	// merge block data in block order
+	for (int64 blockIdx = 0; blockIdx < blockCount; ++blockIdx)
+		target += blockStats[blockIdx];
 }
 
 void FSSFStatistics::saveToFile(const Path &fileName) const
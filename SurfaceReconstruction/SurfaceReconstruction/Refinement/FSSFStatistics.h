@@ -71,15 +71,20 @@ namespace SurfaceReconstruction
 		void saveToFile(const Storage::Path &fileName) const;
 
 	protected:
-		void processErrors(const Real *errors, const Real *weights, const uint32 count, const Real weakSupportThreshold);
+		/** Adds the reliable errors to target. Errors are summed in fixed blocks which are merged in block order
+			so that the statistics and thus the convergence decision do not depend on the thread count. */
+		void processErrors(FSSFIterationStats &target, const Real *errors, const Real *weights, const uint32 count, const Real weakSupportThreshold);
+
+	public:
+		static const uint32 ERROR_BLOCK_SIZE;	/// Number of consecutive errors which are summed sequentially by processErrors.
 		
 	private:
 		std::vector<FSSFIterationStats> mStats;
-		FSSFIterationStats *mStatsPerThread;
 		Real mTargetErrorReductionThreshold;
 		Real mTargetError;
 		uint32 mFailedReductionCountMax;
 		uint32 mFailedReductionCount;
+		uint32 mMaxIterationCount;	/// Refinement stops after this many iterations or only by the error criteria if it is zero.
 	};
 
 	std::ostream &operator <<(std::ostream &os, const FSSFIterationStats &rhs);
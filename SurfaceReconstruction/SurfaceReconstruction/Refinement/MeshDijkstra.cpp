@@ -18,9 +18,34 @@ using namespace SurfaceReconstruction;
 
 const uint32 MeshDijkstra::INVALID_NODE = (uint32) -1;
 
+void MeshDijkstra::computeSteps(vector<Step> &steps, const FlexibleMesh &mesh, const Vector3 *triangleNormals,
+	const uint32 *vertexNeighbors, const uint32 *vertexNeighborsOffsets)
+{
+	// one step per vertex neighbors entry
+	const Vector3 *positions = mesh.getPositions();
+	const int64 vertexCount = mesh.getVertexCount();
+	steps.resize(vertexNeighborsOffsets[vertexCount]);
+
+	#pragma omp parallel for
+	for (int64 vertexIdx = 0; vertexIdx < vertexCount; ++vertexIdx)
+	{
+		const uint32 v0Idx = (uint32) vertexIdx;
+		const uint32 start = vertexNeighborsOffsets[v0Idx];
+		const uint32 end = vertexNeighborsOffsets[v0Idx + 1];
+
+		for (uint32 neighborSlot = start; neighborSlot < end; ++neighborSlot)
+		{
+			// border edges are never traversed
+			Step &step = steps[neighborSlot];
+			if (!getStepGeometry(step.mNormal, step.mLength, mesh, triangleNormals, positions, v0Idx, vertexNeighbors[neighborSlot]))
+				step.mLength = -1.0f;
+		}
+	}
+}
+
 MeshDijkstra::MeshDijkstra() :
-	mMesh(NULL), mTriangleNormals(NULL),
-	mVertexNeighborsOffsets(NULL), mVertexNeighbors(NULL)
+	mExpansionCount(0), mMesh(NULL), mTriangleNormals(NULL),
+	mVertexNeighborsOffsets(NULL), mVertexNeighbors(NULL), mSteps(NULL)
 {
 	const uint32 count = 1000;
 	mOrder.reserve(count);
@@ -32,13 +57,14 @@ void MeshDijkstra::findVertices(const FlexibleMesh *mesh, const Vector3 *triangl
 	const uint32 *vertexNeighbors, const uint32 *vertexNeighborsOffsets,
 	const Vector3 &referenceNormal, const Vector3 &referencePosition,
 	const Vector3 *startNormals, const uint32 *startVertices, const uint32 startVertexCount,
-	const Real maxCosts, const Real maxAngleDifference, const Real angularCostsFactor)
+	const Real maxCosts, const Real maxAngleDifference, const Real angularCostsFactor, const Step *steps)
 {
 	// set mesh data
 	mMesh = mesh;
 	mTriangleNormals = triangleNormals;
 	mVertexNeighbors = vertexNeighbors;
 	mVertexNeighborsOffsets = vertexNeighborsOffsets;
+	mSteps = steps;
 
 	// set search configuration data
 	mAngularCostsFactor = angularCostsFactor;
@@ -60,6 +86,7 @@ void MeshDijkstra::findVertices(const FlexibleMesh *mesh, const Vector3 *triangl
 
 		// remove next best from working set
 		mOrder.push_back(nextBestLocalIdx);
+		++mExpansionCount;
 		pop_heap(mWorkingSet.begin(), mWorkingSet.end(), MeshDijkstra::Comparer(*this));
 		mWorkingSet.pop_back();
 
@@ -73,19 +100,95 @@ void MeshDijkstra::findVertices(const FlexibleMesh *mesh, const Vector3 *triangl
 		for (uint32 localNeighborIdx = 0; localNeighborIdx < neighborCount; ++localNeighborIdx)	
 		{
 			const uint32 globalNeighborIdx = neighbors[localNeighborIdx];
-			processNeighbor(nextBestLocalIdx, globalNeighborIdx, referenceNormal, positions);
+			processNeighbor(nextBestLocalIdx, globalNeighborIdx, start + localNeighborIdx, referenceNormal, positions);
+		}
+	}
+}
+
+void MeshDijkstra::combineNeighborhoods(const FlexibleMesh *mesh,
+	const Vector3 &referenceNormal, const Vector3 &referencePosition,
+	const uint32 *startVertices, const vector<RangedVertexIdx> *startNeighborhoods, const uint32 startVertexCount,
+	const Real maxCosts, const Real maxAngleDifference, const Real angularCostsFactor)
+{
+	// set mesh & search configuration data
+	mMesh = mesh;
+	mAngularCostsFactor = angularCostsFactor;
+	mMaxAngleDifference = maxAngleDifference;
+	mMaxCosts = maxCosts;
+
+	// clean start
+	const Vector3 *positions = mMesh->getPositions();
+	clear();
+
+	for (uint32 localStartIdx = 0; localStartIdx < startVertexCount; ++localStartIdx)
+	{
+		// costs to get to the start vertex
+		const uint32 globalStartIdx = startVertices[localStartIdx];
+		if (Vertex::INVALID_IDX == globalStartIdx)
+			continue;
+
+		const Vector3 &p = positions[globalStartIdx];
+		const Real startCosts = RangedVertexIdx::getDeltaCosts(referenceNormal, referenceNormal, referencePosition, p, mMaxAngleDifference, mAngularCostsFactor);
+		if (startCosts >= maxCosts)
+			continue;
+
+		// lowest costs for each vertex over all start vertices
+		const vector<RangedVertexIdx> &neighborhood = startNeighborhoods[localStartIdx];
+		const uint32 neighborhoodSize = (uint32) neighborhood.size();
+		for (uint32 localNeighborIdx = 0; localNeighborIdx < neighborhoodSize; ++localNeighborIdx)
+		{
+			// within range?
+			const RangedVertexIdx &neighbor = neighborhood[localNeighborIdx];
+			const Real costs = startCosts + neighbor.getCosts();
+			if (costs >= maxCosts)
+				continue;
+
+			// new or duplicate vertex index?
+			const uint32 globalVertexIdx = neighbor.getGlobalVertexIdx();
+			const uint32 newVertexIdx = (uint32) mVertices.size();
+			pair<map<uint32, uint32>::iterator, bool> result = mVisitedVertices.insert(make_pair(globalVertexIdx, newVertexIdx));
+			if (!result.second)
+			{
+				RangedVertexIdx &vIdx = mVertices[result.first->second];
+				if (costs < vIdx.getCosts())
+					vIdx.setCosts(costs);
+				continue;
+			}
+
+			mVertices.push_back(RangedVertexIdx(costs, globalVertexIdx, INVALID_NODE));
 		}
 	}
+
+	// all found vertices in ascending costs order
+	const uint32 vertexCount = (uint32) mVertices.size();
+	for (uint32 localVertexIdx = 0; localVertexIdx < vertexCount; ++localVertexIdx)
+		mOrder.push_back(localVertexIdx);
+
+	sort(mOrder.begin(), mOrder.end(), MeshDijkstra::Comparer(*this));
+	reverse(mOrder.begin(), mOrder.end());
 }
 
-void MeshDijkstra::processNeighbor(const uint32 sourceLocalIdx, const uint32 targetGlobalIdx,
+void MeshDijkstra::processNeighbor(const uint32 sourceLocalIdx, const uint32 targetGlobalIdx, const uint32 neighborSlot,
 	const Vector3 &referenceNormal, const Vector3 *positions)
 {
 	// get next best ranged vertex and the costs between it and vertex targetGlobalIdx
 	const RangedVertexIdx &source = mVertices.at(sourceLocalIdx);
-	Vector3 n, pSource, pTarget;
-	if (!getStepGeometry(n, pSource, pTarget, positions, source.getGlobalVertexIdx(), targetGlobalIdx))
+	Vector3 n;
+	Real length;
+	if (mSteps)
+	{
+		// precomputed step geometry
+		const Step &step = mSteps[neighborSlot];
+		if (!step.isValid())
+			return;
+
+		n = step.mNormal;
+		length = step.mLength;
+	}
+	else if (!getStepGeometry(n, length, *mMesh, mTriangleNormals, positions, source.getGlobalVertexIdx(), targetGlobalIdx))
+	{
 		return;
+	}
 
 	// was targetGlobalIdx already processed or is it new?
 	const uint32 targetLocalIdx = (uint32) mVertices.size();
@@ -95,7 +198,7 @@ void MeshDijkstra::processNeighbor(const uint32 sourceLocalIdx, const uint32 tar
 	if (result.second)
 	{
 		// create ranged vertex index
-		const RangedVertexIdx rangedVertexIdx(source.getCosts(), referenceNormal, n, pSource, pTarget,
+		const RangedVertexIdx rangedVertexIdx(source.getCosts(), referenceNormal, n, length,
 			targetGlobalIdx, sourceLocalIdx, mMaxAngleDifference, mAngularCostsFactor);
 
 		mVertices.push_back(rangedVertexIdx);
@@ -110,7 +213,7 @@ void MeshDijkstra::processNeighbor(const uint32 sourceLocalIdx, const uint32 tar
 		return; 
 	
 	// neighbor must be in the working set since its costs are larger than source's costs
-	const Real deltaCosts = RangedVertexIdx::getDeltaCosts(referenceNormal, n, pSource, pTarget, mMaxAngleDifference, mAngularCostsFactor);
+	const Real deltaCosts = RangedVertexIdx::getDeltaCosts(referenceNormal, n, length, mMaxAngleDifference, mAngularCostsFactor);
 	if (REAL_MAX == deltaCosts || isNaN(deltaCosts))
 		return;
 	
@@ -125,29 +228,28 @@ void MeshDijkstra::processNeighbor(const uint32 sourceLocalIdx, const uint32 tar
 	make_heap(mWorkingSet.begin(), mWorkingSet.end(), MeshDijkstra::Comparer(*this));
 }
 
-bool MeshDijkstra::getStepGeometry(Vector3 &n, Vector3 &p0, Vector3 &p1,
-	const Vector3 *positions, const uint32 v0Idx, const uint32 v1Idx) const
+bool MeshDijkstra::getStepGeometry(Vector3 &n, Real &length, const FlexibleMesh &mesh, const Vector3 *triangleNormals,
+	const Vector3 *positions, const uint32 v0Idx, const uint32 v1Idx)
 {
 	// edge exists?
-	const uint32 edgeIdx = mMesh->getEdgeIndex(v0Idx, v1Idx);
+	const uint32 edgeIdx = mesh.getEdgeIndex(v0Idx, v1Idx);
 	if (Edge::INVALID_IDX == edgeIdx)
 		return false;
 
 	// get & check edge triangles
-	const Edge &edge = mMesh->getEdges()[edgeIdx];
+	const Edge &edge = mesh.getEdges()[edgeIdx];
 	const uint32 *triangles = edge.getTriangleIndices();
 	if (Triangle::INVALID_IDX == triangles[0] || Triangle::INVALID_IDX == triangles[1])
 		return false;
 
 	// get adjacent triangle normals
-	const Vector3 &n0 = mTriangleNormals[triangles[0]];
-	const Vector3 &n1 = mTriangleNormals[triangles[1]];
+	const Vector3 &n0 = triangleNormals[triangles[0]];
+	const Vector3 &n1 = triangleNormals[triangles[1]];
 	
-	// set normal & positions
+	// set normal & length
 	n = n0 + n1;
 	n.normalize();
-	p0 = positions[v0Idx];
-	p1 = positions[v1Idx];
+	length = (positions[v0Idx] - positions[v1Idx]).getLength();
 	return true;
 }
 
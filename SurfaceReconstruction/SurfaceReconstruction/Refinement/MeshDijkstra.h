@@ -35,17 +35,55 @@ namespace SurfaceReconstruction
 			const MeshDijkstra &mDijkstra;
 		};
 
+		/// Precomputed geometry of the step from a vertex to one of its direct neighbors, see computeSteps.
+		struct Step
+		{
+		public:
+			inline bool isValid() const;
+
+		public:
+			Math::Vector3 mNormal;	/// Normalized sum of the normals of both triangles of the step edge.
+			Real mLength;			/// Euclidean length of the step edge or a negative value for border edges which are never traversed.
+		};
+
+	public:
+		/** Precomputes the geometry of all steps between direct vertex neighbors for searches on a static mesh.
+			The steps are stored in the same order as the vertex neighbors so that searches look them up without edge queries.
+		@param steps Is resized & set so that steps[i] belongs to the step from vertex v to vertexNeighbors[i] with
+			vertexNeighborsOffsets[v] <= i < vertexNeighborsOffsets[v + 1]. It is only valid until the mesh changes.
+		@param triangleNormals Set this to the current normals of all mesh triangles.
+		@param vertexNeighbors Set this to the direct neighbors of all vertices, see FlexibleMesh::getVertexNeighbors.
+		@param vertexNeighborsOffsets Set this to the neighbor offsets of all vertices, see FlexibleMesh::getVertexNeighbors. */
+		static void computeSteps(std::vector<Step> &steps, const FlexibleMesh &mesh, const Math::Vector3 *triangleNormals,
+			const uint32 *vertexNeighbors, const uint32 *vertexNeighborsOffsets);
+
 	public:
 		MeshDijkstra();
+
+		/** Fills this object as if findVertices had been called for the entered start vertices but reuses already finished single source searches.
+			This is exact if the searches in startNeighborhoods were started with referenceNormal as reference and start normal and a range of at least maxCosts.
+		@param startNeighborhoods Set this to the reached vertices of one single source search for each start vertex.
+			The costs of each RangedVertexIdx must be relative to the corresponding start vertex. */
+		void combineNeighborhoods(const FlexibleMesh *mesh,
+			const Math::Vector3 &referenceNormal, const Math::Vector3 &referencePosition,
+			const uint32 *startVertices, const std::vector<RangedVertexIdx> *startNeighborhoods, const uint32 startVertexCount,
+			const Real maxCosts, const Real maxAngleDifference, const Real angularCostsFactor);
+
 		inline void findVertices(const FlexibleMesh *mesh, const Math::Vector3 *triangleNormals,
 			const uint32 *vertexNeighbors, const uint32 *vertexNeighborsOffsets,
 			const Surfel &startSurfel, const uint32 *startTriangle,
-			const Real maxCosts, const MeshDijkstraParameters &params);
+			const Real maxCosts, const MeshDijkstraParameters &params, const Step *steps = NULL);
+
+		/** Finds all vertices within the range maxCosts around the start vertices.
+		@param steps Set this to NULL to compute the step geometry on the fly or to steps created by computeSteps for the current mesh state. */
 		void findVertices(const FlexibleMesh *mesh, const Math::Vector3 *triangleNormals,
 			const uint32 *vertexNeighbors, const uint32 *vertexNeighborsOffsets,
 			const Math::Vector3 &referenceNormal, const Math::Vector3 &referencePosition,
 			const Math::Vector3 *startNormals, const uint32 *startVertices, const uint32 startVertexCount,
-			const Real maxCosts, const Real maxAngleDifference, const Real angularCostsFactor);
+			const Real maxCosts, const Real maxAngleDifference, const Real angularCostsFactor, const Step *steps = NULL);
+
+		/** Returns the number of vertices which were settled by all findVertices calls of this object so far. */
+		inline uint64 getExpansionCount() const;
 
 		inline const std::vector<uint32> &getOrder() const;
 		inline std::vector<RangedVertexIdx> &getVertices();
@@ -59,10 +97,12 @@ namespace SurfaceReconstruction
 			const Math::Vector3 &referenceNormal, const Math::Vector3 &referencePosition);
 		void clear();
 
-		bool getStepGeometry(Math::Vector3 &n, Math::Vector3 &p0, Math::Vector3 &p1,
-			const Math::Vector3 *positions, const uint32 v0Idx, const uint32 v1Idx) const;
+		/** Computes the geometry of the step from vertex v0Idx to vertex v1Idx.
+		@return Returns false if there is no such edge or if it is a border edge. */
+		static bool getStepGeometry(Math::Vector3 &n, Real &length, const FlexibleMesh &mesh, const Math::Vector3 *triangleNormals,
+			const Math::Vector3 *positions, const uint32 v0Idx, const uint32 v1Idx);
 
-		void processNeighbor(const uint32 bestLocalIdx, const uint32 globalNeighborIdx,
+		void processNeighbor(const uint32 bestLocalIdx, const uint32 globalNeighborIdx, const uint32 neighborSlot,
 			const Math::Vector3 &referenceNormal, const Math::Vector3 *positions);
 
 	public:
@@ -74,6 +114,7 @@ namespace SurfaceReconstruction
 		std::vector<RangedVertexIdx> mVertices;		/// global vertex index and costs w.r.t. the start in random order
 		std::map<uint32, uint32> mVisitedVertices;	/// first = key = global vertex index which must be unique, second = value = index w.r.t. mVertices
 		std::vector<uint32> mWorkingSet;			/// indices w.r.t. mVertices, in ascending costs order, at border of search region -> first one = lowest costs = next best one
+		uint64 mExpansionCount;						/// number of vertices settled by all searches (for profiling)
 
 		// search config data
 		Real mAngularCostsFactor;
@@ -85,6 +126,7 @@ namespace SurfaceReconstruction
 		const Math::Vector3 *mTriangleNormals;
 		const uint32 *mVertexNeighborsOffsets;	/// mVertexNeighbors[i] starts at mVertexNeighborsOffsets[i] and ends at (exclusive) mVertexNeighborsOffsets[i + 1];
 		const uint32 *mVertexNeighbors;			/// mVertexNeighbors[i] contains the global direct vertex neighbor indices of vertex i
+		const Step *mSteps;						/// NULL or precomputed geometry for each entry of mVertexNeighbors
 	};
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -102,6 +144,11 @@ namespace SurfaceReconstruction
 		return mDijkstra.mVertices.at(leftLocalIdx).getCosts() > mDijkstra.mVertices.at(rightLocalIdx).getCosts();
 	}
 
+	inline bool MeshDijkstra::Step::isValid() const
+	{
+		return mLength >= 0.0f;
+	}
+
 	void MeshDijkstra::addToWorkingSet(const uint32 localVertexIdx)
 	{
 		const Real costs = mVertices.at(localVertexIdx).getCosts();
@@ -115,7 +162,7 @@ namespace SurfaceReconstruction
 	inline void MeshDijkstra::findVertices(const FlexibleMesh *mesh, const Math::Vector3 *triangleNormals,
 		const uint32 *vertexNeighbors, const uint32 *vertexNeighborsOffsets,
 		const Surfel &startSurfel, const uint32 *startTriangle,
-		const Real maxCosts, const MeshDijkstraParameters &params)
+		const Real maxCosts, const MeshDijkstraParameters &params, const Step *steps)
 	{
 		const uint32 count = 3;
 		const Math::Vector3 startNormals[count] = { startSurfel.mNormal, startSurfel.mNormal, startSurfel.mNormal };
@@ -123,7 +170,12 @@ namespace SurfaceReconstruction
 		findVertices(mesh, triangleNormals,	vertexNeighbors, vertexNeighborsOffsets,
 			startSurfel.mNormal, startSurfel.mPosition,
 			startNormals, startTriangle, count,
-			maxCosts, params.getMaxAngleDifference(), params.getAngularCostsFactor());
+			maxCosts, params.getMaxAngleDifference(), params.getAngularCostsFactor(), steps);
+	}
+
+	inline uint64 MeshDijkstra::getExpansionCount() const
+	{
+		return mExpansionCount;
 	}
 
 	inline const std::vector<uint32> &MeshDijkstra::getOrder() const
@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+
+#include "Math/MathHelper.h"
+#include "SurfaceReconstruction/Geometry/FlexibleMesh.h"
+#include "SurfaceReconstruction/Refinement/MeshDijkstra.h"
+#include "SurfaceReconstruction/Refinement/MeshDijkstraCache.h"
+
+using namespace Math;
+using namespace std;
+using namespace SurfaceReconstruction;
+
+const Real MeshDijkstraCache::BUCKETS_PER_OCTAVE = 4.0f;
+
+MeshDijkstraCache::MeshDijkstraCache() :
+	mNeighborhoods(NULL), mRequestCounts(NULL), mByteCount(0), mNeighborhoodCount(0), mMaxByteCount(0), mTriangleCount(0),
+	mMesh(NULL), mTriangleNormals(NULL), mVertexNeighbors(NULL), mVertexNeighborsOffsets(NULL), mSteps(NULL)
+{
+
+}
+
+MeshDijkstraCache::~MeshDijkstraCache()
+{
+	clear();
+}
+
+void MeshDijkstraCache::clear()
+{
+	// free neighborhoods
+	if (mNeighborhoods)
+	{
+		#pragma omp parallel for
+		for (int64 triangleIdx = 0; triangleIdx < mTriangleCount; ++triangleIdx)
+		{
+			Neighborhood *neighborhood = mNeighborhoods[triangleIdx];
+			while (neighborhood)
+			{
+				Neighborhood *next = neighborhood->mNext;
+				delete neighborhood;
+				neighborhood = next;
+			}
+		}
+	}
+
+	delete [] mNeighborhoods;
+	mNeighborhoods = NULL;
+
+	delete [] mRequestCounts;
+	mRequestCounts = NULL;
+
+	mByteCount = 0;
+	mNeighborhoodCount = 0;
+	mTriangleCount = 0;
+
+	mMesh = NULL;
+	mTriangleNormals = NULL;
+	mVertexNeighbors = NULL;
+	mVertexNeighborsOffsets = NULL;
+	mSteps = NULL;
+}
+
+void MeshDijkstraCache::reset(const FlexibleMesh *mesh, const Vector3 *triangleNormals,
+	const uint32 *vertexNeighbors, const uint32 *vertexNeighborsOffsets, const uint64 maxByteCount,
+	const MeshDijkstra::Step *steps)
+{
+	clear();
+
+	// mesh data
+	mMesh = mesh;
+	mTriangleNormals = triangleNormals;
+	mVertexNeighbors = vertexNeighbors;
+	mVertexNeighborsOffsets = vertexNeighborsOffsets;
+	mSteps = steps;
+	mMaxByteCount = maxByteCount;
+
+	// empty neighborhood lists & zero requests for each triangle
+	mTriangleCount = mMesh->getTriangleCount();
+	mNeighborhoods = new atomic<Neighborhood *>[mTriangleCount];
+	mRequestCounts = new atomic<uint32>[mTriangleCount];
+
+	#pragma omp parallel for
+	for (int64 triangleIdx = 0; triangleIdx < mTriangleCount; ++triangleIdx)
+	{
+		mNeighborhoods[triangleIdx] = NULL;
+		mRequestCounts[triangleIdx] = 0;
+	}
+}
+
+bool MeshDijkstraCache::findVertices(MeshDijkstra &dijkstra, const Surfel &startSurfel, const Real maxCosts, const MeshDijkstraParameters &params)
+{
+	// only reuse searches for triangles which are requested more than once
+	const uint32 triangleIdx = startSurfel.mTriangleIdx;
+	const uint32 previousRequests = mRequestCounts[triangleIdx]++;
+	if (0 == previousRequests)
+		return false;
+
+	// get or create a cached neighborhood which is at least as large as the required one
+	const int32 bucket = getBucket(maxCosts);
+	const Neighborhood *neighborhood = findNeighborhood(triangleIdx, bucket);
+	if (!neighborhood)
+		neighborhood = createNeighborhood(dijkstra, startSurfel, bucket, params);
+	if (!neighborhood)
+		return false;
+
+	// search from startSurfel = combination of the searches starting at the triangle corners
+	const uint32 *triangle = mMesh->getTriangle(triangleIdx);
+	dijkstra.combineNeighborhoods(mMesh, startSurfel.mNormal, startSurfel.mPosition,
+		triangle, neighborhood->mCorners, 3,
+		maxCosts, params.getMaxAngleDifference(), params.getAngularCostsFactor());
+	return true;
+}
+
+MeshDijkstraCache::Neighborhood *MeshDijkstraCache::findNeighborhood(const uint32 triangleIdx, const int32 bucket) const
+{
+	for (Neighborhood *neighborhood = mNeighborhoods[triangleIdx]; neighborhood; neighborhood = neighborhood->mNext)
+		if (neighborhood->mBucket == bucket)
+			return neighborhood;
+
+	return NULL;
+}
+
+MeshDijkstraCache::Neighborhood *MeshDijkstraCache::createNeighborhood(MeshDijkstra &dijkstra,
+	const Surfel &startSurfel, const int32 bucket, const MeshDijkstraParameters &params)
+{
+	// enough memory left?
+	if (mByteCount >= mMaxByteCount)
+		return NULL;
+
+	// search data
+	const uint32 triangleIdx = startSurfel.mTriangleIdx;
+	const uint32 *triangle = mMesh->getTriangle(triangleIdx);
+	const Vector3 *positions = mMesh->getPositions();
+	const Real radius = getBucketRadius(bucket);
+	const Vector3 &referenceNormal = startSurfel.mNormal;
+
+	// single source searches from each triangle corner with the same reference normal as for any hit of the triangle
+	Neighborhood *neighborhood = new Neighborhood();
+	uint64 byteCount = sizeof(Neighborhood);
+
+	for (uint32 cornerIdx = 0; cornerIdx < 3; ++cornerIdx)
+	{
+		const uint32 cornerVertexIdx = triangle[cornerIdx];
+		dijkstra.findVertices(mMesh, mTriangleNormals, mVertexNeighbors, mVertexNeighborsOffsets,
+			referenceNormal, positions[cornerVertexIdx],
+			&referenceNormal, &cornerVertexIdx, 1,
+			radius, params.getMaxAngleDifference(), params.getAngularCostsFactor(), mSteps);
+
+		// only keep the vertices which were reached
+		const vector<RangedVertexIdx> &vertices = dijkstra.getVertices();
+		const vector<uint32> &order = dijkstra.getOrder();
+		const uint32 reachedCount = (uint32) order.size();
+
+		vector<RangedVertexIdx> &corner = neighborhood->mCorners[cornerIdx];
+		corner.reserve(reachedCount);
+		for (uint32 orderIdx = 0; orderIdx < reachedCount; ++orderIdx)
+		{
+			const RangedVertexIdx &reached = vertices[order[orderIdx]];
+			corner.push_back(RangedVertexIdx(reached.getCosts(), reached.getGlobalVertexIdx(), MeshDijkstra::INVALID_NODE));
+		}
+
+		byteCount += sizeof(RangedVertexIdx) * reachedCount;
+	}
+	neighborhood->mBucket = bucket;
+
+	// insert it as new list head without locking
+	atomic<Neighborhood *> &head = mNeighborhoods[triangleIdx];
+	Neighborhood *oldHead = head.load();
+	do
+	{
+		neighborhood->mNext = oldHead;
+	}
+	while (!head.compare_exchange_weak(oldHead, neighborhood));
+
+	mByteCount += byteCount;
+	++mNeighborhoodCount;
+	return neighborhood;
+}
+
+int32 MeshDijkstraCache::getBucket(const Real maxCosts)
+{
+	// round up to the next bucket radius
+	const Real octaves = logr(maxCosts) / logr(2.0f);
+	return (int32) ceilr(octaves * BUCKETS_PER_OCTAVE);
+}
+
+Real MeshDijkstraCache::getBucketRadius(const int32 bucket)
+{
+	// slightly enlarged to be robust against rounding errors of getBucket
+	const Real octaves = bucket / BUCKETS_PER_OCTAVE;
+	return expr(octaves * logr(2.0f)) * 1.001f;
+}
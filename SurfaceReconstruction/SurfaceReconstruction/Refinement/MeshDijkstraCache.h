@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+
+#ifndef _MESH_DIJKSTRA_CACHE_H_
+#define _MESH_DIJKSTRA_CACHE_H_
+
+#include <atomic>
+#include <cassert>
+#include <vector>
+#include "SurfaceReconstruction/Geometry/Surfel.h"
+#include "SurfaceReconstruction/Refinement/MeshDijkstra.h"
+#include "SurfaceReconstruction/Refinement/MeshDijkstraParameters.h"
+#include "SurfaceReconstruction/Refinement/RangedVertexIdx.h"
+
+namespace SurfaceReconstruction
+{
+	class FlexibleMesh;
+
+	/** Caches bounded geodesic neighborhoods of mesh triangles for many MeshDijkstra queries on a static mesh.
+		For each requested pair of triangle and radius bucket, it stores the results of single source searches starting at the three triangle corners.
+		Since the surfel of a ray hit always has the normal of the hit triangle, a search from any start point within that triangle is then
+		exactly the combination of these corner searches, offset by the start point costs of each corner. (See MeshDijkstra::combineNeighborhoods.)
+		The cache is only valid as long as the mesh is not changed, e.g., within one kernel interpolation of an FSSF iteration. */
+	class MeshDijkstraCache
+	{
+	public:
+		MeshDijkstraCache();
+		~MeshDijkstraCache();
+
+		/** Frees all cached neighborhoods. */
+		void clear();
+
+		/** Finds all vertices within the range maxCosts around startSurfel like MeshDijkstra::findVertices but reuses cached searches.
+		@param dijkstra Is filled with the found vertices and also used as scratch memory to create missing cached neighborhoods.
+		@return Returns false if there was no cached neighborhood which could be used or created. dijkstra is left in an undefined state then. */
+		bool findVertices(MeshDijkstra &dijkstra, const Surfel &startSurfel, const Real maxCosts, const MeshDijkstraParameters &params);
+
+		inline uint64 getByteCount() const;
+		inline uint32 getNeighborhoodCount() const;
+
+		/** Releases all previously cached neighborhoods and prepares the cache for the entered static mesh.
+		@param maxByteCount Neighborhoods are only created as long as the cache does not use more memory than this.
+		@param steps Set this to NULL or to the precomputed step geometry of the mesh, see MeshDijkstra::computeSteps. */
+		void reset(const FlexibleMesh *mesh, const Math::Vector3 *triangleNormals,
+			const uint32 *vertexNeighbors, const uint32 *vertexNeighborsOffsets, const uint64 maxByteCount,
+			const MeshDijkstra::Step *steps = NULL);
+
+	private:
+		struct Neighborhood
+		{
+		public:
+			std::vector<RangedVertexIdx> mCorners[3];	/// For each triangle corner: vertices and costs w.r.t. a search starting at the corner.
+			Neighborhood *mNext;						/// Next neighborhood of the same triangle but for a different radius bucket.
+			int32 mBucket;								/// Identifies the search radius which was used to create this neighborhood.
+		};
+
+	private:
+		static int32 getBucket(const Real maxCosts);
+		static Real getBucketRadius(const int32 bucket);
+
+	private:
+		MeshDijkstraCache(const MeshDijkstraCache &copy);
+		inline MeshDijkstraCache &operator =(const MeshDijkstraCache &rhs);
+
+		Neighborhood *createNeighborhood(MeshDijkstra &dijkstra, const Surfel &startSurfel, const int32 bucket, const MeshDijkstraParameters &params);
+		Neighborhood *findNeighborhood(const uint32 triangleIdx, const int32 bucket) const;
+
+	public:
+		static const Real BUCKETS_PER_OCTAVE;	/// Radii are rounded up to the next bucket radius whereas there are this many buckets between radius r and 2r.
+
+	private:
+		std::atomic<Neighborhood *> *mNeighborhoods;	/// For each triangle: list of cached neighborhoods, one per radius bucket.
+		std::atomic<uint32> *mRequestCounts;			/// For each triangle: number of requests. Neighborhoods are only created for triangles which are hit more than once.
+		std::atomic<uint64> mByteCount;
+		std::atomic<uint32> mNeighborhoodCount;
+		uint64 mMaxByteCount;
+		uint32 mTriangleCount;
+
+		// mesh data
+		const FlexibleMesh *mMesh;
+		const Math::Vector3 *mTriangleNormals;
+		const uint32 *mVertexNeighbors;
+		const uint32 *mVertexNeighborsOffsets;
+		const MeshDijkstra::Step *mSteps;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	///   inline function definitions   ////////////////////////////////////////////////////////////////////////////////////
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	inline uint64 MeshDijkstraCache::getByteCount() const
+	{
+		return mByteCount;
+	}
+
+	inline uint32 MeshDijkstraCache::getNeighborhoodCount() const
+	{
+		return mNeighborhoodCount;
+	}
+
+	inline MeshDijkstraCache &MeshDijkstraCache::operator =(const MeshDijkstraCache &rhs)
+	{
+		assert(false);
+		return *this;
+	}
+}
+
+#endif // _MESH_DIJKSTRA_CACHE_H_
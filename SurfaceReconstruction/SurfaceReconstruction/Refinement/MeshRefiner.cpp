@@ -144,6 +144,15 @@ void MeshRefiner::onNewElements(
 	mWeightField.resize(newVertexCount, 0.0f);
 }
 
+void MeshRefiner::onReorderData(
+	const uint32 *vertexOrder, const uint32 vertexCount,
+	const uint32 *edgeOrder, const uint32 edgeCount,
+	const uint32 *triangleOrder, const uint32 triangleCount)
+{
+	FlexibleMesh::reorderData<Vector3>(mVectorField, vertexOrder);
+	FlexibleMesh::reorderData<Real>(mWeightField, vertexOrder);
+}
+
 void MeshRefiner::resize(const uint32 vertexCount)
 {
 	mVectorField.resize(vertexCount);
@@ -54,6 +54,11 @@ namespace SurfaceReconstruction
 			const uint32 firstNewEdge, const uint32 newEdgeCount,
 			const uint32 firstNewTriangle, const uint32 newTriangleCount);
 
+		virtual void onReorderData(
+			const uint32 *vertexOrder, const uint32 vertexCount,
+			const uint32 *edgeOrder, const uint32 edgeCount,
+			const uint32 *triangleOrder, const uint32 triangleCount);
+
 		virtual void onReserveMemory(const uint32 vertexCapacity, const uint32 edgeCapacity, const uint32 indexCapacity);
 
 	protected:
@@ -25,10 +25,12 @@ namespace SurfaceReconstruction
 			const Real maxAngleDifference, const Real angularCostsFactor);
 		static inline Real getDeltaCosts(const Math::Vector3 &n0, const Math::Vector3 &n1, const Math::Vector3 &p0, const Math::Vector3 &p1,
 			const Real maxAngleDifference, const Real angularCostsFactor);
+		static inline Real getDeltaCosts(const Math::Vector3 &n0, const Math::Vector3 &n1, const Real distance,
+			const Real maxAngleDifference, const Real angularCostsFactor);
 
 	public:
 		inline RangedVertexIdx(const Real previousCosts, const Math::Vector3 &n0, const Math::Vector3 &n1, 
-			const Math::Vector3 &p0, const Math::Vector3 &p1, const uint32 globalVertexIdx, const uint32 localPredecessorIdx,
+			const Real distance, const uint32 globalVertexIdx, const uint32 localPredecessorIdx,
 			const Real maxAngleDifference, const Real angularCostsFactor);
 		inline RangedVertexIdx(const Real costs, const uint32 globalVertexIdx, const uint32 localPredecessorIdx);
 		
@@ -103,10 +105,23 @@ namespace SurfaceReconstruction
 		return distance * f;
 	}
 
+	inline Real RangedVertexIdx::getDeltaCosts(
+		const Math::Vector3 &n0, const Math::Vector3 &n1, const Real distance,
+		const Real maxAngleDifference, const Real angularCostsFactor)
+	{
+		// angular costs factor
+		const Real f = getAngularCostsFactor(n0, n1, maxAngleDifference, angularCostsFactor);
+		if (REAL_MAX == f)
+			return REAL_MAX;
+
+		// scaled precomputed Euclidean costs
+		return distance * f;
+	}
+
 	inline RangedVertexIdx::RangedVertexIdx(const Real previousCosts, const Math::Vector3 &n0, const Math::Vector3 &n1, 
-		const Math::Vector3 &p0, const Math::Vector3 &p1, const uint32 globalVertexIdx, const uint32 localPredecessorIdx,
+		const Real distance, const uint32 globalVertexIdx, const uint32 localPredecessorIdx,
 		const Real maxAngleDifference, const Real angularCostsFactor) :
-			RangedVertexIdx(previousCosts + getDeltaCosts(n0, n1, p0, p1, maxAngleDifference, angularCostsFactor),
+			RangedVertexIdx(previousCosts + getDeltaCosts(n0, n1, distance, maxAngleDifference, angularCostsFactor),
 				globalVertexIdx, localPredecessorIdx)
 	{
 
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+
+#include <exception>
+#include <iostream>
+#include "Platform/FailureHandling/Exception.h"
+#include "SurfaceReconstruction/Geometry/Mesh.h"
+#include "SurfaceReconstruction/Scene/AsyncMeshWriter.h"
+
+using namespace FailureHandling;
+using namespace std;
+using namespace Storage;
+using namespace SurfaceReconstruction;
+
+void AsyncMeshWriter::save(Mesh *snapshot, const Path &fileNameBeginning, const bool saveAsPly, const bool saveAsMesh)
+{
+	// background writing?
+	if (AsyncMeshWriter::exists())
+	{
+		AsyncMeshWriter::getSingleton().enqueue(snapshot, fileNameBeginning, saveAsPly, saveAsMesh);
+		return;
+	}
+
+	// synchronous writing
+	Snapshot s;
+	s.mFileNameBeginning = fileNameBeginning;
+	s.mMesh = snapshot;
+	s.mSaveAsPly = saveAsPly;
+	s.mSaveAsMesh = saveAsMesh;
+	saveSnapshot(s);
+}
+
+AsyncMeshWriter::AsyncMeshWriter(const uint32 maxPendingSnapshots) :
+	mMaxPendingSnapshots(maxPendingSnapshots > 0 ? maxPendingSnapshots : 1), mPendingCount(0), mStopping(false)
+{
+	mThread = thread(&AsyncMeshWriter::run, this);
+}
+
+AsyncMeshWriter::~AsyncMeshWriter()
+{
+	// write remaining snapshots & stop
+	{
+		lock_guard<mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mStateChange.notify_all();
+
+	if (mThread.joinable())
+		mThread.join();
+}
+
+void AsyncMeshWriter::enqueue(Mesh *snapshot, const Path &fileNameBeginning, const bool saveAsPly, const bool saveAsMesh)
+{
+	Snapshot s;
+	s.mFileNameBeginning = fileNameBeginning;
+	s.mMesh = snapshot;
+	s.mSaveAsPly = saveAsPly;
+	s.mSaveAsMesh = saveAsMesh;
+
+	// wait for a free slot to bound snapshot memory
+	{
+		unique_lock<mutex> lock(mMutex);
+		while (mPendingCount >= mMaxPendingSnapshots)
+			mStateChange.wait(lock);
+
+		mQueue.push_back(s);
+		++mPendingCount;
+	}
+	mStateChange.notify_all();
+}
+
+void AsyncMeshWriter::flush()
+{
+	unique_lock<mutex> lock(mMutex);
+	while (mPendingCount > 0)
+		mStateChange.wait(lock);
+}
+
+void AsyncMeshWriter::run()
+{
+	while (true)
+	{
+		// next snapshot or stop?
+		Snapshot s;
+		{
+			unique_lock<mutex> lock(mMutex);
+			while (mQueue.empty() && !mStopping)
+				mStateChange.wait(lock);
+			if (mQueue.empty())
+				return;
+
+			s = mQueue.front();
+			mQueue.pop_front();
+		}
+
+		// write without holding the lock
+		saveSnapshot(s);
+
+		// free the slot
+		{
+			lock_guard<mutex> lock(mMutex);
+			--mPendingCount;
+		}
+		mStateChange.notify_all();
+	}
+}
+
+void AsyncMeshWriter::saveSnapshot(Snapshot &snapshot)
+{
+	try
+	{
+		snapshot.mMesh->saveToFile(snapshot.mFileNameBeginning, snapshot.mSaveAsPly, snapshot.mSaveAsMesh);
+	}
+	catch (Exception &exception)
+	{
+		cerr << exception;
+	}
+	catch (std::exception &exception)
+	{
+		cerr << "Could not save mesh " << snapshot.mFileNameBeginning << ": " << exception.what() << endl;
+	}
+
+	delete snapshot.mMesh;
+	snapshot.mMesh = NULL;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+#ifndef _ASYNC_MESH_WRITER_H_
+#define _ASYNC_MESH_WRITER_H_
+
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "Patterns/Singleton.h"
+#include "Platform/DataTypes.h"
+#include "Platform/Storage/Path.h"
+
+namespace SurfaceReconstruction
+{
+	class Mesh;
+
+	/** Saves mesh snapshots with a background thread so that the reconstruction continues while files are written.
+		Callers hand over private copies of their meshes (snapshots) which the writer deletes after saving them.
+		The number of snapshots which are queued or being written is bounded. Saving blocks while this bound is reached
+		so that memory for snapshots does not grow without limit, e.g., 2 pending snapshots correspond to double buffering. */
+	class AsyncMeshWriter : public Patterns::Singleton<AsyncMeshWriter>
+	{
+	public:
+		/** Saves snapshot via the AsyncMeshWriter object if there is one and synchronously otherwise. Parameters are the ones of Mesh::saveToFile.
+		@param snapshot Set this to a mesh copy allocated via new. Ownership is transferred and snapshot is deleted after saving it. */
+		static void save(Mesh *snapshot, const Storage::Path &fileNameBeginning, const bool saveAsPly, const bool saveAsMesh);
+
+	public:
+		/** Starts the writer thread.
+		@param maxPendingSnapshots Set this to the maximum number of snapshots which are queued or being written. Must be at least 1. */
+		explicit AsyncMeshWriter(const uint32 maxPendingSnapshots);
+
+		/** Saves all pending snapshots and stops the writer thread. */
+		~AsyncMeshWriter();
+
+		/** Queues snapshot for saving. Blocks while the maximum number of snapshots is pending. See save() for the parameters. */
+		void enqueue(Mesh *snapshot, const Storage::Path &fileNameBeginning, const bool saveAsPly, const bool saveAsMesh);
+
+		/** Blocks until all pending snapshots are saved, e.g., before saved files are read again. */
+		void flush();
+
+	private:
+		/// Mesh copy and where & how to save it.
+		struct Snapshot
+		{
+		public:
+			Storage::Path mFileNameBeginning;
+			Mesh *mMesh;
+			bool mSaveAsPly;
+			bool mSaveAsMesh;
+		};
+
+	private:
+		/** Copy constructor is forbidden. Don't use it. */
+		inline AsyncMeshWriter(const AsyncMeshWriter &other);
+
+		/** Assignment operator is forbidden. Don't use it.*/
+		inline AsyncMeshWriter &operator =(const AsyncMeshWriter &rhs);
+
+		/** Saves and frees queued snapshots until the writer is stopped and the queue is empty. Executed by mThread. */
+		void run();
+
+		/** Saves and frees snapshot. Errors are reported but not thrown. */
+		static void saveSnapshot(Snapshot &snapshot);
+
+	private:
+		std::deque<Snapshot> mQueue;			/// Snapshots which are not yet being written.
+		std::mutex mMutex;						/// Guards all members but mThread.
+		std::condition_variable mStateChange;	/// Signaled whenever a snapshot is queued or finished and when the writer is stopped.
+		std::thread mThread;					/// Background writer.
+		uint32 mMaxPendingSnapshots;			/// Upper bound of mPendingCount.
+		uint32 mPendingCount;					/// Number of queued snapshots and the one being written.
+		bool mStopping;							/// Set by the destructor to end the writer thread after the queue is empty.
+	};
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	///   inline function definitions   ////////////////////////////////////////////////////////////////////////////////////
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	inline AsyncMeshWriter::AsyncMeshWriter(const AsyncMeshWriter &other)
+	{
+		assert(false);
+	}
+
+	inline AsyncMeshWriter &AsyncMeshWriter::operator =(const AsyncMeshWriter &rhs)
+	{
+		assert(false);
+		return *this;
+	}
+}
+
+#endif // _ASYNC_MESH_WRITER_H_
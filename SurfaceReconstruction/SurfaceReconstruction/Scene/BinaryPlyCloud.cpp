@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include "Math/MathHelper.h"
+#include "Platform/FailureHandling/Exception.h"
+#include "SurfaceReconstruction/Scene/BinaryPlyCloud.h"
+#include "SurfaceReconstruction/Scene/MappedFile.h"
+
+using namespace FailureHandling;
+using namespace Math;
+using namespace std;
+using namespace Storage;
+using namespace SurfaceReconstruction;
+
+BinaryPlyCloud::BinaryPlyCloud(const Path &fileName) :
+	mFileName(fileName), mData(NULL), mByteCount(0), mVertices(NULL), mStride(0), mVertexCount(0), mSupported(false)
+{
+	try
+	{
+		mData = MappedFile::mapFile(mByteCount, fileName);
+	}
+	catch (Exception &exception)
+	{
+		cerr << exception;
+		return;
+	}
+
+	mSupported = parseHeader();
+}
+
+BinaryPlyCloud::~BinaryPlyCloud()
+{
+	MappedFile::unmapFile(mData, mByteCount);
+}
+
+bool BinaryPlyCloud::parseHeader()
+{
+	// find the end of the header
+	const char *text = (const char *) mData;
+	const string endMarker = "end_header";
+	uint64 headerEnd = 0;
+	for (uint64 charIdx = 0; charIdx + endMarker.size() < mByteCount; ++charIdx)
+	{
+		if (0 != memcmp(text + charIdx, endMarker.data(), endMarker.size()))
+			continue;
+
+		// skip the line ending
+		headerEnd = charIdx + endMarker.size();
+		if (headerEnd < mByteCount && '\r' == text[headerEnd])
+			++headerEnd;
+		if (headerEnd < mByteCount && '\n' == text[headerEnd])
+			++headerEnd;
+		break;
+	}
+	if (0 == headerEnd)
+		return false;
+
+	// parse all header lines
+	istringstream header(string(text, headerEnd));
+	string line;
+	bool isBinaryLittleEndian = false;
+	bool inVertexElement = false;
+	bool foundVertexElement = false;
+
+	while (getline(header, line))
+	{
+		istringstream words(line);
+		string keyword;
+		words >> keyword;
+
+		if ("format" == keyword)
+		{
+			string format;
+			words >> format;
+			isBinaryLittleEndian = ("binary_little_endian" == format);
+		}
+		else if ("element" == keyword)
+		{
+			// the vertex block must be the first block
+			string name;
+			uint64 count = 0;
+			words >> name >> count;
+
+			inVertexElement = ("vertex" == name && !foundVertexElement);
+			if (!foundVertexElement && !inVertexElement)
+				return false;
+			if (!inVertexElement)
+				continue;
+
+			if (count >= (uint32) -1)
+				return false;
+			mVertexCount = (uint32) count;
+			foundVertexElement = true;
+		}
+		else if ("property" == keyword && inVertexElement)
+		{
+			// only fixed size vertices
+			string typeName;
+			string name;
+			words >> typeName >> name;
+
+			Property property;
+			property.mOffset = mStride;
+			property.mType = getType(typeName);
+			if (PROPERTY_TYPE_INVALID == property.mType)
+				return false;
+
+			setProperty(name, property);
+			mStride += getTypeSize(property.mType);
+		}
+	}
+
+	// complete vertex block?
+	if (!isBinaryLittleEndian || !foundVertexElement || 0 == mStride)
+		return false;
+	if (headerEnd + ((uint64) mStride) * mVertexCount > mByteCount)
+		return false;
+
+	// all view IDs viewID0, viewID1, ... must be present
+	const uint32 viewsPerVertex = (uint32) mViewIDs.size();
+	for (uint32 viewIdx = 0; viewIdx < viewsPerVertex; ++viewIdx)
+		if (PROPERTY_TYPE_INVALID == mViewIDs[viewIdx].mType)
+			return false;
+
+	mVertices = mData + headerEnd;
+	return true;
+}
+
+void BinaryPlyCloud::setProperty(const string &name, const Property &property)
+{
+	if ("x" == name)
+		mPosition[0] = property;
+	else if ("y" == name)
+		mPosition[1] = property;
+	else if ("z" == name)
+		mPosition[2] = property;
+	else if ("nx" == name)
+		mNormal[0] = property;
+	else if ("ny" == name)
+		mNormal[1] = property;
+	else if ("nz" == name)
+		mNormal[2] = property;
+	else if ("red" == name || "r" == name || "diffuse_red" == name)
+		mColor[0] = property;
+	else if ("green" == name || "g" == name || "diffuse_green" == name)
+		mColor[1] = property;
+	else if ("blue" == name || "b" == name || "diffuse_blue" == name)
+		mColor[2] = property;
+	else if ("confidence" == name)
+		mConfidence = property;
+	else if ("value" == name || "scale" == name)
+		mScale = property;
+	else if (0 == name.compare(0, 6, "viewID") && name.size() > 6)
+	{
+		const uint32 viewIdx = (uint32) strtoul(name.c_str() + 6, NULL, 10);
+		if (viewIdx >= mViewIDs.size())
+			mViewIDs.resize(viewIdx + 1);
+		mViewIDs[viewIdx] = property;
+	}
+}
+
+void BinaryPlyCloud::getSample(Vector3 &color, Vector3 &normal, Vector3 &position, Real &confidence, Real &scale, uint32 *viewIDs,
+	const uint32 vertexIdx) const
+{
+	const uint8 *vertex = mVertices + ((uint64) mStride) * vertexIdx;
+
+	// vectors
+	readVector(color, vertex, mColor, true);
+	readVector(normal, vertex, mNormal, false);
+	readVector(position, vertex, mPosition, false);
+
+	// scalars
+	if (PROPERTY_TYPE_INVALID != mConfidence.mType)
+		confidence = read(vertex, mConfidence);
+	if (PROPERTY_TYPE_INVALID != mScale.mType)
+		scale = read(vertex, mScale);
+
+	// links to parent views
+	const uint32 viewsPerVertex = getViewsPerVertex();
+	for (uint32 viewIdx = 0; viewIdx < viewsPerVertex; ++viewIdx)
+		viewIDs[viewIdx] = readUInt32(vertex, mViewIDs[viewIdx]);
+}
+
+bool BinaryPlyCloud::hasValidConfidenceAndScale(const uint32 vertexIdx) const
+{
+	const uint8 *vertex = mVertices + ((uint64) mStride) * vertexIdx;
+
+	const Real confidence = (PROPERTY_TYPE_INVALID != mConfidence.mType ? read(vertex, mConfidence) : 1.0f);
+	if (Math::EPSILON >= confidence)
+		return false;
+
+	const Real scale = (PROPERTY_TYPE_INVALID != mScale.mType ? read(vertex, mScale) : 0.0f);
+	return (Math::EPSILON < scale);
+}
+
+Real BinaryPlyCloud::read(const uint8 *vertex, const Property &property) const
+{
+	// the host is expected to be little endian like the file
+	const uint8 *source = vertex + property.mOffset;
+	switch (property.mType)
+	{
+		case PROPERTY_TYPE_INT8:	{ int8 value;	memcpy(&value, source, sizeof(int8));	return (Real) value; }
+		case PROPERTY_TYPE_UINT8:	{ uint8 value;	memcpy(&value, source, sizeof(uint8));	return (Real) value; }
+		case PROPERTY_TYPE_INT16:	{ int16 value;	memcpy(&value, source, sizeof(int16));	return (Real) value; }
+		case PROPERTY_TYPE_UINT16:	{ uint16 value;	memcpy(&value, source, sizeof(uint16));	return (Real) value; }
+		case PROPERTY_TYPE_INT32:	{ int32 value;	memcpy(&value, source, sizeof(int32));	return (Real) value; }
+		case PROPERTY_TYPE_UINT32:	{ uint32 value;	memcpy(&value, source, sizeof(uint32));	return (Real) value; }
+		case PROPERTY_TYPE_FLOAT32:	{ float value;	memcpy(&value, source, sizeof(float));	return (Real) value; }
+		case PROPERTY_TYPE_FLOAT64:	{ double value;	memcpy(&value, source, sizeof(double));	return (Real) value; }
+
+		default:
+			assert(false);
+			return 0.0f;
+	}
+}
+
+uint32 BinaryPlyCloud::readUInt32(const uint8 *vertex, const Property &property) const
+{
+	const uint8 *source = vertex + property.mOffset;
+	switch (property.mType)
+	{
+		case PROPERTY_TYPE_INT8:	{ int8 value;	memcpy(&value, source, sizeof(int8));	return (uint32) (int32) value; }
+		case PROPERTY_TYPE_UINT8:	{ uint8 value;	memcpy(&value, source, sizeof(uint8));	return (uint32) value; }
+		case PROPERTY_TYPE_INT16:	{ int16 value;	memcpy(&value, source, sizeof(int16));	return (uint32) (int32) value; }
+		case PROPERTY_TYPE_UINT16:	{ uint16 value;	memcpy(&value, source, sizeof(uint16));	return (uint32) value; }
+		case PROPERTY_TYPE_INT32:	{ int32 value;	memcpy(&value, source, sizeof(int32));	return (uint32) value; }
+		case PROPERTY_TYPE_UINT32:	{ uint32 value;	memcpy(&value, source, sizeof(uint32));	return value; }
+
+		default:
+			return (uint32) (int32) read(vertex, property);
+	}
+}
+
+void BinaryPlyCloud::readVector(Vector3 &target, const uint8 *vertex, const Property properties[3], const bool isColor) const
+{
+	Real *coordinates[3] = { &target.x, &target.y, &target.z };
+	for (uint32 dim = 0; dim < 3; ++dim)
+	{
+		if (PROPERTY_TYPE_INVALID == properties[dim].mType)
+			continue;
+
+		if (isColor)
+			*coordinates[dim] = readColorChannel(vertex, properties[dim]);
+		else
+			*coordinates[dim] = read(vertex, properties[dim]);
+	}
+}
+
+Real BinaryPlyCloud::readColorChannel(const uint8 *vertex, const Property &property) const
+{
+	const Real value = read(vertex, property);
+	if (PROPERTY_TYPE_UINT8 == property.mType)
+		return value / 255.0f;
+	if (PROPERTY_TYPE_UINT16 == property.mType)
+		return value / 65535.0f;
+	return value;
+}
+
+BinaryPlyCloud::PropertyType BinaryPlyCloud::getType(const string &typeName)
+{
+	if ("char" == typeName || "int8" == typeName)
+		return PROPERTY_TYPE_INT8;
+	if ("uchar" == typeName || "uint8" == typeName)
+		return PROPERTY_TYPE_UINT8;
+	if ("short" == typeName || "int16" == typeName)
+		return PROPERTY_TYPE_INT16;
+	if ("ushort" == typeName || "uint16" == typeName)
+		return PROPERTY_TYPE_UINT16;
+	if ("int" == typeName || "int32" == typeName)
+		return PROPERTY_TYPE_INT32;
+	if ("uint" == typeName || "uint32" == typeName)
+		return PROPERTY_TYPE_UINT32;
+	if ("float" == typeName || "float32" == typeName)
+		return PROPERTY_TYPE_FLOAT32;
+	if ("double" == typeName || "float64" == typeName)
+		return PROPERTY_TYPE_FLOAT64;
+
+	// e.g., list properties
+	return PROPERTY_TYPE_INVALID;
+}
+
+uint32 BinaryPlyCloud::getTypeSize(const PropertyType type)
+{
+	switch (type)
+	{
+		case PROPERTY_TYPE_INT8:
+		case PROPERTY_TYPE_UINT8:
+			return 1;
+
+		case PROPERTY_TYPE_INT16:
+		case PROPERTY_TYPE_UINT16:
+			return 2;
+
+		case PROPERTY_TYPE_INT32:
+		case PROPERTY_TYPE_UINT32:
+		case PROPERTY_TYPE_FLOAT32:
+			return 4;
+
+		case PROPERTY_TYPE_FLOAT64:
+			return 8;
+
+		default:
+			assert(false);
+			return 0;
+	}
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+#ifndef _BINARY_PLY_CLOUD_H_
+#define _BINARY_PLY_CLOUD_H_
+
+#include <cassert>
+#include <string>
+#include <vector>
+#include "Math/Vector3.h"
+#include "Platform/DataTypes.h"
+#include "Platform/Storage/Path.h"
+
+namespace SurfaceReconstruction
+{
+	/** Memory mapped point cloud in the binary little endian ply format with a fixed vertex layout.
+		It allows random access to all vertices so that they can be decoded in parallel instead of property by property via Utilities::PlyFile.
+		Only clouds which start with the vertex element and have no list properties for vertices are supported.
+		(See isSupported.) Other files must be loaded via Utilities::PlyFile. */
+	class BinaryPlyCloud
+	{
+	public:
+		enum PropertyType
+		{
+			PROPERTY_TYPE_INT8,
+			PROPERTY_TYPE_UINT8,
+			PROPERTY_TYPE_INT16,
+			PROPERTY_TYPE_UINT16,
+			PROPERTY_TYPE_INT32,
+			PROPERTY_TYPE_UINT32,
+			PROPERTY_TYPE_FLOAT32,
+			PROPERTY_TYPE_FLOAT64,
+			PROPERTY_TYPE_COUNT,
+			PROPERTY_TYPE_INVALID = PROPERTY_TYPE_COUNT
+		};
+
+		/// Location of a vertex property within the memory of a single vertex.
+		struct Property
+		{
+		public:
+			inline Property();
+
+		public:
+			uint32 mOffset;			/// Number of bytes between the vertex start and this property.
+			PropertyType mType;		/// Data type of the property or PROPERTY_TYPE_INVALID if the file does not contain it.
+		};
+
+	public:
+		/** Maps fileName into memory and parses its ply header.
+		@param fileName Set this to the ply file with the point cloud to be loaded. */
+		explicit BinaryPlyCloud(const Storage::Path &fileName);
+
+		/** Unmaps the file. */
+		~BinaryPlyCloud();
+
+		/** Decodes all sample data of vertex vertexIdx. Only entries for which the file has properties are set.
+		@param viewIDs Set this to an array of getViewsPerVertex() entries which receive the vertex view IDs. */
+		void getSample(Math::Vector3 &color, Math::Vector3 &normal, Math::Vector3 &position, Real &confidence, Real &scale, uint32 *viewIDs,
+			const uint32 vertexIdx) const;
+
+		inline uint32 getVertexCount() const;
+		inline uint32 getViewsPerVertex() const;
+
+		/** Returns true if the vertex vertexIdx has a confidence and scale above zero like required for samples.
+			A missing confidence property is interpreted as confidence 1 and a missing scale property as scale 0. */
+		bool hasValidConfidenceAndScale(const uint32 vertexIdx) const;
+
+		/** Returns true if the file could be mapped, is in the binary little endian ply format and has a fixed vertex layout. */
+		inline bool isSupported() const;
+
+	private:
+		/** Copy constructor is forbidden. Don't use it. */
+		inline BinaryPlyCloud(const BinaryPlyCloud &other);
+
+		/** Assignment operator is forbidden. Don't use it.*/
+		inline BinaryPlyCloud &operator =(const BinaryPlyCloud &rhs);
+
+		static PropertyType getType(const std::string &typeName);
+		static uint32 getTypeSize(const PropertyType type);
+
+		/** Parses the ply header and returns true if the vertex layout is supported. */
+		bool parseHeader();
+
+		/** Returns the value of property of vertex vertex converted to Real. */
+		Real read(const uint8 *vertex, const Property &property) const;
+
+		/** Returns the value of property of vertex vertex converted to uint32 whereas negative values wrap around. */
+		uint32 readUInt32(const uint8 *vertex, const Property &property) const;
+
+		/** Returns the value of a color channel property normalized to [0, 1] if it is stored as unsigned integer. */
+		Real readColorChannel(const uint8 *vertex, const Property &property) const;
+
+		/** Reads the three coordinates of target from vertex if the file has the corresponding properties. Unsigned integer colors are normalized. */
+		void readVector(Math::Vector3 &target, const uint8 *vertex, const Property properties[3], const bool isColor) const;
+
+		/** Assigns the ply property name to the sample attribute it describes. Unknown names are ignored. */
+		void setProperty(const std::string &name, const Property &property);
+
+	private:
+		Storage::Path mFileName;
+		uint8 *mData;					/// Start of the mapped file.
+		uint64 mByteCount;				/// Size of the mapped file.
+		const uint8 *mVertices;			/// Start of the binary vertex block right after the header.
+
+		Property mColor[3];
+		Property mNormal[3];
+		Property mPosition[3];
+		Property mConfidence;
+		Property mScale;
+		std::vector<Property> mViewIDs;	/// Properties viewID0, viewID1, ... which link a vertex to its parent views.
+
+		uint32 mStride;					/// Number of bytes per vertex.
+		uint32 mVertexCount;
+		bool mSupported;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	///   inline function definitions   ////////////////////////////////////////////////////////////////////////////////////
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	inline BinaryPlyCloud::Property::Property() :
+		mOffset(0), mType(PROPERTY_TYPE_INVALID)
+	{
+
+	}
+
+	inline BinaryPlyCloud::BinaryPlyCloud(const BinaryPlyCloud &other)
+	{
+		assert(false);
+	}
+
+	inline BinaryPlyCloud &BinaryPlyCloud::operator =(const BinaryPlyCloud &rhs)
+	{
+		assert(false);
+		return *this;
+	}
+
+	inline uint32 BinaryPlyCloud::getVertexCount() const
+	{
+		return mVertexCount;
+	}
+
+	inline uint32 BinaryPlyCloud::getViewsPerVertex() const
+	{
+		return (uint32) mViewIDs.size();
+	}
+
+	inline bool BinaryPlyCloud::isSupported() const
+	{
+		return mSupported;
+	}
+}
+
+#endif // _BINARY_PLY_CLOUD_H_
@@ -7,6 +7,7 @@
  * of the BSD 3-Clause license. See the License.txt file for details.
  */
 
+#include <algorithm>
 #ifdef _DEBUG
 	#include <iostream>
 #endif // _DEBUG
@@ -18,6 +19,7 @@
 #include "Platform/MagicConstants.h"
 #include "Platform/ParametersManager.h"
 #include "SurfaceReconstruction/Image/Image.h"
+#include "SurfaceReconstruction/Scene/BinaryPlyCloud.h"
 #include "SurfaceReconstruction/Scene/CapturedScene.h"
 #include "SurfaceReconstruction/Scene/View.h"
 #include "Utilities/HelperFunctions.h"
@@ -32,6 +34,8 @@ using namespace Storage;
 using namespace SurfaceReconstruction;
 using namespace Utilities;
 
+const uint32 CapturedScene::PLY_VERTICES_BLOCK_SIZE = 0x1 << 14;
+
 CapturedScene::CapturedScene(const Path &metaFileName, const vector<IReconstructorObserver *> &observers) :
 	Scene(observers)
 {
@@ -229,10 +233,44 @@ void CapturedScene::loadViews(map<uint32, uint32> &oldToNewViewIDs, const Path &
 
 void CapturedScene::loadSampleClouds(const vector<Path> &plyCloudFileNames, const map<uint32, uint32> &oldToNewViewIDs)
 {
-	// load each point cloud
+	// load clouds in file order: consecutive supported binary clouds concurrently & all others via PlyFile
 	const uint32 fileCount = (uint32) plyCloudFileNames.size();
-	for (uint32 fileIdx = 0; fileIdx < fileCount; ++fileIdx)
-		loadSampleCloud(plyCloudFileNames[fileIdx]);
+	vector<BinaryPlyCloud *> binaryClouds;
+	vector<Path> binaryCloudFileNames;
+	binaryClouds.reserve(fileCount);
+
+	try
+	{
+		for (uint32 fileIdx = 0; fileIdx < fileCount; ++fileIdx)
+		{
+			// map the cloud & read its header (binaryClouds owns it from now on)
+			const Path &fileName = plyCloudFileNames[fileIdx];
+			BinaryPlyCloud *cloud = new BinaryPlyCloud(fileName);
+			binaryClouds.push_back(cloud);
+
+			// supported binary cloud with the same views per sample like all others?
+			const uint32 viewsPerSample = (mSamples ? mSamples->mViewsPerSample : binaryClouds[0]->getViewsPerVertex());
+			if (cloud->isSupported() && viewsPerSample == cloud->getViewsPerVertex())
+			{
+				binaryCloudFileNames.push_back(fileName);
+				continue;
+			}
+
+			// keep the cloud order: first the previous binary clouds & then this one via PlyFile
+			delete cloud;
+			binaryClouds.pop_back();
+			loadAndFreeBinaryPlyClouds(binaryClouds, binaryCloudFileNames);
+			loadSampleCloud(fileName);
+		}
+
+		// decode all remaining binary clouds concurrently into disjoint sample ranges
+		loadAndFreeBinaryPlyClouds(binaryClouds, binaryCloudFileNames);
+	}
+	catch (...)
+	{
+		freeBinaryPlyClouds(binaryClouds);
+		throw;
+	}
 
 	// transform samples
 	const uint32 sampleCount = mSamples->getCount();
@@ -331,6 +369,122 @@ uint32 CapturedScene::loadSamples(PlyFile &file, const Path &fileName, const Ver
 	return sampleCount;
 }
 
+void CapturedScene::loadBinaryPlyClouds(const vector<BinaryPlyCloud *> &clouds, const vector<Path> &fileNames)
+{
+	const uint32 cloudCount = (uint32) clouds.size();
+	if (!mSamples)
+		mSamples = new Samples(clouds[0]->getViewsPerVertex());
+
+	// vertex blocks of all clouds: cloud c has the blocks [cloudBlockStarts[c], cloudBlockStarts[c + 1])
+	const uint32 oldSampleCount = mSamples->getCount();
+	uint64 maxNewSampleCount = ((uint32) -1) - 1 - oldSampleCount;
+	vector<uint32> vertexCounts(cloudCount);
+	vector<uint64> cloudBlockStarts(cloudCount + 1, 0);
+
+	for (uint32 cloudIdx = 0; cloudIdx < cloudCount; ++cloudIdx)
+	{
+		cout << "Loading samples from " << fileNames[cloudIdx] << " (memory mapped binary cloud)." << endl;
+
+		// only up to 2^32 - 2 samples
+		const uint32 vertexCount = clouds[cloudIdx]->getVertexCount();
+		vertexCounts[cloudIdx] = (uint32) (vertexCount < maxNewSampleCount ? vertexCount : maxNewSampleCount);
+		maxNewSampleCount -= vertexCounts[cloudIdx];
+
+		const uint64 blockCount = (vertexCounts[cloudIdx] + PLY_VERTICES_BLOCK_SIZE - 1) / PLY_VERTICES_BLOCK_SIZE;
+		cloudBlockStarts[cloudIdx + 1] = cloudBlockStarts[cloudIdx] + blockCount;
+	}
+
+	// count valid vertices per block of all clouds
+	const int64 blockCount = cloudBlockStarts[cloudCount];
+	vector<uint32> blockOffsets(blockCount + 1, 0);
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int64 blockIdx = 0; blockIdx < blockCount; ++blockIdx)
+	{
+		uint32 cloudIdx;
+		uint32 start;
+		uint32 end;
+		getPlyVerticesBlock(cloudIdx, start, end, (uint64) blockIdx, cloudBlockStarts, vertexCounts);
+
+		const BinaryPlyCloud &cloud = *clouds[cloudIdx];
+		uint32 validCount = 0;
+		for (uint32 vertexIdx = start; vertexIdx < end; ++vertexIdx)
+			if (cloud.hasValidConfidenceAndScale(vertexIdx))
+				++validCount;
+		blockOffsets[blockIdx + 1] = validCount;
+	}
+
+	// exclusive prefix sum = first target sample of each block
+	for (int64 blockIdx = 0; blockIdx < blockCount; ++blockIdx)
+		blockOffsets[blockIdx + 1] += blockOffsets[blockIdx];
+
+	// create all new samples at once (default values for properties missing in the files)
+	const uint32 loadedSampleCount = blockOffsets[blockCount];
+	const uint32 viewsPerSample = mSamples->mViewsPerSample;
+	mSamples->resize(oldSampleCount + loadedSampleCount);
+
+	// decode valid vertices of all clouds directly into the compacted sample arrays
+	#pragma omp parallel for schedule(dynamic)
+	for (int64 blockIdx = 0; blockIdx < blockCount; ++blockIdx)
+	{
+		uint32 cloudIdx;
+		uint32 start;
+		uint32 end;
+		getPlyVerticesBlock(cloudIdx, start, end, (uint64) blockIdx, cloudBlockStarts, vertexCounts);
+
+		const BinaryPlyCloud &cloud = *clouds[cloudIdx];
+		uint32 sampleIdx = oldSampleCount + blockOffsets[blockIdx];
+		for (uint32 vertexIdx = start; vertexIdx < end; ++vertexIdx)
+		{
+			if (!cloud.hasValidConfidenceAndScale(vertexIdx))
+				continue;
+
+			cloud.getSample(mSamples->mColors[sampleIdx], mSamples->mNormals[sampleIdx], mSamples->mPositions[sampleIdx],
+				mSamples->mConfidences[sampleIdx], mSamples->mScales[sampleIdx],
+				mSamples->mParentViews.data() + viewsPerSample * (size_t) sampleIdx, vertexIdx);
+			++sampleIdx;
+		}
+	}
+
+	// output loaded samples per cloud
+	for (uint32 cloudIdx = 0; cloudIdx < cloudCount; ++cloudIdx)
+	{
+		const uint32 sampleCount = blockOffsets[cloudBlockStarts[cloudIdx + 1]] - blockOffsets[cloudBlockStarts[cloudIdx]];
+		cout << "Loaded " << sampleCount << " samples from " << fileNames[cloudIdx] << "." << endl;
+	}
+}
+
+void CapturedScene::loadAndFreeBinaryPlyClouds(vector<BinaryPlyCloud *> &clouds, vector<Path> &fileNames)
+{
+	if (!clouds.empty())
+		loadBinaryPlyClouds(clouds, fileNames);
+
+	freeBinaryPlyClouds(clouds);
+	fileNames.clear();
+}
+
+void CapturedScene::freeBinaryPlyClouds(vector<BinaryPlyCloud *> &clouds)
+{
+	const uint32 cloudCount = (uint32) clouds.size();
+	for (uint32 cloudIdx = 0; cloudIdx < cloudCount; ++cloudIdx)
+		delete clouds[cloudIdx];
+	clouds.clear();
+}
+
+void CapturedScene::getPlyVerticesBlock(uint32 &cloudIdx, uint32 &start, uint32 &end,
+	const uint64 blockIdx, const vector<uint64> &cloudBlockStarts, const vector<uint32> &vertexCounts)
+{
+	// find the cloud containing the block
+	cloudIdx = (uint32) (upper_bound(cloudBlockStarts.begin(), cloudBlockStarts.end(), blockIdx) - cloudBlockStarts.begin()) - 1;
+
+	// vertex range of the block
+	const uint64 localBlockIdx = blockIdx - cloudBlockStarts[cloudIdx];
+	const uint32 vertexCount = vertexCounts[cloudIdx];
+
+	start = (uint32) (localBlockIdx * PLY_VERTICES_BLOCK_SIZE);
+	end = (start + PLY_VERTICES_BLOCK_SIZE < vertexCount ? start + PLY_VERTICES_BLOCK_SIZE : vertexCount);
+}
+
 void CapturedScene::readSampleProperty(PlyFile &file, const uint32 sampleIdx,
 	const Path &fileName, const ElementsDescription::TYPES type, const VerticesDescription::SEMANTICS semantic)
 {
@@ -17,6 +17,8 @@
 
 namespace SurfaceReconstruction
 {
+	class BinaryPlyCloud;
+
 	/// Represents a Scene object which is created from captured real world data.
 	class CapturedScene : public Scene
 	{
@@ -57,10 +59,40 @@ namespace SurfaceReconstruction
 		uint32 loadSamples(Utilities::PlyFile &file, const Storage::Path &fileName, const Graphics::VerticesDescription &verticesFormat,
 			const uint32 maxNewSampleCount);
 
+		/** Finds the cloud and the vertex range of a block of vertices which were loaded via loadBinaryPlyClouds().
+		@param cloudIdx Is set to the index of the cloud the block blockIdx belongs to.
+		@param start Is set to the first vertex of the block within its cloud.
+		@param end Is set to the vertex after the last vertex of the block within its cloud.
+		@param blockIdx Identifies the block within the concatenation of the blocks of all clouds.
+		@param cloudBlockStarts Contains the index of the first block of each cloud and the total block count as last entry.
+		@param vertexCounts Contains the number of vertices to be read from each cloud. */
+		static void getPlyVerticesBlock(uint32 &cloudIdx, uint32 &start, uint32 &end,
+			const uint64 blockIdx, const std::vector<uint64> &cloudBlockStarts, const std::vector<uint32> &vertexCounts);
+
+		/** Loads the samples of memory mapped binary little endian ply clouds with fixed vertex layouts.
+			The headers of all clouds must have been read already so that the samples can be created at once.
+			The vertices of all clouds are then filtered and decoded concurrently and written directly to disjoint ranges of the sample arrays
+			using a prefix sum over the vertex blocks of all clouds.
+		@param clouds Set this to supported clouds which all have the same number of views per vertex which also matches existing samples.
+		@param fileNames Set this to the file names of clouds for output. */
+		void loadBinaryPlyClouds(const std::vector<BinaryPlyCloud *> &clouds, const std::vector<Storage::Path> &fileNames);
+
+		/** Loads the samples of clouds via loadBinaryPlyClouds() if there are any and then frees and removes all clouds and file names.
+			clouds is not changed if loading throws an exception so that the caller can still free them.
+		@param clouds Set this to the clouds to be loaded and freed. See loadBinaryPlyClouds().
+		@param fileNames Set this to the file names of clouds for output. */
+		void loadAndFreeBinaryPlyClouds(std::vector<BinaryPlyCloud *> &clouds, std::vector<Storage::Path> &fileNames);
+
+		/** Frees all clouds and clears the vector. */
+		static void freeBinaryPlyClouds(std::vector<BinaryPlyCloud *> &clouds);
+
 		/** todo */
 		void readSampleProperty(Utilities::PlyFile &file, const uint32 sampleIdx,
 			const Storage::Path &fileName, const Graphics::ElementsDescription::TYPES type, const Graphics::VerticesDescription::SEMANTICS semantic);
 
+	public:
+		static const uint32 PLY_VERTICES_BLOCK_SIZE;	/// Binary ply vertices are filtered and decoded by the threads in blocks of this size.
+
 	protected:
 		Math::Matrix3x3 mInvInputRotation;
 		Math::Vector3 mInvInputTranslation;
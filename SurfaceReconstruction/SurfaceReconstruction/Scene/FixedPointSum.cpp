@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+
+#include <cmath>
+#include "Platform/ParametersManager.h"
+#include "SurfaceReconstruction/Scene/FixedPointSum.h"
+
+using namespace Platform;
+using namespace SurfaceReconstruction;
+
+const int32 FixedPointSum::HIGH_DIGIT_EXPONENT = -8;
+const int32 FixedPointSum::LOW_DIGIT_EXPONENT = -40;
+
+const double FixedPointSum::HIGH_DIGIT_FACTOR = ldexp(1.0, -FixedPointSum::HIGH_DIGIT_EXPONENT);
+const double FixedPointSum::HIGH_DIGIT_SCALE = ldexp(1.0, FixedPointSum::HIGH_DIGIT_EXPONENT);
+const double FixedPointSum::LOW_DIGIT_FACTOR = ldexp(1.0, -FixedPointSum::LOW_DIGIT_EXPONENT);
+const double FixedPointSum::LOW_DIGIT_SCALE = ldexp(1.0, FixedPointSum::LOW_DIGIT_EXPONENT);
+
+bool FixedPointSum::isDeterministicModeEnabled()
+{
+	// e.g., viewers without program parameters
+	if (!ParametersManager::exists())
+		return false;
+
+	bool enabled = false;
+	ParametersManager::getSingleton().get(enabled, "Scene::deterministicReductions");
+	return enabled;
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+#ifndef _FIXED_POINT_SUM_H_
+#define _FIXED_POINT_SUM_H_
+
+#include "Math/Vector3.h"
+#include "Platform/DataTypes.h"
+
+namespace SurfaceReconstruction
+{
+	/** Thread safe sum of Real values which does not depend on the order of the additions and thus not on thread scheduling or thread count.
+		Each added value is split exactly into two fixed point digits with the scales 2^LOW_DIGIT_EXPONENT and 2^HIGH_DIGIT_EXPONENT
+		which are accumulated via integer atomics. Since integer addition is associative, the sum is bit-identical for any order.
+		Value parts below 2^LOW_DIGIT_EXPONENT are truncated. Magnitudes up to 2^32 can be added at least 2^23 times without overflow.
+		Used for the deterministic reductions mode instead of floating point atomics. (See parameter Scene::deterministicReductions.) */
+	class FixedPointSum
+	{
+	public:
+		/** Returns true if parallel reductions are supposed to produce bit-identical results for any thread count.
+			Call this once before a parallel loop as it queries the ParametersManager. */
+		static bool isDeterministicModeEnabled();
+
+		/** Atomically adds v.x, v.y and v.z to targets[0], targets[1] and targets[2]. */
+		inline static void add(FixedPointSum *targets, const Math::Vector3 &v);
+
+		/** Returns targets[0], targets[1] and targets[2] as vector. */
+		inline static Math::Vector3 getVector(const FixedPointSum *targets);
+
+	public:
+		/** Creates a zero sum. */
+		inline FixedPointSum();
+
+		/** Atomically adds value to the sum. */
+		inline void add(const Real value);
+
+		/** Sets the sum to zero. Not thread safe. */
+		inline void clear();
+
+		/** Returns the sum rounded to Real. */
+		inline Real getValue() const;
+
+	public:
+		static const double HIGH_DIGIT_FACTOR;	/// = 2^-HIGH_DIGIT_EXPONENT, converts values to high digits.
+		static const double HIGH_DIGIT_SCALE;	/// = 2^HIGH_DIGIT_EXPONENT, converts high digits to values.
+		static const double LOW_DIGIT_FACTOR;	/// = 2^-LOW_DIGIT_EXPONENT, converts values to low digits.
+		static const double LOW_DIGIT_SCALE;	/// = 2^LOW_DIGIT_EXPONENT, converts low digits to values.
+		static const int32 HIGH_DIGIT_EXPONENT;
+		static const int32 LOW_DIGIT_EXPONENT;
+
+	private:
+		int64 mHighDigits;	/// Sum of the truncated multiples of 2^HIGH_DIGIT_EXPONENT of all added values.
+		int64 mLowDigits;	/// Sum of the truncated multiples of 2^LOW_DIGIT_EXPONENT of the remainders of all added values.
+	};
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	///   inline function definitions   ////////////////////////////////////////////////////////////////////////////////////
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	inline void FixedPointSum::add(FixedPointSum *targets, const Math::Vector3 &v)
+	{
+		targets[0].add(v.x);
+		targets[1].add(v.y);
+		targets[2].add(v.z);
+	}
+
+	inline Math::Vector3 FixedPointSum::getVector(const FixedPointSum *targets)
+	{
+		return Math::Vector3(targets[0].getValue(), targets[1].getValue(), targets[2].getValue());
+	}
+
+	inline FixedPointSum::FixedPointSum() :
+		mHighDigits(0), mLowDigits(0)
+	{
+
+	}
+
+	inline void FixedPointSum::add(const Real value)
+	{
+		// exact split: scaling by powers of two and subtracting the truncated high part does not round in double precision
+		double remainder = value;
+		const int64 highDigits = (int64) (remainder * HIGH_DIGIT_FACTOR);
+		remainder -= highDigits * HIGH_DIGIT_SCALE;
+		const int64 lowDigits = (int64) (remainder * LOW_DIGIT_FACTOR);
+
+		if (0 != highDigits)
+		{
+			#pragma omp atomic
+			mHighDigits += highDigits;
+		}
+		if (0 != lowDigits)
+		{
+			#pragma omp atomic
+			mLowDigits += lowDigits;
+		}
+	}
+
+	inline void FixedPointSum::clear()
+	{
+		mHighDigits = 0;
+		mLowDigits = 0;
+	}
+
+	inline Real FixedPointSum::getValue() const
+	{
+		return (Real) (mHighDigits * HIGH_DIGIT_SCALE + mLowDigits * LOW_DIGIT_SCALE);
+	}
+}
+
+#endif // _FIXED_POINT_SUM_H_
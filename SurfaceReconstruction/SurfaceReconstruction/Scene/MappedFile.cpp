@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#ifndef _WINDOWS
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif // _WINDOWS
+#include "Platform/FailureHandling/FileCorruptionException.h"
+#include "Platform/FailureHandling/FileException.h"
+#include "Platform/ParametersManager.h"
+#include "SurfaceReconstruction/Scene/MappedFile.h"
+
+using namespace FailureHandling;
+using namespace Platform;
+using namespace std;
+using namespace Storage;
+using namespace SurfaceReconstruction;
+
+const uint64 MappedFile::ALIGNMENT = 0x1 << 12;
+const uint64 MappedFile::COPY_BLOCK_SIZE = 0x1 << 22;
+const char MappedFile::MAGIC[8] = { 'T', 'S', 'R', 'M', 'A', 'P', 'P', 'D' };
+
+namespace
+{
+	/// Layout of the beginning of each mapped file. It is followed by the offsets and then by the sizes of all sections.
+	struct Header
+	{
+		char mMagic[8];
+		uint32 mVersion;
+		uint32 mSectionCount;
+	};
+}
+
+bool MappedFile::isMappedFile(const Path &fileName)
+{
+	ifstream file(fileName.getString().c_str(), ios::in | ios::binary);
+	if (!file.is_open())
+		return false;
+
+	char magic[sizeof(MAGIC)];
+	file.read(magic, sizeof(MAGIC));
+	if (!file.good())
+		return false;
+
+	return (0 == memcmp(magic, MAGIC, sizeof(MAGIC)));
+}
+
+bool MappedFile::isSavingEnabled()
+{
+	bool enabled = true;
+	ParametersManager::getSingleton().get(enabled, "Scene::mappedIntermediateResults");
+	return enabled;
+}
+
+void MappedFile::save(const Path &fileName, const uint32 version,
+	const void * const *sections, const uint64 *byteCounts, const uint32 sectionCount)
+{
+	// header & section table
+	Header header;
+	memcpy(header.mMagic, MAGIC, sizeof(MAGIC));
+	header.mVersion = version;
+	header.mSectionCount = sectionCount;
+
+	// page aligned section offsets
+	vector<uint64> offsets(sectionCount);
+	uint64 end = sizeof(Header) + 2 * sizeof(uint64) * sectionCount;
+	for (uint32 sectionIdx = 0; sectionIdx < sectionCount; ++sectionIdx)
+	{
+		offsets[sectionIdx] = ((end + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
+		end = offsets[sectionIdx] + byteCounts[sectionIdx];
+	}
+
+	// create a temporary file next to the target as the target might still be mapped and used in place
+	// (truncating it would invalidate the mapped pages which were not yet accessed)
+	const Path temporaryName = Path::extendLeafName(fileName, ".tmp");
+	ofstream file(temporaryName.getString().c_str(), ios::out | ios::binary | ios::trunc);
+	if (!file.is_open())
+		throw FileException("Could not create mapped file.", temporaryName);
+
+	file.write((const char *) &header, sizeof(Header));
+	file.write((const char *) offsets.data(), sizeof(uint64) * sectionCount);
+	file.write((const char *) byteCounts, sizeof(uint64) * sectionCount);
+
+	// write sections with zero padding in between
+	const vector<char> padding(ALIGNMENT, 0);
+	uint64 position = sizeof(Header) + 2 * sizeof(uint64) * sectionCount;
+	for (uint32 sectionIdx = 0; sectionIdx < sectionCount; ++sectionIdx)
+	{
+		file.write(padding.data(), offsets[sectionIdx] - position);
+		file.write((const char *) sections[sectionIdx], byteCounts[sectionIdx]);
+		position = offsets[sectionIdx] + byteCounts[sectionIdx];
+	}
+
+	file.close();
+	if (!file.good())
+	{
+		remove(temporaryName.getString().c_str());
+		throw FileException("Could not write all sections of mapped file.", temporaryName);
+	}
+
+	// replace the target (existing mappings of the old file stay valid as they keep referencing its data)
+	#ifdef _WINDOWS
+		remove(fileName.getString().c_str());
+	#endif // _WINDOWS
+	if (0 != rename(temporaryName.getString().c_str(), fileName.getString().c_str()))
+	{
+		remove(temporaryName.getString().c_str());
+		throw FileException("Could not replace file by the new mapped file.", fileName);
+	}
+}
+
+MappedFile::MappedFile(const Path &fileName, const uint32 version) :
+	mFileName(fileName), mData(NULL), mByteCount(0), mOffsets(NULL), mSizes(NULL), mSectionCount(0)
+{
+	mData = mapFile(mByteCount, fileName);
+	if (mByteCount < sizeof(Header))
+	{
+		unmap();
+		throw FileCorruptionException("Mapped file is too small.", fileName);
+	}
+
+	// check header
+	const Header &header = *((const Header *) mData);
+	mSectionCount = header.mSectionCount;
+	if (0 != memcmp(header.mMagic, MAGIC, sizeof(MAGIC)))
+	{
+		unmap();
+		throw FileCorruptionException("File does not start with the header of a mapped file.", fileName);
+	}
+	if (version != header.mVersion)
+	{
+		unmap();
+		throw FileCorruptionException("Mapped file has an unsupported version.", fileName);
+	}
+
+	// check section table
+	const uint64 tableEnd = sizeof(Header) + 2 * sizeof(uint64) * mSectionCount;
+	if (tableEnd > mByteCount)
+	{
+		unmap();
+		throw FileCorruptionException("Mapped file has an incomplete section table.", fileName);
+	}
+
+	mOffsets = (const uint64 *) (mData + sizeof(Header));
+	mSizes = mOffsets + mSectionCount;
+	for (uint32 sectionIdx = 0; sectionIdx < mSectionCount; ++sectionIdx)
+	{
+		if (mOffsets[sectionIdx] + mSizes[sectionIdx] <= mByteCount)
+			continue;
+
+		unmap();
+		throw FileCorruptionException("Mapped file is truncated.", fileName);
+	}
+}
+
+uint8 *MappedFile::mapFile(uint64 &byteCount, const Path &fileName)
+{
+	#ifndef _WINDOWS
+		// get file size & map the whole file privately (copy-on-write)
+		const int descriptor = open(fileName.getString().c_str(), O_RDONLY);
+		if (-1 == descriptor)
+			throw FileException("Could not open file for memory mapping.", fileName);
+
+		struct stat fileStatus;
+		if (0 != fstat(descriptor, &fileStatus) || 0 == fileStatus.st_size)
+		{
+			close(descriptor);
+			throw FileCorruptionException("Cannot map an empty file.", fileName);
+		}
+
+		byteCount = fileStatus.st_size;
+		void *data = mmap(NULL, byteCount, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+		close(descriptor);
+
+		if (MAP_FAILED == data)
+			throw FileException("Could not map file into memory.", fileName);
+		return (uint8 *) data;
+	#else
+		// no mmap: read the whole file at once
+		ifstream file(fileName.getString().c_str(), ios::in | ios::binary | ios::ate);
+		if (!file.is_open())
+			throw FileException("Could not open file for memory mapping.", fileName);
+
+		byteCount = file.tellg();
+		if (0 == byteCount)
+			throw FileCorruptionException("Cannot map an empty file.", fileName);
+
+		uint8 *data = new uint8[byteCount];
+		file.seekg(0);
+		file.read((char *) data, byteCount);
+		if (!file.good())
+		{
+			delete [] data;
+			throw FileException("Could not read file.", fileName);
+		}
+
+		return data;
+	#endif // _WINDOWS
+}
+
+void MappedFile::unmapFile(uint8 *data, const uint64 byteCount)
+{
+	if (!data)
+		return;
+
+	#ifndef _WINDOWS
+		munmap(data, byteCount);
+	#else
+		delete [] data;
+	#endif // _WINDOWS
+}
+
+MappedFile::~MappedFile()
+{
+	unmap();
+}
+
+void MappedFile::copySection(void *target, const uint32 sectionIdx, const uint64 byteCount) const
+{
+	const uint8 *source = getSectionData(sectionIdx, byteCount);
+	uint8 *destination = (uint8 *) target;
+
+	// let all threads fault in & copy the pages
+	const int64 blockCount = (int64) ((byteCount + COPY_BLOCK_SIZE - 1) / COPY_BLOCK_SIZE);
+	#pragma omp parallel for
+	for (int64 blockIdx = 0; blockIdx < blockCount; ++blockIdx)
+	{
+		const uint64 start = blockIdx * COPY_BLOCK_SIZE;
+		const uint64 size = (start + COPY_BLOCK_SIZE > byteCount ? byteCount - start : COPY_BLOCK_SIZE);
+		memcpy(destination + start, source + start, size);
+	}
+}
+
+uint8 *MappedFile::getSectionData(const uint32 sectionIdx, const uint64 byteCount) const
+{
+	if (sectionIdx >= mSectionCount)
+		throw FileCorruptionException("Mapped file has too few sections.", mFileName);
+	if (byteCount != mSizes[sectionIdx])
+		throw FileCorruptionException("Mapped file section has an unexpected size.", mFileName);
+
+	return mData + mOffsets[sectionIdx];
+}
+
+void MappedFile::unmap()
+{
+	unmapFile(mData, mByteCount);
+
+	mData = NULL;
+	mByteCount = 0;
+	mOffsets = NULL;
+	mSizes = NULL;
+	mSectionCount = 0;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include <cassert>
+#include "Platform/DataTypes.h"
+#include "Platform/Storage/Path.h"
+
+namespace SurfaceReconstruction
+{
+	/** Read access to intermediate results (.Samples, .Nodes, .Leaves, .Occupancy, .Mesh etc.) which were saved as a set of page aligned sections.
+		The whole file is mapped privately into memory so that loading does not need to read anything upfront.
+		Sections can be used in place (zero copy) as long as the MappedFile object exists.
+		Writing to such a section only creates private copies of the written pages (copy-on-write) and never changes the file.
+		Sections which must end up in owning containers, such as std::vector objects, are copied by all threads from the mapped pages. */
+	class MappedFile
+	{
+	public:
+		/** Returns true if fileName can be opened and starts with the header of a mapped file.
+		@param fileName Set this to the file you want to check. */
+		static bool isMappedFile(const Storage::Path &fileName);
+
+		/** Returns true if intermediate results are supposed to be saved as mapped files. (See parameter Scene::mappedIntermediateResults.)
+			Otherwise, they are saved using the older sequential Storage::File format. Loading supports both formats. */
+		static bool isSavingEnabled();
+
+		/** Maps the whole file fileName privately into memory. Writing to the returned memory only creates private copies of the written pages.
+			If memory mapping is not supported, the whole file is read into a new buffer instead.
+		@param byteCount Is set to the size of the file and of the returned memory block.
+		@param fileName Set this to the file which is mapped.
+		@return Returns the start of the mapped file which must be released via unmapFile(). An exception is thrown if the file cannot be mapped. */
+		static uint8 *mapFile(uint64 &byteCount, const Storage::Path &fileName);
+
+		/** Releases memory which was returned by mapFile(). */
+		static void unmapFile(uint8 *data, const uint64 byteCount);
+
+		/** Saves sectionCount memory blocks to a new file whereas each block starts at a page aligned offset.
+			The blocks are first written to a temporary file which then replaces fileName.
+			Thus, fileName can still be mapped and its sections can even be the saved blocks.
+		@param fileName Set this to the path of the file which is created or replaced.
+		@param version Set this to the format version of the caller which is checked when the file is mapped again.
+		@param sections Set this to sectionCount pointers to the memory blocks which are saved.
+		@param byteCounts Set this to the sizes of the sectionCount blocks of sections.
+		@param sectionCount Set this to the number of memory blocks to be saved. */
+		static void save(const Storage::Path &fileName, const uint32 version,
+			const void * const *sections, const uint64 *byteCounts, const uint32 sectionCount);
+
+	public:
+		/** Maps the file fileName privately into memory and checks its header.
+		@param fileName Set this to the file which was created via save().
+		@param version Set this to the format version the file was saved with. An exception is thrown if it does not match. */
+		MappedFile(const Storage::Path &fileName, const uint32 version);
+
+		/** Unmaps the file. All section pointers become invalid. */
+		~MappedFile();
+
+		/** Copies the section sectionIdx to target using all threads.
+		@param target Set this to memory of at least byteCount bytes.
+		@param sectionIdx Identifies the section which is copied.
+		@param byteCount Set this to the expected size of the section. An exception is thrown if the section has a different size. */
+		void copySection(void *target, const uint32 sectionIdx, const uint64 byteCount) const;
+
+		/** Returns the mapped section sectionIdx as array of elementCount objects which can be used in place.
+			The returned memory is valid as long as this object exists and writing to it does not change the file.
+		@param sectionIdx Identifies the requested section.
+		@param elementCount Set this to the expected number of elements. An exception is thrown if the section has a different size. */
+		template <class T>
+		inline T *getSection(const uint32 sectionIdx, const uint64 elementCount) const;
+
+		inline uint32 getSectionCount() const;
+
+		/** Returns the size of the section sectionIdx in bytes. */
+		inline uint64 getSectionSize(const uint32 sectionIdx) const;
+
+	private:
+		/** Copy constructor is forbidden. Don't use it. */
+		inline MappedFile(const MappedFile &other);
+
+		/** Assignment operator is forbidden. Don't use it.*/
+		inline MappedFile &operator =(const MappedFile &rhs);
+
+		/** Returns the start of the section sectionIdx and throws an exception if it does not have byteCount bytes. */
+		uint8 *getSectionData(const uint32 sectionIdx, const uint64 byteCount) const;
+
+		/** Releases the mapping. */
+		void unmap();
+
+	public:
+		static const uint64 ALIGNMENT;			/// Every section starts at a multiple of this offset (page size) to be usable in place and to keep copy-on-write page granular.
+		static const uint64 COPY_BLOCK_SIZE;	/// Sections are copied by all threads in blocks of this size.
+		static const char MAGIC[8];				/// Every mapped file starts with these bytes.
+
+	private:
+		Storage::Path mFileName;
+		uint8 *mData;				/// Start of the mapped file.
+		uint64 mByteCount;			/// Size of the mapped file.
+		const uint64 *mOffsets;		/// Start of each section relative to mData.
+		const uint64 *mSizes;		/// Size of each section in bytes.
+		uint32 mSectionCount;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	///   inline function definitions   ////////////////////////////////////////////////////////////////////////////////////
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	inline MappedFile::MappedFile(const MappedFile &other)
+	{
+		assert(false);
+	}
+
+	inline MappedFile &MappedFile::operator =(const MappedFile &rhs)
+	{
+		assert(false);
+		return *this;
+	}
+
+	template <class T>
+	inline T *MappedFile::getSection(const uint32 sectionIdx, const uint64 elementCount) const
+	{
+		return (T *) getSectionData(sectionIdx, sizeof(T) * elementCount);
+	}
+
+	inline uint32 MappedFile::getSectionCount() const
+	{
+		return mSectionCount;
+	}
+
+	inline uint64 MappedFile::getSectionSize(const uint32 sectionIdx) const
+	{
+		return mSizes[sectionIdx];
+	}
+}
+
+#endif // _MAPPED_FILE_H_
@@ -15,6 +15,7 @@
 #include "Platform/ParametersManager.h"
 #include "Platform/Platform.h"
 #include "SurfaceReconstruction/Geometry/FlexibleMesh.h"
+#include "SurfaceReconstruction/Scene/MappedFile.h"
 #include "SurfaceReconstruction/Scene/Samples.h"
 #include "SurfaceReconstruction/Scene/Scene.h"
 #include "SurfaceReconstruction/Scene/View.h"
@@ -658,6 +659,33 @@ void Samples::loadFromFile(const Path &fileName)
 {
 	cout << "Loading samples from file " << fileName << "." << endl;
 	
+	// page aligned format?
+	if (MappedFile::isMappedFile(fileName))
+	{
+		// get #samples & #views per sample & request memory
+		const MappedFile file(fileName, FILE_VERSION);
+		const uint32 *counts = file.getSection<uint32>(0, 2);
+		const uint32 sampleCount = counts[0];
+		mViewsPerSample = counts[1];
+		file.copySection(mAABBWS, 1, sizeof(Vector3) * 2);
+
+		resize(sampleCount);
+
+		// copy samples
+		const uint32 parentCount = sampleCount * mViewsPerSample;
+		file.copySection(mColors.data(), 2, sizeof(Vector3) * sampleCount);
+		file.copySection(mNormals.data(), 3, sizeof(Vector3) * sampleCount);
+		file.copySection(mPositions.data(), 4, sizeof(Vector3) * sampleCount);
+		file.copySection(mConfidences.data(), 5, sizeof(Real) * sampleCount);
+		file.copySection(mScales.data(), 6, sizeof(Real) * sampleCount);
+		file.copySection(mParentViews.data(), 7, sizeof(uint32) * parentCount);
+
+		computeParentViewCount();
+
+		cout << "Loaded " << getCount() << " samples." << endl;
+		return;
+	}
+
 	// open file & check version
 	File file(fileName, File::OPEN_READING, true, FILE_VERSION);
 
@@ -703,12 +731,34 @@ void Samples::saveToFile(const Path &beginning, const bool saveAsPly, const bool
 	// internal mesh format?
 	if (saveAsSamples)
 	{
-		// create file & write version
 		const Path fileName = Path::extendLeafName(beginning, ".Samples");
+		const uint32 sampleCount = (uint32) mNormals.size();
+
+		// page aligned format?
+		if (MappedFile::isSavingEnabled())
+		{
+			const uint32 counts[2] = { sampleCount, mViewsPerSample };
+			const void *sections[] =
+			{
+				counts, mAABBWS,
+				mColors.data(), mNormals.data(), mPositions.data(),
+				mConfidences.data(), mScales.data(), mParentViews.data()
+			};
+			const uint64 byteCounts[] =
+			{
+				sizeof(uint32) * 2, sizeof(Vector3) * 2,
+				sizeof(Vector3) * sampleCount, sizeof(Vector3) * sampleCount, sizeof(Vector3) * sampleCount,
+				sizeof(Real) * sampleCount, sizeof(Real) * sampleCount, sizeof(uint32) * sampleCount * mViewsPerSample
+			};
+
+			MappedFile::save(fileName, FILE_VERSION, sections, byteCounts, 8);
+			return;
+		}
+
+		// create file & write version
 		File file(fileName, File::CREATE_WRITING, true, FILE_VERSION);
 
 		// save sample count, views per sample & AABB
-		const uint32 sampleCount = (uint32) mNormals.size();
 		file.write(&sampleCount, sizeof(uint32), 1);
 		file.write(&mViewsPerSample, sizeof(uint32), 1);
 		file.write(mAABBWS, sizeof(Vector3), 2);
@@ -6,6 +6,7 @@
  * This software may be modified and distributed under the terms
  * of the BSD 3-Clause license. See the License.txt file for details.
  */
+#include <cstdio>
 #include "Platform/FailureHandling/Exception.h"
 #include "Platform/FailureHandling/FileAccessException.h"
 #include "Platform/Storage/File.h"
@@ -14,13 +15,17 @@
 #include "Platform/Platform.h"
 #include "Platform/Storage/Directory.h"
 #include "SurfaceReconstruction/Image/Image.h"
+#include "SurfaceReconstruction/Geometry/MeshStitcher.h"
 #include "SurfaceReconstruction/Geometry/StaticMesh.h"
 #include "SurfaceReconstruction/Refinement/FSSFRefiner.h"
 #ifdef PCS_REFINEMENT
 	#include "SurfaceReconstruction/Refinement/PCSRefiner.h"
 #endif // PCS_REFINEMENT
+#include "SurfaceReconstruction/Scene/AsyncMeshWriter.h"
 #include "SurfaceReconstruction/Scene/Samples.h"
 #include "SurfaceReconstruction/Scene/Scene.h"
+#include "SurfaceReconstruction/Scene/StageProfiler.h"
+#include "SurfaceReconstruction/Scene/Tree/Nodes.h"
 #include "SurfaceReconstruction/Scene/Tree/Tree.h"
 #include "SurfaceReconstruction/Scene/View.h"
 #include "SurfaceReconstruction/SurfaceExtraction/DualMarchingCells.h"
@@ -46,17 +51,21 @@ Scene::Scene(const Path &rootFolder, const Path &FSSFReconstruction,
 
 Scene::Scene(const vector<IReconstructorObserver *> &observers) : 
 	mGroundTruth(NULL),
+	mMeshWriter(NULL),
 	mFSSFRefiner(NULL),
 	mOccupancy(NULL),
 	#ifdef PCS_REFINEMENT
 		mPCSRefiner(NULL),
 	#endif // PCS_REFINEMENT
 	mSamples(NULL),
+	mProfiler(NULL),
 	mTree(NULL),
 	mRefinerObservers(observers),
 	mFolder(""),
 	mImageTag("undistorted"),
-	mRelativeCamerasFile("Cameras.txt")
+	mRelativeCamerasFile("Cameras.txt"),
+	mLastStage(STAGE_REFINEMENT),
+	mFreeSpaceFiltered(false)
 {
 	for (uint32 meshIdx = 0; meshIdx < RECONSTRUCTION_TYPE_COUNT; ++meshIdx)
 		mReconstructions[meshIdx] = NULL;
@@ -64,8 +73,22 @@ Scene::Scene(const vector<IReconstructorObserver *> &observers) :
 	// required parameters
 	const string isleSizeName = "Scene::minimumTriangleIsleSize";
 
-	// get required parameters
+	// optional profiling of the reconstruction stages
 	const ParametersManager &manager = ParametersManager::getSingleton();
+	bool profileStages = false;
+	manager.get(profileStages, "Scene::profileStages");
+	if (profileStages && !StageProfiler::exists())
+		mProfiler = new StageProfiler();
+
+	// optional background saving of meshes
+	bool asyncMeshSaving = false;
+	uint32 maxPendingMeshSnapshots = 2;
+	manager.get(asyncMeshSaving, "Scene::asyncMeshSaving");
+	manager.get(maxPendingMeshSnapshots, "Scene::maxPendingMeshSnapshots");
+	if (asyncMeshSaving && !AsyncMeshWriter::exists())
+		mMeshWriter = new AsyncMeshWriter(maxPendingMeshSnapshots);
+
+	// get required parameters
 	const bool loadedIsleSize = manager.get(mMinIsleSize, isleSizeName);
 	if (loadedIsleSize)
 		return;
@@ -87,11 +110,68 @@ Scene::~Scene()
 {
 	clear();
 
+	// writes all pending snapshots
+	delete mMeshWriter;
+	mMeshWriter = NULL;
+
+	delete mProfiler;
+	mProfiler = NULL;
+
 	// free volatile resources
 	// free cached images
 	Image::freeMemory();
 }
 
+void Scene::discardStages(const Stage firstStage, const bool keepFSSFStart)
+{
+	// refinement results & refiners
+	for (uint32 meshIdx = 0; meshIdx < RECONSTRUCTION_TYPE_COUNT; ++meshIdx)
+	{
+		if (RECONSTRUCTION_VIA_OCCUPANCIES == meshIdx && firstStage > STAGE_CRUST)
+			continue;
+		if (RECONSTRUCTION_VIA_SAMPLES == meshIdx && keepFSSFStart)
+			continue;
+
+		delete mReconstructions[meshIdx];
+		mReconstructions[meshIdx] = NULL;
+	}
+
+	#ifdef PCS_REFINEMENT
+		delete mPCSRefiner;
+		mPCSRefiner = NULL;
+	#endif // PCS_REFINEMENT
+
+	delete mFSSFRefiner;
+	mFSSFRefiner = NULL;
+
+	// free space
+	if (firstStage > STAGE_OCCUPANCY)
+		return;
+	delete mOccupancy;
+	mOccupancy = NULL;
+
+	// filtered tree & samples stem from the occupancy stage -> back to the unfiltered ones
+	const Path beginning = getFileBeginning();
+	if (mFreeSpaceFiltered)
+	{
+		delete mTree;
+		delete mSamples;
+		mTree = NULL;
+		mSamples = NULL;
+		mFreeSpaceFiltered = false;
+
+		mSamples = new Samples(Path::extendLeafName(beginning, "SamplesReordered.Samples"));
+		if (firstStage > STAGE_TREE)
+			mTree = new Tree(Path::extendLeafName(beginning, ".Tree"));
+	}
+	
+	// scene tree (the reordered samples are still valid input samples)
+	if (firstStage > STAGE_TREE)
+		return;
+	delete mTree;
+	mTree = NULL;
+}
+
 bool Scene::reconstruct()
 {
 	// no views/samples for tree creation?
@@ -137,12 +217,55 @@ bool Scene::reconstruct()
 		return false;
 	}
 
+	// tiled reconstruction of large scenes?
+	uint32 tilesPerAxis = 1;
+	ParametersManager::getSingleton().get(tilesPerAxis, "Scene::tilesPerAxis");
+	const bool tiled = (tilesPerAxis > 1 && !mTree && !mOccupancy && !mReconstructions[RECONSTRUCTION_VIA_OCCUPANCIES]);
+
+	// run & profile all stages
+	bool success = false;
+	{
+		StageProfiler::Scope profilerScope("Reconstruction", "samples");
+		profilerScope.addItems(sampleCount);
+		success = (tiled ? reconstructTiled(tilesPerAxis) : reconstructSamples());
+
+		// all results are on disk when reconstruct returns
+		if (mMeshWriter)
+			mMeshWriter->flush();
+	}
+
+	saveProfilingReport(beginning);
+	return success;
+}
+
+void Scene::saveProfilingReport(const Path &fileBeginning) const
+{
+	if (!mProfiler)
+		return;
+
+	try
+	{
+		mProfiler->saveReport(fileBeginning);
+	}
+	catch (Exception &exception)
+	{
+		cerr << exception;
+	}
+}
+
+bool Scene::reconstructSamples()
+{
+	const Path beginning = getFileBeginning();
+
 	// save unfiltered / initial non-zero confidence surface samples
 	if (!mOccupancy && !mTree)
 		mSamples->saveToFile(Path::extendLeafName(beginning, "Samples"), true, true);
 		
 	if (!mTree)
 	{
+		StageProfiler::Scope profilerScope("Tree", "samples");
+		profilerScope.addItems(mSamples->getCount());
+
 		// scene tree & reordered samples
 		Samples *reorderedSamples = NULL;
 		mTree = new Tree(reorderedSamples);
@@ -157,37 +280,66 @@ bool Scene::reconstruct()
 		mSamples->saveToFile(Path::extendLeafName(beginning, "SamplesReordered"), true, true);
 		mTree->saveToFiles(Path::extendLeafName(beginning, ".Tree"));
 	}
+	if (STAGE_TREE == mLastStage)
+		return true;
 
 	// create scene tree and estimate free space?
 	if (!mOccupancy)
 	{
+		StageProfiler::Scope profilerScope("Occupancy", "samples");
+		profilerScope.addItems(mSamples->getCount());
+
 		// estimate free space / space occupancy scalar field
 		mOccupancy = new Occupancy(mTree);
 
-		// compute free space and find samples in free space
-		//eraseSamplesInEmptySpace();
-		//mSamples->saveToFile(beginning + "SamplesFiltered", true, true);
-
-		// save filtered samples, free space & scene tree
-		mOccupancy->saveToFile(Path::extendLeafName(beginning, ".Occupancy"));
+		// optional: find & remove samples in free space
+		bool eraseFreeSpaceOutliers = false;
+		ParametersManager::getSingleton().get(eraseFreeSpaceOutliers, "Scene::eraseFreeSpaceOutliers");
+		if (eraseFreeSpaceOutliers)
+		{
+			// save filtered samples, tree & free space separately as .Tree belongs to SamplesReordered
+			eraseSamplesInEmptySpace();
+			mFreeSpaceFiltered = true;
+			mSamples->saveToFile(Path::extendLeafName(beginning, "SamplesFiltered"), true, true);
+			mTree->saveToFiles(Path::extendLeafName(beginning, ".TreeFiltered"));
+			mOccupancy->saveToFile(Path::extendLeafName(beginning, ".OccupancyFiltered"));
+		}
+		else
+		{
+			// save free space & invalidate filtered results of earlier runs (see loadFreeSpaceFilteredStages)
+			mOccupancy->saveToFile(Path::extendLeafName(beginning, ".Occupancy"));
+			remove(Path::extendLeafName(beginning, ".OccupancyFiltered").getString().c_str());
+		}
 	}
+	if (STAGE_OCCUPANCY == mLastStage)
+		return true;
 
 	if (!mReconstructions[RECONSTRUCTION_VIA_OCCUPANCIES])
 	{
+		StageProfiler::Scope profilerScope("Crust", "triangles");
+
 		// get & check surface mesh	
 		const FlexibleMesh &crustSurface = mOccupancy->extractCrust().getSurface();
+		profilerScope.addItems(crustSurface.getTriangleCount());
 		if (0 == crustSurface.getVertexCount() || 0 == crustSurface.getIndexCount())
 			return false;
 		takeReconstructionFromOccupancy();
 	}	
+	if (STAGE_CRUST == mLastStage)
+		return true;
 
 	// refinement via samples?
-	if (!mFSSFRefiner)
 	{
-		cout << "Mesh refinement via input samples." << endl;
-		createFSSFRefiner();
+		StageProfiler::Scope profilerScope("FSSF", "samples");
+		profilerScope.addItems(mSamples->getCount());
+
+		if (!mFSSFRefiner)
+		{
+			cout << "Mesh refinement via input samples." << endl;
+			createFSSFRefiner();
+		}
+		refine(RECONSTRUCTION_VIA_SAMPLES);
 	}
-	refine(RECONSTRUCTION_VIA_SAMPLES);
 
 	//// refinement via photos?
 	//if (!mPCSRefiner && mReconstructions[RECONSTRUCTION_VIA_SAMPLES])
@@ -204,46 +356,217 @@ bool Scene::reconstruct()
 	return true;
 }
 
-//void Scene::eraseSamplesInEmptySpace()
-//{
-//	cout << "Starting to erase free space outlier surface samples." << endl;
-//	vector<uint32> sampleOffsets(mSamples->getCount() + 1);
-//	vector<uint32> doomedSamples;
-//
-//	while (true)
-//	{
-//		// sample offsets for deletion of outliers in free space and corresponding compaction of samples
-//		const uint32 oldSampleCount = (uint32) mSamples->getCount();
-//		sampleOffsets.resize(oldSampleCount + 1);
-//	
-//		// find samples in free space & erase them from these nodes
-//		mTree->eraseSamplesInNodes(sampleOffsets.data(), mOccupancy->getNodeStates(), oldSampleCount, Occupancy::NODE_FLAG_EMPTY);
-//		const uint32 doomedSampleCount = sampleOffsets[oldSampleCount];
-//		if (0 == doomedSampleCount)
-//			return;
-//	
-//		// remove outliers from occupancy & samples
-//		doomedSamples.resize(doomedSampleCount);
-//		#pragma omp parallel for
-//		for (int64 sampleIdx = 0; sampleIdx < oldSampleCount; ++sampleIdx)
-//		{
-//			const uint32 offset = sampleOffsets[sampleIdx];
-//			if (offset != sampleOffsets[sampleIdx + 1])
-//				doomedSamples[offset] = (uint32) sampleIdx;
-//		}
-//
-//		mOccupancy->eraseSamples(doomedSamples.data(), doomedSampleCount);
-//		mSamples->compact(sampleOffsets.data());
-//
-//		// output
-//		const uint32 newSampleCount = mSamples->getCount();
-//		const uint32 removalCount = sampleOffsets[oldSampleCount];
-//		cout << "Finished removal iteration of free space outliers.\n";
-//		cout << "Number of removed outliers: " << removalCount << ", new sample count: " << newSampleCount << "\n";
-//	}
-//
-//	cout << flush;
-//}
+bool Scene::reconstructTiled(const uint32 tilesPerAxis)
+{
+	// get tiling parameters
+	const ParametersManager &manager = ParametersManager::getSingleton();
+	Real relativeOverlap = 0.1f;
+	Real relativeWeldDistance = 0.5f;
+	manager.get(relativeOverlap, "Scene::relativeTileOverlap");
+	manager.get(relativeWeldDistance, "Scene::relativeSeamWeldDistance");
+
+	// the tile cores partition the AABB of all samples
+	mSamples->computeAABB();
+	const Vector3 AABB[2] = { mSamples->getAABBWS()[0], mSamples->getAABBWS()[1] };
+	const Vector3 tileSize = (AABB[1] - AABB[0]) * (1.0f / tilesPerAxis);
+	const Vector3 overlap = tileSize * relativeOverlap;
+	const uint32 tileCount = tilesPerAxis * tilesPerAxis * tilesPerAxis;
+	vector<Vector3> cores(2 * tileCount);
+	vector<Vector3> tileAABBs(2 * tileCount);
+	vector<Path> tileSampleFiles(tileCount);
+	vector<string> tileNames(tileCount);
+	MeshStitcher stitcher;
+
+	cout << "Starting tiled reconstruction with " << tileCount << " tiles." << endl;
+	for (uint32 tileIdx = 0; tileIdx < tileCount; ++tileIdx)
+	{
+		// tile core & tile with overlap
+		const uint32 coords[3] = { tileIdx % tilesPerAxis, (tileIdx / tilesPerAxis) % tilesPerAxis, tileIdx / (tilesPerAxis * tilesPerAxis) };
+		const bool maxInclusive[3] = { tilesPerAxis - 1 == coords[0], tilesPerAxis - 1 == coords[1], tilesPerAxis - 1 == coords[2] };
+		Vector3 *core = cores.data() + 2 * tileIdx;
+		Vector3 *tileAABB = tileAABBs.data() + 2 * tileIdx;
+		
+		core[0].set(AABB[0].x + coords[0] * tileSize.x, AABB[0].y + coords[1] * tileSize.y, AABB[0].z + coords[2] * tileSize.z);
+		core[1].set(maxInclusive[0] ? AABB[1].x : core[0].x + tileSize.x,
+					maxInclusive[1] ? AABB[1].y : core[0].y + tileSize.y,
+					maxInclusive[2] ? AABB[1].z : core[0].z + tileSize.z);
+		tileAABB[0] = core[0] - overlap;
+		tileAABB[1] = core[1] + overlap;
+
+		// cores of tiles at the scene border keep surfaces which are reconstructed beyond the sample AABB
+		core[0].set(0 == coords[0] ? -REAL_MAX : core[0].x, 0 == coords[1] ? -REAL_MAX : core[0].y, 0 == coords[2] ? -REAL_MAX : core[0].z);
+		core[1].set(maxInclusive[0] ? REAL_MAX : core[1].x, maxInclusive[1] ? REAL_MAX : core[1].y, maxInclusive[2] ? REAL_MAX : core[1].z);
+
+		// own intermediate result files for each tile
+		const uint32 BUFFER_SIZE = 100;
+		char buffer[BUFFER_SIZE];
+		snprintf(buffer, BUFFER_SIZE, "Tile%.4u", tileIdx);
+		tileNames[tileIdx] = buffer;
+		mTileName = tileNames[tileIdx];
+
+		// write the samples of each tile to its own file
+		Samples *tileSamples = createTileSamples(*mSamples, tileAABB);
+		tileSampleFiles[tileIdx] = Path::extendLeafName(getFileBeginning(), "SamplesInput");
+		tileSamples->saveToFile(tileSampleFiles[tileIdx], false, true);
+		tileSampleFiles[tileIdx] = Path::extendLeafName(tileSampleFiles[tileIdx], ".Samples");
+		delete tileSamples;
+	}
+
+	// only the samples of one tile at a time are in memory while the tiles are reconstructed
+	mTileName.clear();
+	const Path allSamplesFile = Path::extendLeafName(getFileBeginning(), "Samples");
+	mSamples->saveToFile(allSamplesFile, true, true);
+	delete mSamples;
+	mSamples = NULL;
+
+	// cores at the scene border are unbounded -> no inclusive maxima required
+	const bool maxInclusive[3] = { false, false, false };
+	for (uint32 tileIdx = 0; tileIdx < tileCount; ++tileIdx)
+	{
+		const Vector3 *core = cores.data() + 2 * tileIdx;
+
+		// reconstruct the tile from its samples only
+		mTileName = tileNames[tileIdx];
+		mSamples = new Samples(tileSampleFiles[tileIdx]);
+		cout << "Reconstructing tile " << tileIdx << " of " << tileCount << " with " << mSamples->getCount() << " samples." << endl;
+
+		StageProfiler::Scope profilerScope("Tile", "samples");
+		profilerScope.addItems(mSamples->getCount());
+
+		if (0 != mSamples->getCount() && 0 != mSamples->getViewConeCount() && reconstructSamples())
+		{
+			const FlexibleMesh *tileMesh = getMostRefinedReconstruction();
+			if (tileMesh)
+				stitcher.addTile(*tileMesh, core, maxInclusive);
+		}
+
+		// free all data of the tile (reconstructSamples saved the tile samples again)
+		clearReconstructionData();
+		remove(tileSampleFiles[tileIdx].getString().c_str());
+	}
+
+	// restore all samples
+	mTileName.clear();
+	mSamples = new Samples(Path::extendLeafName(allSamplesFile, ".Samples"));
+
+	if (0 == stitcher.getTileCount())
+	{
+		cout << "Stopping early. No tile could be reconstructed." << endl;
+		return false;
+	}
+
+	// one mesh for the whole scene
+	StageProfiler::Scope profilerScope("Stitching", "tiles");
+	profilerScope.addItems(stitcher.getTileCount());
+
+	FlexibleMesh *mesh = stitcher.createStitchedMesh(relativeWeldDistance);
+	mesh->computeNormalsWeightedByAngles();
+	takeOverReconstruction(mesh, RECONSTRUCTION_VIA_SAMPLES);
+	saveReconstructionToFiles(RECONSTRUCTION_VIA_SAMPLES, "TilesStitched", true, true);
+
+	return true;
+}
+
+Samples *Scene::createTileSamples(const Samples &allSamples, const Vector3 tileAABB[2]) const
+{
+	// find the samples with centers within the tile
+	const uint32 sampleCount = allSamples.getCount();
+	vector<uint8> inTile(sampleCount);
+
+	#pragma omp parallel for
+	for (int64 sampleIdx = 0; sampleIdx < sampleCount; ++sampleIdx)
+	{
+		const Vector3 &p = allSamples.getPositionWS((uint32) sampleIdx);
+		inTile[sampleIdx] = (p.x >= tileAABB[0].x && p.y >= tileAABB[0].y && p.z >= tileAABB[0].z &&
+							 p.x <= tileAABB[1].x && p.y <= tileAABB[1].y && p.z <= tileAABB[1].z);
+	}
+
+	vector<uint32> tileSampleIndices;
+	for (uint32 sampleIdx = 0; sampleIdx < sampleCount; ++sampleIdx)
+		if (inTile[sampleIdx])
+			tileSampleIndices.push_back(sampleIdx);
+
+	// copy them
+	const int64 tileSampleCount = tileSampleIndices.size();
+	Samples *tileSamples = new Samples(allSamples.getViewsPerSample());
+	tileSamples->resize((uint32) tileSampleCount);
+
+	#pragma omp parallel for
+	for (int64 targetIdx = 0; targetIdx < tileSampleCount; ++targetIdx)
+		tileSamples->set((uint32) targetIdx, allSamples, tileSampleIndices[targetIdx]);
+
+	tileSamples->computeAABB();
+	tileSamples->computeParentViewCount();
+	return tileSamples;
+}
+
+void Scene::eraseSamplesInEmptySpace()
+{
+	cout << "Starting to erase free space outlier surface samples." << endl;
+	StageProfiler::Scope profilerScope("FreeSpaceOutliers", "samples");
+
+	const Nodes &nodes = mTree->getNodes();
+	const uint32 *nodeStates = mOccupancy->getNodeStates();
+	vector<uint32> sampleOffsets(mSamples->getCount() + 1);
+	vector<uint32> doomedSamples;
+
+	for (uint32 iteration = 0; true; ++iteration)
+	{
+		// empty space according to the current occupancy
+		const uint32 emptyLeafCount = mOccupancy->updateEmptyNodeStates();
+
+		// how many leaves & inner nodes are going to lose their samples?
+		const uint32 nodeCount = nodes.getCount();
+		uint32 doomedLeafCount = 0;
+		uint32 doomedInnerNodeCount = 0;
+		for (uint32 nodeIdx = 0; nodeIdx < nodeCount; ++nodeIdx)
+		{
+			uint32 nodeSampleCount;
+			nodes.getSamples(nodeSampleCount, nodeIdx);
+			if (0 == nodeSampleCount || !(Occupancy::NODE_FLAG_EMPTY & nodeStates[nodeIdx]))
+				continue;
+
+			if (nodes.isLeaf(nodeIdx))
+				++doomedLeafCount;
+			else
+				++doomedInnerNodeCount;
+		}
+
+		// sample offsets for deletion of outliers in free space and corresponding compaction of samples
+		const uint32 oldSampleCount = (uint32) mSamples->getCount();
+		const uint32 oldViewConeCount = mSamples->getViewConeCount();
+		sampleOffsets.resize(oldSampleCount + 1);
+	
+		// find samples in free space & erase them from these nodes
+		if (!mTree->eraseSamplesInNodes(sampleOffsets.data(), nodeStates, oldSampleCount, Occupancy::NODE_FLAG_EMPTY))
+			break;
+		const uint32 doomedSampleCount = sampleOffsets[oldSampleCount];
+	
+		// remove outliers from occupancy & samples
+		doomedSamples.resize(doomedSampleCount);
+		#pragma omp parallel for
+		for (int64 sampleIdx = 0; sampleIdx < oldSampleCount; ++sampleIdx)
+		{
+			const uint32 offset = sampleOffsets[sampleIdx];
+			if (offset != sampleOffsets[sampleIdx + 1])
+				doomedSamples[offset] = (uint32) sampleIdx;
+		}
+
+		mOccupancy->eraseSamples(doomedSamples.data(), doomedSampleCount);
+		mSamples->compact(sampleOffsets.data());
+		profilerScope.addItems(doomedSampleCount);
+
+		// output
+		const uint32 newSampleCount = mSamples->getCount();
+		const uint32 removedViewConeCount = oldViewConeCount - mSamples->getViewConeCount();
+		cout << "Finished removal iteration " << iteration << " of free space outliers.\n";
+		cout << "Number of removed outliers: " << doomedSampleCount << ", removed view cones: " << removedViewConeCount;
+		cout << ", cleared leaves: " << doomedLeafCount << ", cleared inner nodes: " << doomedInnerNodeCount;
+		cout << ", empty leaves: " << emptyLeafCount << ", new sample count: " << newSampleCount << "\n";
+	}
+
+	cout << "Finished removal of free space outliers." << endl;
+}
 
 void Scene::checkSamples()
 {
@@ -360,7 +683,7 @@ void Scene::eraseSamples(const bool *inliers, const bool saveResults)
 
 Path Scene::getFileBeginning() const
 {
-	const Path childPath("Scene");
+	const Path childPath("Scene" + mTileName);
 	return Path::appendChild(getResultsFolder(), childPath);
 }
 
@@ -436,8 +759,8 @@ void Scene::loadFromFile(const Path &rootFolder, const Path &FSSFReconstruction)
 	else
 		mSamples = new Samples(Path::extendLeafName(beginning, "Samples.Samples"));
 	
-	// try to load the free space
-	if (mTree)
+	// try to load the free space (preferably with the free space filtered tree & samples, depending on the existing files)
+	if (mTree && !loadFreeSpaceFilteredStages())
 	{
 		try
 		{
@@ -450,21 +773,6 @@ void Scene::loadFromFile(const Path &rootFolder, const Path &FSSFReconstruction)
 		}
 	}
 
-	//if (mOccupancy)
-	//{
-	//	try
-	//	{
-	//		Samples *samples = new Samples(beginning + "SamplesFiltered.Samples");
-	//		delete mSamples;
-	//		mSamples = samples;
-	//	}
-	//	catch (Exception &exception)
-	//	{
-	//		cout << exception;
-	//		cout << "There are no saved with free space filtered samples which could be loaded." << endl;
-	//	}
-	//}
-
 	// there might be a ground truth which can be loaded
 	Path fileName;
 	try
@@ -513,6 +821,41 @@ void Scene::loadFromFile(const Path &rootFolder, const Path &FSSFReconstruction)
 	createFSSFRefiner();
 }
 
+bool Scene::loadFreeSpaceFilteredStages()
+{
+	const Path beginning = getFileBeginning();
+	Tree *unfilteredTree = mTree;
+	Tree *filteredTree = NULL;
+	Samples *filteredSamples = NULL;
+
+	try
+	{
+		filteredTree = new Tree(Path::extendLeafName(beginning, ".TreeFiltered"));
+		filteredSamples = new Samples(Path::extendLeafName(beginning, "SamplesFiltered.Samples"));
+
+		// the occupancy is loaded w.r.t. the scene tree
+		mTree = filteredTree;
+		mOccupancy = new Occupancy(Path::extendLeafName(beginning, ".OccupancyFiltered"));
+	}
+	catch (Exception &exception)
+	{
+		cout << exception;
+		cout << "There are no saved free space filtered tree, samples and occupancy which could be loaded." << endl;
+
+		mTree = unfilteredTree;
+		delete filteredTree;
+		delete filteredSamples;
+		return false;
+	}
+
+	// replace the unfiltered tree & samples
+	delete unfilteredTree;
+	delete mSamples;
+	mSamples = filteredSamples;
+	mFreeSpaceFiltered = true;
+	return true;
+}
+
 void Scene::takeReconstructionFromOccupancy()
 {
 	// create crust?
@@ -598,8 +941,13 @@ void Scene::saveReconstructionToFiles(const ReconstructionType type, const strin
 		return;
 	
 	// file name without type
-	const Path name = Path::appendChild(getResultsFolder(), localName);
-	mesh->saveToFile(name, saveAsPly, saveAsMesh);
+	const Path name = Path::appendChild(getResultsFolder(), mTileName + localName);
+
+	// snapshot for background saving as the reconstruction might change in the meantime
+	if (AsyncMeshWriter::exists())
+		AsyncMeshWriter::save(new FlexibleMesh(*mesh), name, saveAsPly, saveAsMesh);
+	else
+		mesh->saveToFile(name, saveAsPly, saveAsMesh);
 }
 
 void Scene::loadViewsFromFile(const Path &fileName)
@@ -677,6 +1025,18 @@ void Scene::clear()
 	delete mGroundTruth;
 	mGroundTruth = NULL;
 
+	clearReconstructionData();
+
+	// free views
+	const uint32 viewCount = (uint32) mViews.size();
+	for (uint32 viewIdx = 0; viewIdx < viewCount; ++viewIdx)
+		delete mViews[viewIdx];
+	mViews.clear();
+	mViews.shrink_to_fit();
+}
+
+void Scene::clearReconstructionData()
+{
 	for (uint32 i = 0; i < RECONSTRUCTION_TYPE_COUNT; ++i)
 	{
 		delete mReconstructions[i];
@@ -698,11 +1058,5 @@ void Scene::clear()
 	mOccupancy = NULL;
 	mSamples = NULL;
 	mTree = NULL;
-
-	// free views
-	const uint32 viewCount = (uint32) mViews.size();
-	for (uint32 viewIdx = 0; viewIdx < viewCount; ++viewIdx)
-		delete mViews[viewIdx];
-	mViews.clear();
-	mViews.shrink_to_fit();
+	mFreeSpaceFiltered = false;
 }
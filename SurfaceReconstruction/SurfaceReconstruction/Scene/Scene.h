@@ -10,6 +10,7 @@
 #define _SCENE_H_
 
 #include <string>
+#include "Math/Vector3.h"
 #include "SurfaceReconstruction/Scene/IReconstructorObserver.h"
 #include "Patterns/Singleton.h"
 #include "Platform/Storage/Path.h"
@@ -17,12 +18,14 @@
 
 namespace SurfaceReconstruction
 {
+	class AsyncMeshWriter;
 	class FlexibleMesh;
 	class FSSFRefiner;
 	class Mesh;
 	class Occupancy;
 	class PCSRefiner;
 	class Samples;
+	class StageProfiler;
 	class StaticMesh;
 	class Tree;
 	class View;
@@ -30,6 +33,17 @@ namespace SurfaceReconstruction
 	/// Represents a complete scene with its object, camera, noise descriptions and so on.
 	class Scene : public IReconstructorObserver, public Patterns::Singleton<Scene>
 	{
+	public:
+		/// Stages of reconstruct() in the order in which they are executed.
+		enum Stage
+		{
+			STAGE_TREE,			/// scene tree creation & sample reordering
+			STAGE_OCCUPANCY,	/// free space estimation
+			STAGE_CRUST,		/// crust extraction from the occupancy scalar field
+			STAGE_REFINEMENT,	/// FSSF refinement of the crust via the samples
+			STAGE_COUNT
+		};
+
 	public:
 		/** todo */
 		inline static const Tree *getTree();
@@ -43,6 +57,13 @@ namespace SurfaceReconstruction
 		/** Frees all scene data, such as views. */
 		virtual ~Scene();
 
+		/** Frees loaded intermediate results of firstStage and all later stages so that reconstruct() computes them again.
+			If the free space filtered tree and samples were loaded and the occupancy stage is executed again, the unfiltered samples (and tree) are loaded instead.
+		@param firstStage Set this to the first stage which is to be executed again. Results of earlier stages are kept.
+		@param keepFSSFStart Set this to true to keep the loaded FSSF result (RECONSTRUCTION_VIA_SAMPLES) as start mesh of the next refinement,
+			e.g., if it was explicitly chosen by the user. */
+		void discardStages(const Stage firstStage, const bool keepFSSFStart = false);
+
 		/** Updates samples, free space and scene tree.
 		@param sampleOffsets todo*/
 		void eraseSamples(const bool *inliers, const bool saveResults);
@@ -114,6 +135,10 @@ namespace SurfaceReconstruction
 
 		///** todo */
 		//void saveToFile() const;
+
+		/** Defines where reconstruct() stops.
+		@param lastStage reconstruct() returns after this stage is completed. STAGE_REFINEMENT runs the complete pipeline (default). */
+		inline void setLastStage(const Stage lastStage);
 		
 		/** todo */
 		void swapSamples(const uint32 index0, const uint32 index1);
@@ -135,15 +160,27 @@ namespace SurfaceReconstruction
 		/** Frees allocated memory and sets pointers to NULL. */
 		void clear();
 
+		/** Frees samples, tree, occupancy, refiners and reconstructions but keeps views and ground truth. */
+		void clearReconstructionData();
+
 		/** Creates an FSSRefiner with the latest reconstruction as input mesh. */
 		void createFSSFRefiner();
 
+		/** Returns a new Samples object with copies of all samples of allSamples with centers within tileAABB. */
+		Samples *createTileSamples(const Samples &allSamples, const Math::Vector3 tileAABB[2]) const;
+
 		/** Gets synthetic scene description from a parameters file.
 		@param fileName Describes where to create the scene, what data to load, how to create the scene, etc.*/
 		virtual bool getParameters(const Storage::Path &fileName);
 
-		///** todo */
-		//void eraseSamplesInEmptySpace();
+		/** Repeatedly removes all samples which are stored in tree nodes classified as empty space (see Occupancy::NODE_FLAG_EMPTY) until there are no such samples anymore.
+			Each iteration updates the node sample ranges of mTree and subtracts the view cones of the removed samples from mOccupancy instead of rebuilding them. */
+		void eraseSamplesInEmptySpace();
+
+		/** Tries to load the free space filtered tree, samples and occupancy which are only saved together. (See Scene::eraseFreeSpaceOutliers.)
+			On success, they replace the unfiltered tree and samples. Otherwise, nothing is changed.
+		@return Returns true if all three were loaded. */
+		bool loadFreeSpaceFilteredStages();
 
 		/** todo */
 		void loadFromFile(const Storage::Path &rootFolder, const Storage::Path &FSSFReconstruction);
@@ -151,6 +188,21 @@ namespace SurfaceReconstruction
 		/** todo */
 		void loadViewsFromFile(const Storage::Path &fileName);
 
+		/** Runs the reconstruction stages (tree, occupancy, crust extraction and FSSF refinement) which are still missing for the current samples. */
+		bool reconstructSamples();
+
+		/** Reconstructs the scene as tilesPerAxis^3 overlapping tiles one after another.
+			Each tile is reconstructed from the samples within the tile and its overlap (see Scene::relativeTileOverlap) and saves its own intermediate results.
+			The samples of all tiles are first written to separate files and all samples are freed, so only the samples of the current tile are loaded.
+			Views stay loaded for the whole run and all samples are loaded again after the last tile.
+			The tile meshes are cropped to their tile cores, border vertices are welded along the seams and the remaining seam gaps are zipped by MeshStitcher.
+			(see Scene::relativeSeamWeldDistance)
+		@param tilesPerAxis Set this to the number of tiles along each axis of the sample AABB. */
+		bool reconstructTiled(const uint32 tilesPerAxis);
+
+		/** Writes the timings, memory usage and throughput of all executed stages to fileBeginning + "Profile.json" / "Profile.csv" if profiling is enabled. */
+		void saveProfilingReport(const Storage::Path &fileBeginning) const;
+
 		/** todo */
 		void saveViewsToFile(const Storage::Path &fileName) const;
 
@@ -174,10 +226,12 @@ namespace SurfaceReconstruction
 		StaticMesh *mGroundTruth;															/// Contains ground truth surfaces to be reconstructed.
 		FlexibleMesh *mReconstructions[IReconstructorObserver::RECONSTRUCTION_TYPE_COUNT];	/// Contains different reconstruction types, see SurfaceReconstruction::MeshObserver::ReconstructionType.
 
+		AsyncMeshWriter *mMeshWriter;		/// Saves mesh snapshots in the background if Scene::asyncMeshSaving is set.
 		FSSFRefiner *mFSSFRefiner;			/// Does variational surface mesh refinement starting with an initial mesh to get a reconstruction which "fits to" input images (high photo consistency score).
 		Occupancy *mOccupancy;				/// Represents how empty and full the space is.
 		PCSRefiner *mPCSRefiner;			/// Refines a coarse extracted crust to fit to the scene input samples.
 		Samples *mSamples;					/// Represents all scene samples.
+		StageProfiler *mProfiler;			/// Records time, memory and throughput of the reconstruction stages if Scene::profileStages is set.
 		Tree *mTree;						/// This tree partitions this scene spatially and defines sampling positions for the implicit function used for reconstruction.
 
 		std::vector<IReconstructorObserver *> mRefinerObservers;	/// get updates from mesh refiners
@@ -186,7 +240,10 @@ namespace SurfaceReconstruction
 		Storage::Path mFolder;				/// Defines the root scene folder. Contains scene data and is the parent folder of the folders like views containing sub folders for each view with their images. 
 		Storage::Path mRelativeCamerasFile;	/// Defines the file with the data of all cameras, file name is relative to folder.
 		std::string mImageTag;				/// Defines what kind of images are loaded (e.g. undist-L2)
+		std::string mTileName;				/// Is appended to result file names while a single tile is reconstructed. (See reconstructTiled.)
 		uint32 mMinIsleSize;		/// Triangle isles (isolated, connected sets of triangles) smaller than this are removed.
+		Stage mLastStage;			/// reconstruct() stops after this stage.
+		bool mFreeSpaceFiltered;	/// Set if mTree, mSamples and mOccupancy are the ones after free space outlier removal. (See Scene::eraseFreeSpaceOutliers.)
 	};
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -266,6 +323,11 @@ namespace SurfaceReconstruction
 	{
 		return (viewIdx < mViews.size() && mViews[viewIdx]);
 	}
+
+	inline void Scene::setLastStage(const Stage lastStage)
+	{
+		mLastStage = lastStage;
+	}
 }
 
 #endif // _SCENE_H_
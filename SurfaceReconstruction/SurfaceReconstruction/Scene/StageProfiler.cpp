@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+
+#include <fstream>
+#include <iomanip>
+#include <omp.h>
+#ifdef _WINDOWS
+	#include <windows.h>
+	#include <psapi.h>
+#else
+	#include <cstdio>
+	#include <sys/resource.h>
+	#include <unistd.h>
+#endif // _WINDOWS
+#include "Platform/FailureHandling/FileException.h"
+#include "SurfaceReconstruction/Scene/StageProfiler.h"
+
+using namespace FailureHandling;
+using namespace std;
+using namespace Storage;
+using namespace SurfaceReconstruction;
+
+const uint32 StageProfiler::INVALID_RECORD = (uint32) -1;
+
+StageProfiler::Scope::Scope(const string &name, const string &itemName) :
+	mRecordIdx(INVALID_RECORD)
+{
+	if (StageProfiler::exists())
+		mRecordIdx = StageProfiler::getSingleton().beginStage(name, itemName);
+}
+
+StageProfiler::Scope::~Scope()
+{
+	if (INVALID_RECORD != mRecordIdx && StageProfiler::exists())
+		StageProfiler::getSingleton().endStage(mRecordIdx);
+}
+
+void StageProfiler::Scope::addItems(const uint64 itemCount)
+{
+	if (INVALID_RECORD != mRecordIdx && StageProfiler::exists())
+		StageProfiler::getSingleton().addItems(mRecordIdx, itemCount);
+}
+
+StageProfiler::StageProfiler()
+{
+
+}
+
+StageProfiler::Record::Record(const string &path, const string &itemName, const uint32 depth) :
+	mPath(path), mItemName(itemName),
+	mCPUSeconds(0.0), mWallSeconds(0.0), mStartCPUSeconds(0.0), mStartWallSeconds(0.0),
+	mItemCount(0), mBoundaryRSS(0), mProcessPeakRSS(0), mCallCount(0), mDepth(depth)
+{
+
+}
+
+void StageProfiler::addItems(const uint32 recordIdx, const uint64 itemCount)
+{
+	uint64 &target = mRecords[recordIdx].mItemCount;
+	#pragma omp atomic
+	target += itemCount;
+}
+
+uint32 StageProfiler::beginStage(const string &name, const string &itemName)
+{
+	// full stage path
+	string path;
+	if (!mRunningStages.empty())
+		path = mRecords[mRunningStages.back()].mPath + "/";
+	path += name;
+
+	// new or repeated stage?
+	uint32 recordIdx = (uint32) mRecords.size();
+	pair<map<string, uint32>::iterator, bool> result = mRecordIndices.insert(make_pair(path, recordIdx));
+	if (result.second)
+		mRecords.push_back(Record(path, itemName, (uint32) mRunningStages.size()));
+	else
+		recordIdx = result.first->second;
+
+	// start measurements
+	Record &record = mRecords[recordIdx];
+	uint64 currentRSS;
+	uint64 processPeakRSS;
+	getProcessUsage(record.mStartCPUSeconds, currentRSS, processPeakRSS);
+	record.mStartWallSeconds = omp_get_wtime();
+	if (currentRSS > record.mBoundaryRSS)
+		record.mBoundaryRSS = currentRSS;
+
+	mRunningStages.push_back(recordIdx);
+	return recordIdx;
+}
+
+void StageProfiler::endStage(const uint32 recordIdx)
+{
+	// stages must be properly nested
+	assert(!mRunningStages.empty() && recordIdx == mRunningStages.back());
+	mRunningStages.pop_back();
+
+	// stop measurements
+	Record &record = mRecords[recordIdx];
+	double CPUSeconds;
+	uint64 currentRSS;
+	getProcessUsage(CPUSeconds, currentRSS, record.mProcessPeakRSS);
+	if (currentRSS > record.mBoundaryRSS)
+		record.mBoundaryRSS = currentRSS;
+
+	record.mCPUSeconds += CPUSeconds - record.mStartCPUSeconds;
+	record.mWallSeconds += omp_get_wtime() - record.mStartWallSeconds;
+	++record.mCallCount;
+}
+
+void StageProfiler::getProcessUsage(double &CPUSeconds, uint64 &currentRSS, uint64 &processPeakRSS)
+{
+	CPUSeconds = 0.0;
+	currentRSS = 0;
+	processPeakRSS = 0;
+
+	#ifdef _WINDOWS
+		// times in 100 ns units
+		FILETIME creationTime, exitTime, kernelTime, userTime;
+		if (GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+		{
+			const uint64 kernel = (((uint64) kernelTime.dwHighDateTime) << 32) | kernelTime.dwLowDateTime;
+			const uint64 user = (((uint64) userTime.dwHighDateTime) << 32) | userTime.dwLowDateTime;
+			CPUSeconds = (kernel + user) * 1e-7;
+		}
+
+		PROCESS_MEMORY_COUNTERS memoryCounters;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &memoryCounters, sizeof(memoryCounters)))
+		{
+			currentRSS = memoryCounters.WorkingSetSize;
+			processPeakRSS = memoryCounters.PeakWorkingSetSize;
+		}
+	#else
+		rusage usage;
+		if (0 == getrusage(RUSAGE_SELF, &usage))
+		{
+			CPUSeconds  = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6;
+			CPUSeconds += usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+			processPeakRSS = ((uint64) usage.ru_maxrss) << 10; // kilobytes on Linux
+		}
+
+		// current resident pages (Linux only)
+		FILE *statm = fopen("/proc/self/statm", "r");
+		if (!statm)
+			return;
+
+		unsigned long long totalPages = 0;
+		unsigned long long residentPages = 0;
+		if (2 == fscanf(statm, "%llu %llu", &totalPages, &residentPages))
+			currentRSS = residentPages * (uint64) sysconf(_SC_PAGESIZE);
+		fclose(statm);
+	#endif // _WINDOWS
+}
+
+void StageProfiler::saveReport(const Path &fileBeginning) const
+{
+	saveCSV(Path::extendLeafName(fileBeginning, "Profile.csv"));
+	saveJSON(Path::extendLeafName(fileBeginning, "Profile.json"));
+}
+
+void StageProfiler::saveCSV(const Path &fileName) const
+{
+	ofstream file(fileName.getString().c_str());
+	if (!file.is_open())
+		throw FileException("Could not create profiling report.", fileName);
+
+	// one line per stage
+	file << "stage,depth,calls,wallSeconds,CPUSeconds,boundaryRSSBytes,cumulativeProcessPeakRSSBytes,itemName,items,itemsPerSecond\n";
+	file << setprecision(9);
+
+	const uint32 recordCount = (uint32) mRecords.size();
+	for (uint32 recordIdx = 0; recordIdx < recordCount; ++recordIdx)
+	{
+		const Record &r = mRecords[recordIdx];
+		file << r.mPath << "," << r.mDepth << "," << r.mCallCount << ",";
+		file << r.mWallSeconds << "," << r.mCPUSeconds << "," << r.mBoundaryRSS << "," << r.mProcessPeakRSS << ",";
+		file << r.mItemName << "," << r.mItemCount << "," << r.getItemsPerSecond() << "\n";
+	}
+}
+
+void StageProfiler::saveJSON(const Path &fileName) const
+{
+	ofstream file(fileName.getString().c_str());
+	if (!file.is_open())
+		throw FileException("Could not create profiling report.", fileName);
+
+	// stage names and item names are plain identifiers which need no escaping
+	file << setprecision(9);
+	file << "{\n";
+	file << "\t\"threads\": " << omp_get_max_threads() << ",\n";
+	file << "\t\"stages\":\n";
+	file << "\t[\n";
+
+	const uint32 recordCount = (uint32) mRecords.size();
+	for (uint32 recordIdx = 0; recordIdx < recordCount; ++recordIdx)
+	{
+		const Record &r = mRecords[recordIdx];
+		file << "\t\t{ ";
+		file << "\"stage\": \"" << r.mPath << "\", ";
+		file << "\"depth\": " << r.mDepth << ", ";
+		file << "\"calls\": " << r.mCallCount << ", ";
+		file << "\"wallSeconds\": " << r.mWallSeconds << ", ";
+		file << "\"CPUSeconds\": " << r.mCPUSeconds << ", ";
+		file << "\"boundaryRSSBytes\": " << r.mBoundaryRSS << ", ";
+		file << "\"cumulativeProcessPeakRSSBytes\": " << r.mProcessPeakRSS << ", ";
+		file << "\"itemName\": \"" << r.mItemName << "\", ";
+		file << "\"items\": " << r.mItemCount << ", ";
+		file << "\"itemsPerSecond\": " << r.getItemsPerSecond();
+		file << " }" << (recordIdx + 1 < recordCount ? ",\n" : "\n");
+	}
+
+	file << "\t]\n";
+	file << "}\n";
+}
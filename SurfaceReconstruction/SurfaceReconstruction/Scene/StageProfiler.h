@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2017 by Author: Aroudj, Samir
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the License.txt file for details.
+ */
+#ifndef _STAGE_PROFILER_H_
+#define _STAGE_PROFILER_H_
+
+#include <cassert>
+#include <map>
+#include <string>
+#include <vector>
+#include "Patterns/Singleton.h"
+#include "Platform/DataTypes.h"
+#include "Platform/Storage/Path.h"
+
+namespace SurfaceReconstruction
+{
+	/** Records wall time, CPU time, resident memory and item throughput of reconstruction stages and their sub stages.
+		Memory is not tracked continuously. Per stage, there is the largest resident set size sampled when the stage started or finished
+		and the process peak resident set size so far which also covers all previously executed stages.
+		Stages are identified by their path of nested stage names, e.g., "Reconstruction/FSSF/KernelInterpolation".
+		Repeated executions of a stage, such as FSSF iterations, are accumulated in a single record.
+		Stages must be started and finished outside of parallel regions whereas items can be added from any thread. */
+	class StageProfiler : public Patterns::Singleton<StageProfiler>
+	{
+	public:
+		/// Profiles the enclosing block as stage if there is a StageProfiler object and does nothing otherwise.
+		class Scope
+		{
+		public:
+			/** Starts the stage name as sub stage of the innermost running stage.
+			@param name Set this to the stage name without path.
+			@param itemName Set this to the name of the items processed by the stage, e.g., samples or rays. */
+			Scope(const std::string &name, const std::string &itemName);
+
+			/** Finishes the stage. */
+			~Scope();
+
+			/** Adds itemCount processed items to the stage for its throughput. Thread safe. */
+			void addItems(const uint64 itemCount);
+
+		private:
+			/** Copy constructor is forbidden. Don't use it. */
+			inline Scope(const Scope &other);
+
+			/** Assignment operator is forbidden. Don't use it.*/
+			inline Scope &operator =(const Scope &rhs);
+
+		private:
+			uint32 mRecordIdx;	/// Identifies the record of the stage or is INVALID_RECORD if there is no profiler.
+		};
+
+	public:
+		StageProfiler();
+
+		/** Adds itemCount processed items to the stage recordIdx. Thread safe. */
+		void addItems(const uint32 recordIdx, const uint64 itemCount);
+
+		/** Starts a stage as sub stage of the innermost running stage.
+		@return Returns the index of the stage record which must be passed to endStage. */
+		uint32 beginStage(const std::string &name, const std::string &itemName);
+
+		/** Finishes the innermost running stage which must be recordIdx. */
+		void endStage(const uint32 recordIdx);
+
+		/** Writes all records to fileBeginning + "Profile.json" and fileBeginning + "Profile.csv". */
+		void saveReport(const Storage::Path &fileBeginning) const;
+
+	private:
+		/** Copy constructor is forbidden. Don't use it. */
+		inline StageProfiler(const StageProfiler &other);
+
+		/** Assignment operator is forbidden. Don't use it.*/
+		inline StageProfiler &operator =(const StageProfiler &rhs);
+
+		/** Returns the user and system time of all threads of this process, its current resident set size and its peak resident set size so far in bytes.
+			The current resident set size is 0 if the platform does not provide it. */
+		static void getProcessUsage(double &CPUSeconds, uint64 &currentRSS, uint64 &processPeakRSS);
+
+		void saveCSV(const Storage::Path &fileName) const;
+		void saveJSON(const Storage::Path &fileName) const;
+
+	public:
+		static const uint32 INVALID_RECORD;
+
+	private:
+		/// Accumulated measurements of all executions of a stage.
+		struct Record
+		{
+		public:
+			Record(const std::string &path, const std::string &itemName, const uint32 depth);
+
+			inline double getItemsPerSecond() const;
+
+		public:
+			std::string mPath;		/// Names of all enclosing stages and of this stage separated by '/'.
+			std::string mItemName;	/// What the stage processes, e.g., samples.
+			double mCPUSeconds;		/// Sum of user and system time of all threads.
+			double mWallSeconds;
+			double mStartCPUSeconds;
+			double mStartWallSeconds;
+			uint64 mItemCount;
+			uint64 mBoundaryRSS;	/// Largest current resident set size of the process in bytes sampled at any start or end of the stage.
+			uint64 mProcessPeakRSS;	/// Cumulative peak resident set size of the process in bytes since its start when the stage was finished the last time.
+			uint32 mCallCount;
+			uint32 mDepth;			/// Number of enclosing stages.
+		};
+
+	private:
+		std::vector<Record> mRecords;					/// Records in order of their first start.
+		std::map<std::string, uint32> mRecordIndices;	/// Maps stage paths to indices of mRecords.
+		std::vector<uint32> mRunningStages;				/// Stack of running stages, innermost stage at the back.
+	};
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	///   inline function definitions   ////////////////////////////////////////////////////////////////////////////////////
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	inline StageProfiler::Scope::Scope(const Scope &other)
+	{
+		assert(false);
+	}
+
+	inline StageProfiler::Scope &StageProfiler::Scope::operator =(const Scope &rhs)
+	{
+		assert(false);
+		return *this;
+	}
+
+	inline StageProfiler::StageProfiler(const StageProfiler &other)
+	{
+		assert(false);
+	}
+
+	inline StageProfiler &StageProfiler::operator =(const StageProfiler &rhs)
+	{
+		assert(false);
+		return *this;
+	}
+
+	inline double StageProfiler::Record::getItemsPerSecond() const
+	{
+		if (mWallSeconds <= 0.0)
+			return 0.0;
+		return mItemCount / mWallSeconds;
+	}
+}
+
+#endif // _STAGE_PROFILER_H_
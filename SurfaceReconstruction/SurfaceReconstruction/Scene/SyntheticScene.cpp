@@ -8,6 +8,7 @@
  */
 
 #include <fstream>
+#include <omp.h>
 #include "CollisionDetection/CollisionDetection.h"
 #include "Graphics/Color.h"
 #include "Graphics/ImageManager.h"
@@ -152,6 +153,14 @@ bool SyntheticScene::getParameters(const Path &fileName)
 	}
 	mGroundTruthName = temp;
 
+	// optional: multiple parent views per sample
+	mViewsPerSample = 1;
+	mRelativeVisibilityTolerance = 0.01f;
+	manager.get(mViewsPerSample, "SyntheticScene::viewsPerSample");
+	manager.get(mRelativeVisibilityTolerance, "SyntheticScene::relativeVisibilityTolerance");
+	if (0 == mViewsPerSample)
+		mViewsPerSample = 1;
+
 	return true;
 }
 
@@ -216,22 +225,10 @@ void SyntheticScene::createAndSaveSamples()
 		return;
 
 	// create samples
-	const uint32 viewsPerSample = 1; // todo: how to get more views per sample?
-	mSamples = new Samples(viewsPerSample);
-
-	// ray tracing preparation
-	const uint32 pixelCount = mViewResolution.getElementCount();
+	mSamples = new Samples(mViewsPerSample);
 
-	// create the scene and target depth map for the ray tracer
+	// create the scene for the ray tracer
 	RayTracer rayTracer;
-	vector<Vector3> hitsMap(pixelCount);
-	vector<Real> depthMap(pixelCount);
-	vector<uint32> pixelToHitMap(pixelCount);
-	vector<vector<uint32>> vertexNeighbors;
-	vector<uint32> hitToVertexLinks;
-	vector<uint32> indices;
-	uint32 hitCount;
-
 	rayTracer.createStaticScene(*mGroundTruth, true);
 
 	// create folder for image if necessary
@@ -240,63 +237,117 @@ void SyntheticScene::createAndSaveSamples()
 	if (!Directory::createDirectory(imagesFolder))
 		return;
 
-	// create a depth map for each view
-	const uint32 viewCount = (uint32) mViews.size();
-	for (uint32 viewIdx = 0; viewIdx < viewCount; )
+	// depth, hit & index maps, noise and scratch data for each thread
+	const uint32 pixelCount = mViewResolution.getElementCount();
+	const uint32 batchSize = omp_get_max_threads();
+	vector<ViewSampling> samplings(batchSize);
+	for (uint32 localIdx = 0; localIdx < batchSize; ++localIdx)
 	{
-		// get camera data
-		const View &view = *createSyntheticView(viewIdx);
-		const PinholeCamera &camera = view.getCamera();
-		const Vector3 camPosWS = view.getPositionWS();
+		ViewSampling &sampling = samplings[localIdx];
+		sampling.mHitsMap.resize(pixelCount);
+		sampling.mDepthMap.resize(pixelCount);
+		sampling.mPixelToHitMap.resize(pixelCount);
+	}
 
-		// trace scene -> depth, hit & index map
-		const bool good = fill(depthMap, hitsMap, pixelToHitMap, rayTracer, hitCount, camera);
-		if (0 == hitCount || !good)
-			continue;
+	// process the views in batches
+	const uint32 viewCount = (uint32) mViews.size();
+	for (uint32 startViewIdx = 0; startViewIdx < viewCount; startViewIdx += batchSize)
+	{
+		const uint32 endViewIdx = (startViewIdx + batchSize < viewCount ? startViewIdx + batchSize : viewCount);
+		const int64 localViewCount = endViewIdx - startViewIdx;
 
-		// noise on surface samples
-		//saveToFile(depthMap, viewIdx, false);
-		addNoise(hitsMap, depthMap, camPosWS);
+		// random views, depth maps & noise one after another for the same random numbers as with sequential processing
+		for (uint32 viewIdx = startViewIdx; viewIdx < endViewIdx; ++viewIdx)
+			renderSyntheticView(samplings[viewIdx - startViewIdx], rayTracer, viewIdx);
 
-		//if (Math::EPSILON < mDepthMapNoise[0] || Math::EPSILON < mDepthMapNoise[1])
-		//	saveToFile(depthMap, viewIdx, true);
+		// noise, triangulation & image saving concurrently
+		#pragma omp parallel for schedule(dynamic, 1)
+		for (int64 localIdx = 0; localIdx < localViewCount; ++localIdx)
+			processSyntheticView(samplings[localIdx], imagesFolder);
 
-		// triangulate surface samples & create proper input samples
-		addToSamples(vertexNeighbors, indices, hitToVertexLinks,
-			hitsMap, depthMap, pixelToHitMap, hitCount, viewIdx);
-		
-		// view<number>.mvei
-		string localName = "view";
-		localName += view.getIDString(viewIdx);
-		localName += ".mvei";
-		
-		const Path fileName = Path::appendChild(imagesFolder, localName);
-		Image::saveAsMVEFloatImage(fileName, mViewResolution, depthMap.data(), false, false);
+		// samples in view order
+		for (uint32 localIdx = 0; localIdx < localViewCount; ++localIdx)
+		{
+			ViewSampling &sampling = samplings[localIdx];
+			addToSamples(*sampling.mTriangulation, sampling.mViewIdx);
 
-		++viewIdx;
+			delete sampling.mTriangulation;
+			sampling.mTriangulation = NULL;
+		}
 	}
+
+	// further views for each sample?
+	if (mViewsPerSample > 1)
+		linkSamplesToVisibleViews(rayTracer);
 	
 	mSamples->computeParentViewCount();
 	mSamples->computeAABB();
 	checkSamples();
 }
 
+void SyntheticScene::renderSyntheticView(ViewSampling &sampling, RayTracer &rayTracer, const uint32 viewIdx)
+{
+	sampling.mViewIdx = viewIdx;
+
+	// random views until the depth map is usable
+	while (true)
+	{
+		// get camera data
+		const View &view = *createSyntheticView(viewIdx);
+		const PinholeCamera &camera = view.getCamera();
+
+		// trace scene -> depth, hit & index map
+		const bool good = fill(sampling.mDepthMap, sampling.mHitsMap, sampling.mPixelToHitMap, rayTracer, sampling.mHitCount, camera);
+		if (0 != sampling.mHitCount && good)
+			break;
+	}
+
+	// noise on surface samples
+	drawNoise(sampling.mNoiseFactors);
+}
+
+void SyntheticScene::processSyntheticView(ViewSampling &sampling, const Path &imagesFolder) const
+{
+	// noise on surface samples
+	const View &view = *mViews[sampling.mViewIdx];
+	//saveToFile(sampling.mDepthMap, sampling.mViewIdx, false);
+	addNoise(sampling.mHitsMap, sampling.mDepthMap, sampling.mNoiseFactors, view.getPositionWS());
+
+	//if (Math::EPSILON < mDepthMapNoise[0] || Math::EPSILON < mDepthMapNoise[1])
+	//	saveToFile(sampling.mDepthMap, sampling.mViewIdx, true);
+
+	// triangulate surface samples
+	sampling.mTriangulation = createSampleTriangulation(sampling);
+
+	// view<number>.mvei
+	string localName = "view";
+	localName += view.getIDString(sampling.mViewIdx);
+	localName += ".mvei";
+
+	const Path fileName = Path::appendChild(imagesFolder, localName);
+	Image::saveAsMVEFloatImage(fileName, mViewResolution, sampling.mDepthMap.data(), false, false);
+}
+
 bool SyntheticScene::fill(vector<Real> &depthMap, vector<Vector3> &hitsMap, vector<uint32> &pixelToHitMap,
 	RayTracer &rayTracer, uint32 &hitCount, const PinholeCamera &camera)
 {
 	const Matrix3x3 HPSToNNRayDirWS = camera.computeHPSToNNRayDirWS(mViewResolution, true);
 	const Vector3 camPosWS(camera.getPosition().x, camera.getPosition().y, camera.getPosition().z);
 	const Real minDepthSq = mMinSampleDistance * mMinSampleDistance;
-	const uint32 pixelCount = mViewResolution.getElementCount();
+	const int64 pixelCount = mViewResolution.getElementCount();
 
 	// find surface points
 	hitCount = 0;
 	rayTracer.renderFromView(NULL, mViewResolution, camera, HPSToNNRayDirWS, true);
 
-	// fill depth & index map
-	for (uint32 pixelIdx = 0; pixelIdx < pixelCount; ++pixelIdx)
+	// fill depth & hit map
+	bool tooClose = false;
+
+	#pragma omp parallel for
+	for (int64 i = 0; i < pixelCount; ++i)
 	{
 		// initial invalid value
+		const uint32 pixelIdx = (uint32) i;
 		depthMap[pixelIdx] = -REAL_MAX;
 
 		// valid hit?
@@ -309,10 +360,23 @@ bool SyntheticScene::fill(vector<Real> &depthMap, vector<Vector3> &hitsMap, vect
 
 		const Real lengthSq = (hitPosWS - camPosWS).getLengthSquared();
 		if (lengthSq < minDepthSq)
-			return false;
+		{
+			#pragma omp atomic write
+			tooClose = true;
+			continue;
+		}
+
+		depthMap[pixelIdx] = sqrtr(lengthSq);
+	}
+	if (tooClose)
+		return false;
+
+	// hit indices in pixel order
+	for (uint32 pixelIdx = 0; pixelIdx < pixelCount; ++pixelIdx)
+	{
+		if (-REAL_MAX == depthMap[pixelIdx])
+			continue;
 
-		const Real depth = sqrtr(lengthSq);
-		depthMap[pixelIdx] = depth;
 		pixelToHitMap[pixelIdx] = hitCount;
 		++hitCount;
 	}
@@ -320,9 +384,10 @@ bool SyntheticScene::fill(vector<Real> &depthMap, vector<Vector3> &hitsMap, vect
 	return true;
 }
 
-void SyntheticScene::addNoise(vector<Vector3> &hitsMap, vector<Real> &depthMap, const Vector3 &camPosWS)
-{	
+void SyntheticScene::drawNoise(vector<Real> &noiseFactors) const
+{
 	// no noise?
+	noiseFactors.clear();
 	if (Math::EPSILON >= mDepthMapNoise[0] && Math::EPSILON >= mDepthMapNoise[1])
 		return;
 
@@ -331,10 +396,23 @@ void SyntheticScene::addNoise(vector<Vector3> &hitsMap, vector<Real> &depthMap,
 	RandomManager &manager = RandomManager::getSingleton();
 	normal_distribution<Real> depthMapNoise(mDepthMapNoise[0], mDepthMapNoise[1]);
 
+	// one noise factor for each pixel, valid depth or not
+	noiseFactors.resize(pixelCount);
+	for (uint32 pixelIdx = 0; pixelIdx < pixelCount; ++pixelIdx)
+		noiseFactors[pixelIdx] = manager.getNormal(depthMapNoise);
+}
+
+void SyntheticScene::addNoise(vector<Vector3> &hitsMap, vector<Real> &depthMap, const vector<Real> &noiseFactors, const Vector3 &camPosWS) const
+{	
+	// no noise?
+	if (noiseFactors.empty())
+		return;
+
 	// add noise to each valid depth value
+	const uint32 pixelCount = mViewResolution.getElementCount();
 	for (uint32 pixelIdx = 0; pixelIdx < pixelCount; ++pixelIdx)
 	{
-		const Real noiseFactor = manager.getNormal(depthMapNoise);
+		const Real noiseFactor = noiseFactors[pixelIdx];
 
 		// valid depth?
 		Vector3 &hitPosWS = hitsMap[pixelIdx];
@@ -384,45 +462,176 @@ void SyntheticScene::saveToFile(const vector<Real> &depthMap, const uint32 viewI
 	pixels = NULL;
 }
 
-void SyntheticScene::addToSamples(vector<vector<uint32>> &vertexNeighbors, vector<uint32> &indices, vector<uint32> &hitToVertexLinks,
-	const vector<Vector3> &hitsMap, const vector<Real> &depthMap, const vector<uint32> &pixelToHitMap, const uint32 hitCount, const uint32 viewIdx)
+FlexibleMesh *SyntheticScene::createSampleTriangulation(ViewSampling &sampling) const
 {
-	// reserve memory for the new samples
-	const uint32 oldSampleCount = mSamples->getCount();
-	const uint32 newSampleCount = hitCount + oldSampleCount;
-	mSamples->reserve(newSampleCount);
-
 	// K^1 matrix (inverse kamera calibration)
-	const PinholeCamera &camera = mViews[viewIdx]->getCamera();
+	const PinholeCamera &camera = mViews[sampling.mViewIdx]->getCamera();
 	const Matrix3x3 invProj = camera.computeInverseProjectionMatrix();
 	const Matrix3x3 invViewPort = camera.computeInverseViewportMatrix(mViewResolution, true);
 	const Matrix3x3 pixelToViewSpace = invViewPort * invProj;
 
 	// create a depth map triangulation to compute samples' properties
-	FlexibleMesh *triangulation = triangulate(vertexNeighbors, indices, hitToVertexLinks,
-		hitsMap, depthMap, pixelToHitMap, hitCount, pixelToViewSpace);
+	FlexibleMesh *triangulation = triangulate(sampling.mVertexNeighbors, sampling.mIndices, sampling.mHitToVertexLinks,
+		sampling.mHitsMap, sampling.mDepthMap, sampling.mPixelToHitMap, sampling.mHitCount, pixelToViewSpace);
 	triangulation->computeNormalsWeightedByAngles();
-	FlexibleMesh::computeVertexScales(triangulation->getScales(), vertexNeighbors.data(), triangulation->getPositions(), triangulation->getVertexCount());
+	FlexibleMesh::computeVertexScales(triangulation->getScales(), sampling.mVertexNeighbors.data(), triangulation->getPositions(), triangulation->getVertexCount());
+
+	return triangulation;
+}
+
+void SyntheticScene::addToSamples(const FlexibleMesh &triangulation, const uint32 viewIdx)
+{
+	// reserve memory for the new samples
+	const uint32 vertexCount = triangulation.getVertexCount();
+	const uint32 oldSampleCount = mSamples->getCount();
+	const uint32 newSampleCount = vertexCount + oldSampleCount;
+	mSamples->reserve(newSampleCount);
 
 	// add triangulation to all other samples
 	//const uint32 pixelCount = mViewResolution.getElementCount();
-	const Vector3 *colors = triangulation->getColors();
-	const Vector3 *normals = triangulation->getNormals();
-	const Vector3 *positions = triangulation->getPositions();
-	const Real *scales = triangulation->getScales();
+	const Vector3 *colors = triangulation.getColors();
+	const Vector3 *normals = triangulation.getNormals();
+	const Vector3 *positions = triangulation.getPositions();
+	const Real *scales = triangulation.getScales();
 	const Real confidence = 1.0f; // todo: how to get reasonable confidence values?
-	const uint32 vertexCount = triangulation->getVertexCount();
+
+	// the depth map view is the first parent view, further views are linked afterwards (see linkSamplesToVisibleViews)
+	vector<uint32> parentViewIDs(mViewsPerSample, View::INVALID_ID);
+	parentViewIDs[0] = viewIdx;
 
 	for (uint32 vertexIdx = 0, nextSampleIdx = oldSampleCount; vertexIdx < vertexCount; ++vertexIdx, ++nextSampleIdx)
 	{
 		mSamples->addSample();
 		mSamples->setSample(nextSampleIdx,
 			colors[vertexIdx], normals[vertexIdx], positions[vertexIdx], 
-			confidence, scales[vertexIdx], &viewIdx);
+			confidence, scales[vertexIdx], parentViewIDs.data());
+	}
+}
+
+void SyntheticScene::linkSamplesToVisibleViews(RayTracer &rayTracer)
+{
+	cout << "SyntheticScene: Linking samples to up to " << mViewsPerSample << " views which see them." << endl;
+
+	// scratch data for all views
+	const uint32 sampleCount = mSamples->getCount();
+	vector<uint32> candidates;
+	vector<Vector3> rayTargets;
+	vector<uint8> candidateFlags(sampleCount);
+
+	candidates.reserve(sampleCount);
+	rayTargets.reserve(sampleCount);
+
+	// one view after another for deterministic parent view orders
+	const uint32 viewCount = (uint32) mViews.size();
+	for (uint32 viewIdx = 0; viewIdx < viewCount; ++viewIdx)
+		linkSamplesToView(candidates, rayTargets, candidateFlags, rayTracer, viewIdx);
+}
+
+void SyntheticScene::linkSamplesToView(vector<uint32> &candidates, vector<Vector3> &rayTargets, vector<uint8> &candidateFlags,
+	RayTracer &rayTracer, const uint32 viewIdx)
+{
+	// view data
+	const View &view = *mViews[viewIdx];
+	const PinholeCamera &camera = view.getCamera();
+	const Vector3 camPosWS = view.getPositionWS();
+	const Vector3 viewDirection = view.getViewDirection();
+	const Matrix3x3 HPSToNNRayDirWS = camera.computeHPSToNNRayDirWS(mViewResolution, true);
+	const Real minDepthSq = mMinSampleDistance * mMinSampleDistance;
+	const Real maxX = mViewResolution[0] - 0.5f;
+	const Real maxY = mViewResolution[1] - 0.5f;
+
+	// pixel coordinates of a ray direction d: (x, y, 1) * HPSToNNRayDirWS ~ d solved via Cramer's rule (determinant cancels out)
+	const Vector3 row0(HPSToNNRayDirWS.m00, HPSToNNRayDirWS.m01, HPSToNNRayDirWS.m02);
+	const Vector3 row1(HPSToNNRayDirWS.m10, HPSToNNRayDirWS.m11, HPSToNNRayDirWS.m12);
+	const Vector3 row2(HPSToNNRayDirWS.m20, HPSToNNRayDirWS.m21, HPSToNNRayDirWS.m22);
+	const Vector3 toX = row1.crossProduct(row2);
+	const Vector3 toY = row2.crossProduct(row0);
+	const Vector3 toW = row0.crossProduct(row1);
+
+	// sample data
+	const Vector3 *normals = mSamples->mNormals.data();
+	const Vector3 *positions = mSamples->mPositions.data();
+	uint32 *parentViews = mSamples->mParentViews.data();
+	const uint32 viewsPerSample = mViewsPerSample;
+	const int64 sampleCount = mSamples->getCount();
+
+	// find samples with free parent view slots within the view frustum which face the view
+	#pragma omp parallel for
+	for (int64 i = 0; i < sampleCount; ++i)
+	{
+		const uint32 sampleIdx = (uint32) i;
+		const uint32 *sampleParents = parentViews + sampleIdx * viewsPerSample;
+		candidateFlags[sampleIdx] = 0;
+
+		// free parent view slot & not yet linked?
+		if (View::INVALID_ID != sampleParents[viewsPerSample - 1])
+			continue;
+
+		bool linked = false;
+		for (uint32 parentIdx = 0; parentIdx < viewsPerSample && !linked; ++parentIdx)
+			linked = (viewIdx == sampleParents[parentIdx]);
+		if (linked)
+			continue;
+
+		// in front of the camera, not too close & facing the view?
+		const Vector3 toSample = positions[sampleIdx] - camPosWS;
+		if (toSample.dotProduct(viewDirection) <= 0.0f || toSample.getLengthSquared() < minDepthSq)
+			continue;
+		if (toSample.dotProduct(normals[sampleIdx]) >= 0.0f)
+			continue;
+
+		// within the image?
+		const Real w = toSample.dotProduct(toW);
+		if (0.0f == w)
+			continue;
+
+		const Real x = toSample.dotProduct(toX) / w;
+		const Real y = toSample.dotProduct(toY) / w;
+		if (x < -0.5f || x >= maxX || y < -0.5f || y >= maxY)
+			continue;
+
+		candidateFlags[sampleIdx] = 1;
+	}
+
+	// gather occlusion test segments in sample order
+	candidates.clear();
+	rayTargets.clear();
+
+	const Real segmentFactor = 1.0f - mRelativeVisibilityTolerance;
+	for (uint32 sampleIdx = 0; sampleIdx < sampleCount; ++sampleIdx)
+	{
+		if (!candidateFlags[sampleIdx])
+			continue;
+
+		candidates.push_back(sampleIdx);
+		rayTargets.push_back(camPosWS + (positions[sampleIdx] - camPosWS) * segmentFactor);
 	}
 
-	delete triangulation;
-	triangulation = NULL;
+	const int64 candidateCount = candidates.size();
+	if (0 == candidateCount)
+		return;
+
+	// link visible samples
+	rayTracer.findOcclusions(rayTargets.data(), (uint32) candidateCount, camPosWS, false);
+
+	#pragma omp parallel for
+	for (int64 i = 0; i < candidateCount; ++i)
+	{
+		const uint32 rayIdx = (uint32) i;
+		if (rayTracer.isOccludedRay(rayIdx))
+			continue;
+
+		// first free slot
+		uint32 *sampleParents = parentViews + candidates[rayIdx] * viewsPerSample;
+		for (uint32 parentIdx = 1; parentIdx < viewsPerSample; ++parentIdx)
+		{
+			if (View::INVALID_ID != sampleParents[parentIdx])
+				continue;
+
+			sampleParents[parentIdx] = viewIdx;
+			break;
+		}
+	}
 }
 
 FlexibleMesh *SyntheticScene::triangulate(vector<vector<uint32>> &vertexNeighbors, vector<uint32> &indices, vector<uint32> &hitToVertexLinks,
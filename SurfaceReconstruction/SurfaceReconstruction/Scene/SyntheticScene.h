@@ -30,6 +30,26 @@ namespace SurfaceReconstruction
 		/** Frees all synthetic scene data. */
 		virtual ~SyntheticScene();
 
+	private:
+		/// Depth map, noise & triangulation of a single view. Views are turned into samples concurrently with one such object per thread.
+		struct ViewSampling
+		{
+		public:
+			inline ViewSampling();
+
+		public:
+			std::vector<std::vector<uint32>> mVertexNeighbors;	/// Scratch data for the triangulation.
+			std::vector<Math::Vector3> mHitsMap;
+			std::vector<Real> mDepthMap;
+			std::vector<Real> mNoiseFactors;					/// Relative depth noise for each pixel or empty if there is no noise.
+			std::vector<uint32> mHitToVertexLinks;				/// Scratch data for the triangulation.
+			std::vector<uint32> mIndices;						/// Scratch data for the triangulation.
+			std::vector<uint32> mPixelToHitMap;
+			FlexibleMesh *mTriangulation;						/// Noisy depth map triangulation which defines the samples of the view.
+			uint32 mHitCount;
+			uint32 mViewIdx;
+		};
+
 	private:
 		/** Copy constructor is forbidden. Don't use it. */
 		inline SyntheticScene(const SyntheticScene &other);
@@ -37,12 +57,14 @@ namespace SurfaceReconstruction
 		/** Assignment operator is forbidden. Don't use it.*/
 		inline SyntheticScene &operator =(const SyntheticScene &rhs);
 		
-		/** todo */
-		void addNoise(std::vector<Math::Vector3> &hitsWS, std::vector<Real> &depthMap, const Math::Vector3 &camPosWS);
+		/** Moves the hits of all valid depth map pixels along their view rays according to noiseFactors. (See drawNoise.) */
+		void addNoise(std::vector<Math::Vector3> &hitsWS, std::vector<Real> &depthMap, const std::vector<Real> &noiseFactors, const Math::Vector3 &camPosWS) const;
 		
-		void addToSamples(std::vector<std::vector<uint32>> &vertexNeighbors, std::vector<uint32> &indices, std::vector<uint32> &hitToVertexLinks,
-			const std::vector<Math::Vector3> &hitsWS, const std::vector<Real> &depthMap, const std::vector<uint32> &pixelToHitMap,
-			const uint32 hitCount, const uint32 viewIdx);
+		/** Appends a sample for each vertex of the depth map triangulation of view viewIdx. */
+		void addToSamples(const FlexibleMesh &triangulation, const uint32 viewIdx);
+
+		/** Triangulates the depth map of sampling and computes normals and scales of the triangulation vertices. */
+		FlexibleMesh *createSampleTriangulation(ViewSampling &sampling) const;
 
 		/** todo */
 		View *createSyntheticView(const uint32 viewIdx);
@@ -54,6 +76,9 @@ namespace SurfaceReconstruction
 		@return Returns the number of created samples. */
 		uint32 createSamples(View &view, const uint32 viewID);
 
+		/** Draws the random depth noise factors for all pixels of one view or clears noiseFactors if there is no noise. */
+		void drawNoise(std::vector<Real> &noiseFactors) const;
+
 		/** todo */
 		bool fill(std::vector<Real> &depthMap, std::vector<Math::Vector3> &hitsMap, std::vector<uint32> &pixelToHitMap,
 			RayTracer &rayTracer, uint32 &hitCount, const Graphics::PinholeCamera &camera);
@@ -62,6 +87,26 @@ namespace SurfaceReconstruction
 		@param fileName Describes where to create the scene, what data to load, how to create the scene, etc.*/
 		virtual bool getParameters(const Storage::Path &fileName);
 
+		/** Links each sample to further views which see it until it has up to mViewsPerSample parent views.
+			Views are tested in ascending order so that the links do not depend on thread scheduling.
+		@param rayTracer Must contain the ground truth for the visibility tests. */
+		void linkSamplesToVisibleViews(RayTracer &rayTracer);
+
+		/** Adds view viewIdx as parent view to all samples with free parent view slots which are within the view frustum, face the view and are not occluded by the ground truth.
+			A sample is not occluded if the ground truth does not intersect the line segment from the camera to the sample shortened by mRelativeVisibilityTolerance times its depth.
+		@param candidates Scratch data, is filled with the indices of the samples which are tested for occlusion.
+		@param rayTargets Scratch data, is filled with the end points of the occlusion test line segments.
+		@param candidateFlags Scratch data with one entry per sample. */
+		void linkSamplesToView(std::vector<uint32> &candidates, std::vector<Math::Vector3> &rayTargets, std::vector<uint8> &candidateFlags,
+			RayTracer &rayTracer, const uint32 viewIdx);
+
+		/** Adds noise to the depth map of sampling, triangulates it and saves it as image to imagesFolder. Thread safe for different sampling objects. */
+		void processSyntheticView(ViewSampling &sampling, const Storage::Path &imagesFolder) const;
+
+		/** Creates random views for viewIdx until one of them sees the ground truth and stores its depth map and noise in sampling.
+			Random numbers are used in the same order as for processing one view after another. */
+		void renderSyntheticView(ViewSampling &sampling, RayTracer &rayTracer, const uint32 viewIdx);
+
 		/** todo */
 		void saveToFile(const std::vector<Real> &depthMap, const uint32 viewIdx, const bool withNoise) const;
 
@@ -97,14 +142,22 @@ namespace SurfaceReconstruction
 
 		Real mMinSampleViewAngle;			/// Defines the minimum angle between sample tangent and view vector that is required for Sample object creation.
 		Real mMinSampleDistance;			/// Defines the mininum distance between a surface and a camera that is required for Sample creation (per sample).
+		Real mRelativeVisibilityTolerance;	/// A sample is seen by a view if there is no ground truth surface in front of it closer than (1 - mRelativeVisibilityTolerance) * sample depth.
 		uint32 mSeed;						/// Defines what random numbers are generated to produce the sample noise.
 		uint32 mMaxViewCount;				/// Defines how many projectice capturing views are created for sample point generation at maximum.
+		uint32 mViewsPerSample;				/// Each sample is linked to its depth map view and up to mViewsPerSample - 1 further views which see it.
 	};
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	///   inline function definitions   ////////////////////////////////////////////////////////////////////////////////////
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+	inline SyntheticScene::ViewSampling::ViewSampling() :
+		mTriangulation(NULL), mHitCount(0), mViewIdx(0)
+	{
+
+	}
+
 	inline SyntheticScene::SyntheticScene(const SyntheticScene &other) :
 		Scene(other.mRefinerObservers)
 	{
@@ -8,6 +8,7 @@
  */
 
 #include "Platform/Storage/File.h"
+#include "SurfaceReconstruction/Scene/MappedFile.h"
 #include "SurfaceReconstruction/Scene/Tree/DualCells.h"
 #include "SurfaceReconstruction/Scene/Tree/Leaves.h"
 #include "SurfaceReconstruction/Scene/Tree/Nodes.h"
@@ -363,6 +364,18 @@ void DualCells::loadFromFile(const Path &fileName)
 	uint32 indexCount = 0;
 	clear();
 
+	// page aligned format?
+	if (MappedFile::isMappedFile(fileName))
+	{
+		const MappedFile file(fileName, FILE_VERSION);
+		indexCount = *file.getSection<uint32>(0, 1);
+		mIndices.resize(indexCount);
+		file.copySection(mIndices.data(), 1, sizeof(uint32) * indexCount);
+
+		cout << "Loaded " << getCellCount() << " dual cells.\n";
+		return;
+	}
+
 	// open file
 	File file(fileName, File::OPEN_READING, true, FILE_VERSION);
 
@@ -380,6 +393,15 @@ void DualCells::saveToFile(const Path &fileName) const
 {
 	const uint32 indexCount = getIndexCount();
 
+	// page aligned format?
+	if (MappedFile::isSavingEnabled())
+	{
+		const void *sections[] = { &indexCount, mIndices.data() };
+		const uint64 byteCounts[] = { sizeof(uint32), sizeof(uint32) * indexCount };
+		MappedFile::save(fileName, FILE_VERSION, sections, byteCounts, 2);
+		return;
+	}
+
 	File file(fileName, File::CREATE_WRITING, true, FILE_VERSION);
 	file.write(&indexCount, sizeof(uint32), 1);
 	file.write(mIndices.data(), sizeof(uint32), indexCount);
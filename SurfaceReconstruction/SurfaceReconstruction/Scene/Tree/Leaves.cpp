@@ -7,10 +7,13 @@
  * of the BSD 3-Clause license. See the License.txt file for details.
  */
 
+#include "Platform/FailureHandling/FileCorruptionException.h"
 #include "Platform/Storage/File.h"
+#include "SurfaceReconstruction/Scene/MappedFile.h"
 #include "SurfaceReconstruction/Scene/Tree/Leaves.h"
 #include "SurfaceReconstruction/Scene/Tree/Nodes.h"
 
+using namespace FailureHandling;
 using namespace Math;
 using namespace Platform;
 using namespace std;
@@ -36,6 +39,7 @@ Leaves::Leaves(const Nodes &nodes, const Path &fileName) :
 
 Leaves::Leaves(const Nodes &nodes) :
 	mNodes(nodes),
+	mMappedFile(NULL),
 	mNeighborsOffsets(NULL),
 	mNeighbors(NULL)
 {
@@ -193,9 +197,17 @@ void Leaves::clear()
 	// leaves
 	mScopes.clear();
 
-	// neighbors
-	delete [] mNeighborsOffsets;
-	delete [] mNeighbors;
+	// neighbors are either owned by the mapped file or allocated
+	if (mMappedFile)
+	{
+		delete mMappedFile;
+		mMappedFile = NULL;
+	}
+	else
+	{
+		delete [] mNeighborsOffsets;
+		delete [] mNeighbors;
+	}
 	mNeighborsOffsets = NULL;
 	mNeighbors = NULL;
 }
@@ -232,6 +244,13 @@ void Leaves::loadFromFile(const Path &fileName)
 {
 	clear();
 
+	// page aligned format which can be used in place?
+	if (MappedFile::isMappedFile(fileName))
+	{
+		loadFromMappedFile(fileName);
+		return;
+	}
+
 	File file(fileName, File::OPEN_READING, true, FILE_VERSION);
 
 	// load element counts: node count, leaf count, total neighbor count
@@ -259,15 +278,35 @@ void Leaves::loadFromFile(const Path &fileName)
 	file.read(mNeighbors, sizeof(uint32) * totalNeighborCount, sizeof(uint32), totalNeighborCount);
 }
 
+void Leaves::loadFromMappedFile(const Path &fileName)
+{
+	mMappedFile = new MappedFile(fileName, FILE_VERSION);
+
+	// load element counts: node count, leaf count, total neighbor count
+	const uint32 *counts = mMappedFile->getSection<uint32>(0, 3);
+	const uint32 nodeCount = counts[0];
+	const uint32 leafCount = counts[1];
+	const uint32 totalNeighborCount = counts[2];
+	if (nodeCount != mNodes.getCount())
+		throw FileCorruptionException("Leaves file does not match the loaded nodes.", fileName);
+
+	// copy links & leaves
+	mNodeToLeafLinks.resize(nodeCount);
+	mScopes.resize(leafCount);
+	mMappedFile->copySection(mNodeToLeafLinks.data(), 1, sizeof(uint32) * nodeCount);
+	mMappedFile->copySection(mScopes.data(), 2, sizeof(Scope) * leafCount);
+
+	// use leaf neighbohoods in place
+	mNeighborsOffsets = mMappedFile->getSection<uint32>(3, leafCount + 1);
+	mNeighbors = mMappedFile->getSection<uint32>(4, totalNeighborCount);
+}
+
 void Leaves::saveToFile(const Path &fileName) const
 {
 	// is there anything to save?
 	if (mScopes.empty())
 		return;
 
-	// create file with version & AABB, mOrderedSamples
-	File file(fileName, File::CREATE_WRITING, true, FILE_VERSION);
-
 	// save element counts
 	const uint32 nodeCount = mNodes.getCount();
 	const uint32 leafCount = getCount();
@@ -279,6 +318,23 @@ void Leaves::saveToFile(const Path &fileName) const
 		totalNeighborCount
 	};
 
+	// page aligned format which can be used in place when it is loaded?
+	if (MappedFile::isSavingEnabled())
+	{
+		const void *sections[] = { counts, mNodeToLeafLinks.data(), mScopes.data(), mNeighborsOffsets, mNeighbors };
+		const uint64 byteCounts[] =
+		{
+			sizeof(uint32) * 3, sizeof(uint32) * nodeCount, sizeof(Scope) * leafCount,
+			sizeof(uint32) * (leafCount + 1), sizeof(uint32) * totalNeighborCount
+		};
+
+		MappedFile::save(fileName, FILE_VERSION, sections, byteCounts, 5);
+		return;
+	}
+
+	// create file with version & AABB, mOrderedSamples
+	File file(fileName, File::CREATE_WRITING, true, FILE_VERSION);
+
 	file.write(counts, sizeof(uint32), 3);
 
 	// save links
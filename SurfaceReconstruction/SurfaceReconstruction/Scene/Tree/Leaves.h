@@ -19,6 +19,7 @@
 namespace SurfaceReconstruction
 {
 	// forward declarations
+	class MappedFile;
 	class Nodes;
 
 	class Leaves
@@ -74,6 +75,9 @@ namespace SurfaceReconstruction
 		void createScopes(const Scope &rootScope);
 		void gatherScopes(const Scope &scope);
 
+		/** Copies links & scopes from a mapped file and uses the neighbor arrays in place. (See MappedFile.) */
+		void loadFromMappedFile(const Storage::Path &fileName);
+
 		// leaf neighbors
 		void createNeighborsEdges(const Scope &rootScope);
 		uint32 getUnresponsibleEdgeNeighbor(const Scope &root, const Scope &leaf, const uint32 sideIdx) const;
@@ -85,6 +89,7 @@ namespace SurfaceReconstruction
 
 	private:
 		const Nodes &mNodes;
+		MappedFile *mMappedFile;				/// Owns mNeighborsOffsets and mNeighbors if they were loaded from a mapped file. Otherwise NULL.
 
 		// links: standard tree nodes -> mLeaves
 		std::vector<uint32> mNodeToLeafLinks;	/// One index for each node as link to its corresponding leaf node in mLeaves or Nodes::INVALID_NODE_IDX if the node is not a leaf.
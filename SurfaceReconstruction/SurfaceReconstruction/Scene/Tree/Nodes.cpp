@@ -10,6 +10,7 @@
 #include "CollisionDetection/CollisionDetection.h"
 #include "Platform/FailureHandling/Exception.h"
 #include "Platform/Storage/File.h"
+#include "SurfaceReconstruction/Scene/MappedFile.h"
 #include "SurfaceReconstruction/Scene/Samples.h"
 #include "SurfaceReconstruction/Scene/Scene.h"
 #include "SurfaceReconstruction/Scene/Tree/Nodes.h"
@@ -759,8 +760,27 @@ Nodes::Nodes(const Path &fileName)
 
 void Nodes::loadFromFile(const Path &fileName)
 {
-	// clean start & open file
+	// clean start
 	clear();
+
+	// page aligned format?
+	if (MappedFile::isMappedFile(fileName))
+	{
+		// load node count & reserve memory
+		const MappedFile file(fileName, FILE_VERSION);
+		const uint32 nodeCount = *file.getSection<uint32>(0, 1);
+		resize(nodeCount);
+
+		// copy nodes
+		const uint64 nodeArraySize = sizeof(uint32) * nodeCount;
+		file.copySection(mChildren.data(), 1, nodeArraySize);
+		file.copySection(mParents.data(), 2, nodeArraySize);
+		file.copySection(mSamplesPerNodes.data(), 3, nodeArraySize);
+		file.copySection(mSampleStartIndices.data(), 4, nodeArraySize);
+		return;
+	}
+
+	// open file
 	File file(fileName, File::OPEN_READING, true, FILE_VERSION);
 
 	// load node count & reserve memory
@@ -782,11 +802,21 @@ void Nodes::saveToFile(const Path &fileName) const
 	if (mParents.empty())
 		return;
 
+	// page aligned format?
+	const uint32 nodeCount = getCount();
+	if (MappedFile::isSavingEnabled())
+	{
+		const uint64 nodeArraySize = sizeof(uint32) * nodeCount;
+		const void *sections[] = { &nodeCount, mChildren.data(), mParents.data(), mSamplesPerNodes.data(), mSampleStartIndices.data() };
+		const uint64 byteCounts[] = { sizeof(uint32), nodeArraySize, nodeArraySize, nodeArraySize, nodeArraySize };
+		MappedFile::save(fileName, FILE_VERSION, sections, byteCounts, 5);
+		return;
+	}
+
 	// create file with version & AABB, mOrderedSamples
 	File file(fileName, File::CREATE_WRITING, true, FILE_VERSION);
 
 	// save node count
-	const uint32 nodeCount = getCount();
 	file.write(&nodeCount, sizeof(uint32), 1);
 
 	// save nodes
@@ -16,7 +16,11 @@
 #include "Platform/FailureHandling/FileCorruptionException.h"
 #include "Platform/ParametersManager.h"
 #include "Platform/Storage/File.h"
+#include "SurfaceReconstruction/Geometry/SIMDReal.h"
+#include "SurfaceReconstruction/Scene/FixedPointSum.h"
+#include "SurfaceReconstruction/Scene/MappedFile.h"
 #include "SurfaceReconstruction/Scene/Scene.h"
+#include "SurfaceReconstruction/Scene/StageProfiler.h"
 #include "SurfaceReconstruction/Scene/Tree/Leaves.h"
 #include "SurfaceReconstruction/Scene/Tree/LeavesIterator.h"
 #include "SurfaceReconstruction/Scene/Tree/SphereNodesChecker.h"
@@ -70,6 +74,7 @@ using namespace Utilities;
 
 // constants
 const uint32 Occupancy::FILE_VERSION = 0;
+const uint32 Occupancy::KERNEL_BLOCK_SIZE = 32;
 const uint32 Occupancy::MAX_DEPTH_DIFFERENCE = 3;
 
 const uint32 Occupancy::OMP_PRIOR_LEAF_BATCH_SIZE = 0x1 << 9;
@@ -147,13 +152,8 @@ void Occupancy::updateKernels(const bool forRemoval, const DataType dataType, co
 	const Samples &samples = scene.getSamples();
 	const Tree &tree = *scene.getTree();
 
-	// flag to be set for leaves which are influenced by the kernels
-	NodeStateFlag leafFlag;
-	if (EMPTINESS == dataType)
-		leafFlag = NODE_FLAG_EMPTINESS;
-	else if (SAMPLENESS == dataType)
-		leafFlag = NODE_FLAG_SAMPLENESS;
-	else
+	// there are only kernels for emptiness & sampleness (see addKernels)
+	if (EMPTINESS != dataType && SAMPLENESS != dataType)
 		throw Exception("Case is not implemented.");
 
 	// init lengths & counts for all threads
@@ -167,8 +167,21 @@ void Occupancy::updateKernels(const bool forRemoval, const DataType dataType, co
 			counts[threadIdx] = 0.0f;
 	}
 
+	// deterministic mode: sum up all changes in fixed point and apply them at once afterwards
+	const bool deterministic = FixedPointSum::isDeterministicModeEnabled();
+	const int64 leafCount = tree.getLeaves().getCount();
+	FixedPointSum coneCountChange;
+	if (deterministic)
+	{
+		mFixedConeLengths = new FixedPointSum[leafCount];
+		mFixedKernelSums = new FixedPointSum[leafCount];
+	}
+
 	// evaluate each view cone kernel for dataType PDF
 	int64 viewConeCount = (chosenSamples ? samples.getViewsPerSample() * chosenSampleCount : samples.getMaxViewConeCount());
+	StageProfiler::Scope profilerScope(EMPTINESS == dataType ? "EmptinessKernels" : "SamplenessKernels", "cones");
+	profilerScope.addItems(viewConeCount);
+
 	#pragma omp parallel for schedule(dynamic, OMP_VIEW_CONE_BATCH_SIZE)
 	for (int64 viewConeIdx = 0; viewConeIdx < viewConeCount; ++viewConeIdx)
 	{
@@ -206,39 +219,68 @@ void Occupancy::updateKernels(const bool forRemoval, const DataType dataType, co
 		const Real weightedConeLength = (forRemoval ? -1.0f : 1.0f) * confidence * checker.getLength();
 		if (EMPTINESS == dataType)
 		{
-			if (forRemoval)
-				counts[threadIdx] -= confidence;
+			const Real countChange = (forRemoval ? -confidence : confidence);
+			if (deterministic)
+				coneCountChange.add(countChange);
 			else
-				counts[threadIdx] += confidence;
+				counts[threadIdx] += countChange;
 		}
 
-		// update sums for all overlapping nodes
+		// update sums for all overlapping nodes - gather them in blocks to evaluate the kernels block by block
+		Vector3 leafCenters[KERNEL_BLOCK_SIZE];
+		uint32 leafIndices[KERNEL_BLOCK_SIZE];
+		uint32 nodeIndices[KERNEL_BLOCK_SIZE];
+		uint32 blockSize = 0;
+
 		for (LeavesIterator it(tree, &checker); !it.isAtTheEnd(); ++it)
 		{
 			// get scope data
 			const Scope scope = it.getScope();
-			const Vector3 leafCenter = scope.getCenterPosition();
-			const uint32 leafIdx = it.getLeafIndex();
+			leafCenters[blockSize] = scope.getCenterPosition();
+			leafIndices[blockSize] = it.getLeafIndex();
+			nodeIndices[blockSize] = it.getNodeIndex();
 
-			// update values for the found leaf
-			Real &targetSumOfKernels = mKernelSums[dataType][leafIdx];
-			if (addKernel(targetSumOfKernels, leafCenter, checker, dataType, confidence, forRemoval))
-			{
-				// update sum of lengths
-				Real &targetSumOfLengths = mConeLengths[dataType][leafIdx];
-				#pragma omp atomic
-					targetSumOfLengths += weightedConeLength;
+			// full block?
+			if (++blockSize < KERNEL_BLOCK_SIZE)
+				continue;
 
-				if (!forRemoval)
-					mNodeStates[it.getNodeIndex()] |= leafFlag;
-			}
+			addKernels(leafIndices, nodeIndices, leafCenters, blockSize, checker, dataType, confidence, weightedConeLength, forRemoval);
+			blockSize = 0;
 		}
+
+		// remaining leaves
+		if (blockSize > 0)
+			addKernels(leafIndices, nodeIndices, leafCenters, blockSize, checker, dataType, confidence, weightedConeLength, forRemoval);
 	}
 	
 	// update total count (sampleness cone count = emptiness cone count) 
 	if (EMPTINESS == dataType)
-		for (uint32 threadIdx = 0; threadIdx < threadCount; ++threadIdx)
-			mConeCount += counts[threadIdx];
+	{
+		if (deterministic)
+			mConeCount += coneCountChange.getValue();
+		else
+			for (uint32 threadIdx = 0; threadIdx < threadCount; ++threadIdx)
+				mConeCount += counts[threadIdx];
+	}
+
+	// deterministic mode: apply summed changes
+	if (deterministic)
+	{
+		Real *kernelSums = mKernelSums[dataType];
+		Real *coneLengths = mConeLengths[dataType];
+
+		#pragma omp parallel for
+		for (int64 leafIdx = 0; leafIdx < leafCount; ++leafIdx)
+		{
+			kernelSums[leafIdx] += mFixedKernelSums[leafIdx].getValue();
+			coneLengths[leafIdx] += mFixedConeLengths[leafIdx].getValue();
+		}
+
+		delete [] mFixedConeLengths;
+		delete [] mFixedKernelSums;
+		mFixedConeLengths = NULL;
+		mFixedKernelSums = NULL;
+	}
 	
 	// free resources
 	delete [] counts;
@@ -276,73 +318,194 @@ bool Occupancy::getViewConeData(Vector3 &viewPosWS, uint32 &sampleIdx,
 	return true;
 }
 
-bool Occupancy::addKernel(Real &targetKernelSum,
-	const Vector3 &evaluationPos, const ObliqueCircularCone &viewCone,
-	const DataType dataType, const Real sampleConfidence, const bool negative) const
+void Occupancy::addKernels(const uint32 *leafIndices, const uint32 *nodeIndices, const Vector3 *leafCenters, const uint32 count,
+	const ObliqueCircularCone &viewCone, const DataType dataType,
+	const Real sampleConfidence, const Real weightedConeLength, const bool negative)
 {
-	// add kernel value to target evaluation position based on
+	// add kernel values to the leaves based on
 	// 1. a function along view ray from view center to sample center
-	// 2. a function within a projective circular sample disc (PCD) through leaf center
-
-	// where does the plane <x - evaluationPos, sampleNormal> = 0 intersect the view line?
-	const Real tCompleteCone = viewCone.getTCompleteCone(evaluationPos);
-	const Real tCutCone = viewCone.getTCutCone(tCompleteCone);
-
-	// is positionWS in front of or behind the view cone?
-	if (tCutCone < 0.0f|| tCutCone >= 1.0f)
-		return false;
-
-	// => via z: get the projective circular disc (PCD) around the view ray which is parallel to the sample normal and goes through positionWS
-	// (PCD = projection of the circular sample disc (CSD) (CSD: centered at sample, orthogonal to sample normal, size = maxEndConeRadius)
-	const Vector3 &viewToEnd = viewCone.getApexToEnd();
-	const Vector3 PCDCenter = viewCone.getApex() + viewToEnd * tCompleteCone;
-	const Real PCDRadius = viewCone.getEndRadius() * tCompleteCone;
-
-	// is positionWS within PCD and view cone?
-	const Real radialDistanceSq = (evaluationPos - PCDCenter).getLengthSquared();
-	const Real PCDRadiusSq = PCDRadius * PCDRadius;
-	if (radialDistanceSq >= PCDRadiusSq)
-		return false;
+	// 2. a function within a projective circular sample disc (PCD) through each leaf center
 
 	// ray kernel falling off from cone start towards end center or
 	// ray kernel centered at cut cone center / falling of from cut cone center towards cut cone end and towards cut cone start?
 	Real Z;
-	Real z;
 	Real normFactor;
 	if (EMPTINESS == dataType)
 	{
 		Z = viewCone.getLength();
-		z = tCutCone * Z;
 		normFactor = 1.0f;
 	}
-	else if (SAMPLENESS == dataType)
+	else
 	{
-		const Real tCentered = fabsr(tCutCone - 0.5f) * 2.0f;
 		Z = 0.5f * viewCone.getLength();
-		z = tCentered * Z;
 		normFactor = 0.5f;
 	}
 
-	// 3D view cone kernel value consists of
-	// kernel along ray & kernel within PCD (projective circular disc) 
-	const Real rayKernelValue = computeRayKernel(z, Z) * normFactor;
-	const Real PCDKernelValue = computeCircularDiscKernelFromSquared(radialDistanceSq, PCDRadius);
-	const Real kernelValue = rayKernelValue * PCDKernelValue;
-	if (EPSILON > kernelValue)
-		return false;
-	
-	// final kernel value
-	Real scaledKernel = sampleConfidence * kernelValue;
-	if (EPSILON > scaledKernel)
-		return false;
+	// gather kernel arguments for all leaves
+	const Vector3 &viewToEnd = viewCone.getApexToEnd();
+	Real distancesAlongRay[KERNEL_BLOCK_SIZE];
+	Real radialDistancesSq[KERNEL_BLOCK_SIZE];
+	Real PCDRadii[KERNEL_BLOCK_SIZE];
+
+	for (uint32 localIdx = 0; localIdx < count; ++localIdx)
+	{
+		// where does the plane <x - evaluationPos, sampleNormal> = 0 intersect the view line?
+		const Vector3 &evaluationPos = leafCenters[localIdx];
+		const Real tCompleteCone = viewCone.getTCompleteCone(evaluationPos);
+		const Real tCutCone = viewCone.getTCutCone(tCompleteCone);
+
+		// is positionWS in front of or behind the view cone? -> zero sized PCD for a zero kernel value
+		if (tCutCone < 0.0f|| tCutCone >= 1.0f)
+		{
+			distancesAlongRay[localIdx] = 0.0f;
+			radialDistancesSq[localIdx] = 0.0f;
+			PCDRadii[localIdx] = 0.0f;
+			continue;
+		}
 
-	if (negative)
-		scaledKernel = -scaledKernel;
+		// => via z: get the projective circular disc (PCD) around the view ray which is parallel to the sample normal and goes through positionWS
+		// (PCD = projection of the circular sample disc (CSD) (CSD: centered at sample, orthogonal to sample normal, size = maxEndConeRadius)
+		const Vector3 PCDCenter = viewCone.getApex() + viewToEnd * tCompleteCone;
+		PCDRadii[localIdx] = viewCone.getEndRadius() * tCompleteCone;
+		radialDistancesSq[localIdx] = (evaluationPos - PCDCenter).getLengthSquared();
+
+		if (EMPTINESS == dataType)
+			distancesAlongRay[localIdx] = tCutCone * Z;
+		else
+			distancesAlongRay[localIdx] = fabsr(tCutCone - 0.5f) * 2.0f * Z;
+	}
+
+	// 3D view cone kernel values consist of
+	// kernel along ray & kernel within PCD (projective circular disc)
+	Real kernelValues[KERNEL_BLOCK_SIZE];
+	computeConeKernels(kernelValues, distancesAlongRay, radialDistancesSq, PCDRadii, count, Z);
 
 	// update global variables
-	#pragma omp atomic
-		targetKernelSum += scaledKernel;
-	return true;
+	Real *kernelSums = mKernelSums[dataType];
+	Real *coneLengths = mConeLengths[dataType];
+	const NodeStateFlag leafFlag = (EMPTINESS == dataType ? NODE_FLAG_EMPTINESS : NODE_FLAG_SAMPLENESS);
+
+	for (uint32 localIdx = 0; localIdx < count; ++localIdx)
+	{
+		const Real kernelValue = kernelValues[localIdx] * normFactor;
+		if (EPSILON > kernelValue)
+			continue;
+
+		// final kernel value
+		Real scaledKernel = sampleConfidence * kernelValue;
+		if (EPSILON > scaledKernel)
+			continue;
+
+		if (negative)
+			scaledKernel = -scaledKernel;
+
+		// update sums of kernels & lengths
+		const uint32 leafIdx = leafIndices[localIdx];
+		if (mFixedKernelSums)
+		{
+			mFixedKernelSums[leafIdx].add(scaledKernel);
+			mFixedConeLengths[leafIdx].add(weightedConeLength);
+		}
+		else
+		{
+			#pragma omp atomic
+				kernelSums[leafIdx] += scaledKernel;
+			#pragma omp atomic
+				coneLengths[leafIdx] += weightedConeLength;
+		}
+
+		if (!negative)
+			mNodeStates[nodeIndices[localIdx]] |= leafFlag;
+	}
+}
+
+void Occupancy::computeConeKernels(Real *kernelValues, const Real *zs, const Real *r2s, const Real *Rs, const uint32 count, const Real Z)
+{
+	uint32 localIdx = 0;
+
+	#if defined(SIMD_REAL_WIDTH) && defined(CONE_RAY_KERNEL_NEG_PARABLE) && defined(CONE_PCD_KERNEL_NEG_PARABLE)
+	if (sizeof(Real) == sizeof(float))
+	{
+		// constants of both negative parables
+		const SIMD::Vector zero = SIMD::set(0.0f);
+		const SIMD::Vector one = SIMD::set(1.0f);
+		const SIMD::Vector vZ = SIMD::set(Z);
+		const SIMD::Vector inverseZ2 = SIMD::set(1.0f / (Z * Z));
+		const SIMD::Vector rayFactor = SIMD::set(3.0f / (2.0f * Z));
+		const SIMD::Vector discFactor = SIMD::set(2.0f / PI);
+
+		// padded lanes of the last block: R = 0 -> masked out
+		float paddedZs[SIMD_REAL_WIDTH];
+		float paddedR2s[SIMD_REAL_WIDTH];
+		float paddedRs[SIMD_REAL_WIDTH];
+		float paddedKernelValues[SIMD_REAL_WIDTH];
+
+		// all leaves in blocks, the last one padded so that every leaf goes through the same lane code
+		for (; localIdx < count; localIdx += SIMD_REAL_WIDTH)
+		{
+			const uint32 laneCount = min<uint32>(SIMD_REAL_WIDTH, count - localIdx);
+			const float *blockZs = (const float *) (zs + localIdx);
+			const float *blockR2s = (const float *) (r2s + localIdx);
+			const float *blockRs = (const float *) (Rs + localIdx);
+			float *blockKernelValues = (float *) (kernelValues + localIdx);
+
+			if (laneCount < SIMD_REAL_WIDTH)
+			{
+				for (uint32 laneIdx = 0; laneIdx < SIMD_REAL_WIDTH; ++laneIdx)
+				{
+					const bool valid = (laneIdx < laneCount);
+					paddedZs[laneIdx] = (valid ? blockZs[laneIdx] : 0.0f);
+					paddedR2s[laneIdx] = (valid ? blockR2s[laneIdx] : 0.0f);
+					paddedRs[laneIdx] = (valid ? blockRs[laneIdx] : 0.0f);
+				}
+
+				blockZs = paddedZs;
+				blockR2s = paddedR2s;
+				blockRs = paddedRs;
+				blockKernelValues = paddedKernelValues;
+			}
+
+			const SIMD::Vector z = SIMD::load(blockZs);
+			const SIMD::Vector r2 = SIMD::load(blockR2s);
+			const SIMD::Vector R = SIMD::load(blockRs);
+			const SIMD::Vector R2 = SIMD::mul(R, R);
+
+			// ray kernel: (3 / (2Z)) * (1 - z^2 / Z^2) within [0, Z)
+			const SIMD::Vector rayKernel = SIMD::mul(rayFactor, SIMD::sub(one, SIMD::mul(SIMD::mul(z, z), inverseZ2)));
+			const SIMD::Mask onRay = SIMD::both(SIMD::isGreaterEqual(z, zero), SIMD::isLess(z, vZ));
+
+			// PCD kernel: (2 / (PI * R^2)) * (1 - r^2 / R^2) within [0, R)
+			// (R2 is only zero for invalid or padded lanes which are masked out afterwards)
+			const SIMD::Vector discKernel = SIMD::mul(SIMD::div(discFactor, R2), SIMD::sub(one, SIMD::div(r2, R2)));
+			const SIMD::Mask inDisc = SIMD::isLess(r2, R2);
+
+			const SIMD::Vector kernel = SIMD::mul(rayKernel, discKernel);
+			SIMD::store(blockKernelValues, SIMD::select(SIMD::both(onRay, inDisc), kernel, zero));
+
+			// copy the valid lanes of the padded block
+			if (laneCount < SIMD_REAL_WIDTH)
+				for (uint32 laneIdx = 0; laneIdx < laneCount; ++laneIdx)
+					kernelValues[localIdx + laneIdx] = paddedKernelValues[laneIdx];
+		}
+	}
+	#endif // SIMD_REAL_WIDTH && CONE_RAY_KERNEL_NEG_PARABLE && CONE_PCD_KERNEL_NEG_PARABLE
+
+	// other kernel functions or no SIMD support
+	for (; localIdx < count; ++localIdx)
+	{
+		// is the leaf center within PCD and view cone?
+		const Real r2 = r2s[localIdx];
+		const Real R = Rs[localIdx];
+		if (r2 >= R * R)
+		{
+			kernelValues[localIdx] = 0.0f;
+			continue;
+		}
+
+		const Real rayKernelValue = computeRayKernel(zs[localIdx], Z);
+		const Real PCDKernelValue = computeCircularDiscKernelFromSquared(r2, R);
+		kernelValues[localIdx] = rayKernelValue * PCDKernelValue;
+	}
 }
 
 Real SurfaceReconstruction::Occupancy::computeCircularDiscKernelFromSquared(const Real r2, const Real R)
@@ -488,6 +651,62 @@ bool Occupancy::isEmpty(const uint32 leafIdx) const
 	return (pOfXAndCE > pOfXAndCS);
 }
 
+uint32 Occupancy::updateEmptyNodeStates()
+{
+	// get leaves
+	const Tree &tree = *Scene::getSingleton().getTree();
+	const Leaves &leaves = tree.getLeaves();
+	const int64 leafCount = leaves.getCount();
+	uint32 emptyLeafCount = 0;
+
+	// leaves -> flag is directly defined by the current occupancy classification
+	#pragma omp parallel for reduction(+:emptyLeafCount)
+	for (int64 i = 0; i < leafCount; ++i)
+	{
+		const uint32 leafIdx = (uint32) i;
+		uint32 &state = mNodeStates[leaves.getScope(leafIdx).getNodeIndex()];
+
+		if (!isEmpty(leafIdx))
+		{
+			state &= ~NODE_FLAG_EMPTY;
+			continue;
+		}
+
+		state |= NODE_FLAG_EMPTY;
+		++emptyLeafCount;
+	}
+
+	// inner nodes
+	forwardAllChildrenStateFlag(0, NODE_FLAG_EMPTY);
+	return emptyLeafCount;
+}
+
+uint32 Occupancy::forwardAllChildrenStateFlag(const uint32 nodeIdx, const NodeStateFlag flag)
+{
+	// get nodes
+	const Tree &tree = *Scene::getSingleton().getTree();
+	const Nodes &nodes = tree.getNodes();
+	uint32 &state = mNodeStates[nodeIdx];
+	
+	// leaf -> flag is directly defined by some condition based on flag
+	if (nodes.isLeaf(nodeIdx))
+		return state;
+	
+	// an inner node only gets the flag set if all of its children have the flag set
+	state |= flag;
+
+	const uint32 firstChild = nodes.getChildBlock(nodeIdx);
+	for (uint32 childOffset = 0; childOffset < Nodes::CHILD_COUNT; ++childOffset)
+	{
+		const uint32 childIdx = firstChild + childOffset;
+		const uint32 childState = forwardAllChildrenStateFlag(childIdx, flag);
+		if (!(flag & childState))
+			state &= ~flag;
+	}
+	
+	return state;
+}
+
 uint32 Occupancy::forwardAnyChildStateFlag(const uint32 nodeIdx, const NodeStateFlag flag)
 {
 	// get nodes
@@ -535,6 +754,8 @@ void Occupancy::computePriors()
 	const uint32 leafCount = leaves.getCount();
 
 	cout << "Computing occupancy class priors.\n" << endl;
+	StageProfiler::Scope profilerScope("Priors", "leaves");
+	profilerScope.addItems(leafCount);
 
 	// class priors for each leaf (scene-varying semi global Bayesian class priors)
 	#pragma omp parallel for schedule(dynamic, OMP_PRIOR_LEAF_BATCH_SIZE)
@@ -604,7 +825,10 @@ Occupancy::Occupancy(const Path &fileName) :
 
 Occupancy::Occupancy() :
 	mCrust(NULL),
+	mMappedFile(NULL),
 	mPriorsForEmptiness(NULL),
+	mFixedConeLengths(NULL),
+	mFixedKernelSums(NULL),
 	mNodeStates(NULL),
 	mConfidenceThreshold(EPSILON),
 	mBandwidthFactor(1.0f)
@@ -672,6 +896,14 @@ void Occupancy::loadFromFile(const Path &fileName)
 	if (0 == leafCount)
 		return;
 
+	// page aligned format which can be used in place?
+	if (MappedFile::isMappedFile(fileName))
+	{
+		loadFromMappedFile(fileName);
+		cout << "Finished occupancy data loading." << endl;
+		return;
+	}
+
 	// open file
 	File file(fileName, File::OPEN_READING, true, FILE_VERSION);
 
@@ -719,6 +951,33 @@ void Occupancy::loadFromFile(const Path &fileName)
 	cout << "Finished occupancy data loading." << endl;
 }
 
+void Occupancy::loadFromMappedFile(const Path &fileName)
+{
+	// get leaf & node count
+	const Tree &tree = *Scene::getSingleton().getTree();
+	const uint32 leafCount = tree.getLeaves().getCount();
+	const uint32 nodeCount = tree.getNodes().getCount();
+
+	// map file & check header data
+	mMappedFile = new MappedFile(fileName, FILE_VERSION);
+	const uint32 *countsInFile = mMappedFile->getSection<uint32>(0, 2);
+	if (leafCount != countsInFile[0] || nodeCount != countsInFile[1])
+		throw FileCorruptionException("Invalid occupancy file format.", fileName);
+
+	// use all arrays in place - changing them only creates private copies of the changed pages
+	mConeCount = *mMappedFile->getSection<Real>(1, 1);
+
+	uint32 sectionIdx = 2;
+	for (DataType type = EMPTINESS; type < DATA_TYPE_COUNT; type = (DataType) (type + 1))
+	{
+		mConeLengths[type] = mMappedFile->getSection<Real>(sectionIdx++, leafCount);
+		mKernelSums[type] = mMappedFile->getSection<Real>(sectionIdx++, leafCount);
+	}
+
+	mPriorsForEmptiness = mMappedFile->getSection<Real>(sectionIdx++, leafCount);
+	mNodeStates = mMappedFile->getSection<uint32>(sectionIdx++, nodeCount);
+}
+
 void Occupancy::saveToFile(const Path &fileName) const
 {
 	cout << "Saving occupancy to file." << endl;
@@ -733,6 +992,29 @@ void Occupancy::saveToFile(const Path &fileName) const
 		if(!mKernelSums[type])
 			return;
 
+	// page aligned format which can be used in place when it is loaded?
+	if (MappedFile::isSavingEnabled())
+	{
+		const uint64 leavesBytes = sizeof(Real) * counts[0];
+		const void *sections[] =
+		{
+			counts, &mConeCount,
+			mConeLengths[EMPTINESS], mKernelSums[EMPTINESS],
+			mConeLengths[SAMPLENESS], mKernelSums[SAMPLENESS],
+			mPriorsForEmptiness, mNodeStates
+		};
+		const uint64 byteCounts[] =
+		{
+			sizeof(uint32) * 2, sizeof(Real),
+			leavesBytes, leavesBytes,
+			leavesBytes, leavesBytes,
+			leavesBytes, sizeof(uint32) * counts[1]
+		};
+
+		MappedFile::save(fileName, FILE_VERSION, sections, byteCounts, 8);
+		return;
+	}
+
 	// create the file
 	File file(fileName, File::CREATE_WRITING, true, FILE_VERSION);
 	
@@ -769,18 +1051,30 @@ void Occupancy::clear()
 {
 	// free memory & invalidate pointers
 	delete mCrust;
-	delete [] mNodeStates;
-	delete [] mPriorsForEmptiness;
-
 	mCrust = NULL;
+
+	// arrays are either owned by the mapped file or allocated
+	if (mMappedFile)
+	{
+		delete mMappedFile;
+		mMappedFile = NULL;
+	}
+	else
+	{
+		delete [] mNodeStates;
+		delete [] mPriorsForEmptiness;
+		for (DataType type = EMPTINESS; type < DATA_TYPE_COUNT; type = (DataType) (type + 1))
+		{
+			delete [] mConeLengths[type];
+			delete [] mKernelSums[type];
+		}
+	}
+
 	mNodeStates = NULL;
 	mPriorsForEmptiness = NULL;
 
 	for (DataType type = EMPTINESS; type < DATA_TYPE_COUNT; type = (DataType) (type + 1))
 	{
-		delete [] mConeLengths[type];
-		delete [] mKernelSums[type];
-
 		mConeLengths[type] = NULL;
 		mKernelSums[type] = NULL;
 	}
@@ -21,6 +21,8 @@ namespace SurfaceReconstruction
 {		
 	// forward declarations
 	class DualMarchingCells;
+	class FixedPointSum;
+	class MappedFile;
 	class Tree;
 
 	class Occupancy
@@ -36,8 +38,8 @@ namespace SurfaceReconstruction
 		enum NodeStateFlag
 		{
 			NODE_FLAG_SAMPLENESS	= 0x1 << 0,	/// Flag is set for leaves the center of which overlaps with a sample and inner nodes which have any child with that flag set.
-			NODE_FLAG_EMPTINESS		= 0x1 << 1	/// Flag is set for leaves the center of which overlaps with a view cone and inner nodes which have any child with that flag set.
-			//NODE_FLAG_EMPTY			= 0x1 << 2,	/// Flag is set for leaves with isEmpty(leafIdx) and for all inner nodes which only have empty children.
+			NODE_FLAG_EMPTINESS		= 0x1 << 1,	/// Flag is set for leaves the center of which overlaps with a view cone and inner nodes which have any child with that flag set.
+			NODE_FLAG_EMPTY			= 0x1 << 2	/// Flag is set for leaves with isEmpty(leafIdx) and for all inner nodes which only have empty children. (See updateEmptyNodeStates.)
 			//NODE_FLAG_ANY_EMPTY		= 0x1 << 3	/// Flag is set for leaves with isEmpty(leafIdx) and for all inner nodes which have any empty child.
 		};
 
@@ -50,10 +52,6 @@ namespace SurfaceReconstruction
 		Occupancy(const Tree *tree);
 		~Occupancy();
 		
-		bool addKernel(Real &target,
-			const Math::Vector3 &leafCenter, const CollisionDetection::ObliqueCircularCone &viewCone, 
-			const DataType type, const Real sampleConfidence, const bool negative) const;
-
 		inline void addSamples(const uint32 *chosenSamples, const uint32 count);
 		void computePriors();
 		inline void eraseSamples(const uint32 *doomedSamples, const uint32 count);
@@ -88,14 +86,29 @@ namespace SurfaceReconstruction
 		void outputEdgeConflicts() const;
 
 		void saveToFile(const Storage::Path &fileName) const;
+
+		/** Sets NODE_FLAG_EMPTY for all leaves which are currently classified as empty and for all inner nodes which only have empty children and clears it for all other nodes.
+		@return Returns the number of empty leaves. */
+		uint32 updateEmptyNodeStates();
 		
 	private:
 		static Real computeCircularDiscKernelFromSquared(const Real distanceToDiscCenterSquared, const Real discRadius);
+		static void computeConeKernels(Real *kernelValues, const Real *distancesAlongRay, const Real *distancesToDiscCentersSquared,
+			const Real *discRadii, const uint32 count, const Real viewConeLength);
 		static Real computeRayKernel(const Real distanceAlongRay, const Real viewConeLength);
 
 	private:
 		Occupancy();
 
+		/** Evaluates the kernel of viewCone for a block of leaves at once and adds the scaled kernel values to the kernel sums of these leaves.
+			Leaves which get a kernel value also get weightedConeLength added to their cone lengths and, if !negative, dataType's state flag set.
+		@param leafIndices Set this to count leaves which overlap with viewCone.
+		@param nodeIndices Set this to the node indices of the count leaves of leafIndices.
+		@param leafCenters Set this to the world space centers of the count leaves of leafIndices. */
+		void addKernels(const uint32 *leafIndices, const uint32 *nodeIndices, const Math::Vector3 *leafCenters, const uint32 count,
+			const CollisionDetection::ObliqueCircularCone &viewCone, const DataType dataType,
+			const Real sampleConfidence, const Real weightedConeLength, const bool negative);
+
 		/** Copy constructor is forbidden. Don't use it. */
 		inline Occupancy(const Occupancy &other);
 
@@ -106,6 +119,7 @@ namespace SurfaceReconstruction
 
 		void computeOccupancy();
 		
+		uint32 forwardAllChildrenStateFlag(const uint32 nodeIdx, const NodeStateFlag flag);
 		uint32 forwardAnyChildStateFlag(const uint32 nodeIdx, const NodeStateFlag flag);
 
 		uint32 getMaxDepth(const uint32 sampleIndex) const;
@@ -120,6 +134,9 @@ namespace SurfaceReconstruction
 		void initializeSampleness();
 
 		void loadFromFile(const Storage::Path &fileName);
+
+		/** Uses the arrays of a mapped occupancy file in place. (See MappedFile.) */
+		void loadFromMappedFile(const Storage::Path &fileName);
 		
 		void onSamplesChanged(const bool remove, const uint32 *sampleIndices, const uint32 indexCount);
 		
@@ -128,6 +145,7 @@ namespace SurfaceReconstruction
 
 	public:
 		static const uint32 FILE_VERSION;
+		static const uint32 KERNEL_BLOCK_SIZE;
 		static const uint32 MAX_DEPTH_DIFFERENCE;
 		static const uint32 OMP_PRIOR_LEAF_BATCH_SIZE;
 		static const uint32 OMP_SAMPLE_BATCH_SIZE;
@@ -135,11 +153,15 @@ namespace SurfaceReconstruction
 
 	private:
 		DualMarchingCells *mCrust;				/// This is used to get a coarse scene approximation from free space computations. It is later refined.
+		MappedFile *mMappedFile;				/// Owns the memory of all leaf and node arrays if they were loaded from a mapped file. Otherwise NULL.
 		
 		Real *mConeLengths[DATA_TYPE_COUNT];
 		Real *mKernelSums[DATA_TYPE_COUNT];
 		Real *mPriorsForEmptiness;
 
+		FixedPointSum *mFixedConeLengths;		/// Order independent cone length changes of all leaves. Only allocated during updateKernels in deterministic reductions mode.
+		FixedPointSum *mFixedKernelSums;		/// Order independent kernel sum changes of all leaves. Only allocated during updateKernels in deterministic reductions mode.
+
 		uint32 *mNodeStates;
 
 		Real mConeCount;